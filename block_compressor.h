@@ -0,0 +1,656 @@
+// Copyright (c) Tamas Csala
+
+/** @file block_compressor.h
+    @brief Implements encoding mipmap chains to BC1, BC3, BC4 and BC5 on the
+           CPU, and caching the results in DDS files.
+*/
+
+#ifndef OGLWRAP_BLOCK_COMPRESSOR_H_
+#define OGLWRAP_BLOCK_COMPRESSOR_H_
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+
+#include "./config.h"
+#include "./simd_ops.h"
+#include "./mip_chain.h"
+#include "./thread_pool.h"
+#include "textures/texture_2D.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/// Writes dot(color - origin, axis) of the colors to out, from *index, while
+/// a full SIMD batch fits before count.
+template <typename Ops>
+inline void ProjectColorsWith(const float* red, const float* green,
+                              const float* blue, const float* origin,
+                              const float* axis, size_t* index, size_t count,
+                              float* out) {
+  typedef typename Ops::Float Float;
+  Float origin_r = Ops::Splat(origin[0]), axis_r = Ops::Splat(axis[0]);
+  Float origin_g = Ops::Splat(origin[1]), axis_g = Ops::Splat(axis[1]);
+  Float origin_b = Ops::Splat(origin[2]), axis_b = Ops::Splat(axis[2]);
+  size_t i = *index;
+  for (; i + Ops::kWidth <= count; i += Ops::kWidth) {
+    Float t = Ops::Mul(Ops::Sub(Ops::Load(red + i), origin_r), axis_r);
+    t = Ops::Add(t, Ops::Mul(Ops::Sub(Ops::Load(green + i), origin_g),
+                             axis_g));
+    t = Ops::Add(t, Ops::Mul(Ops::Sub(Ops::Load(blue + i), origin_b),
+                             axis_b));
+    Ops::Store(out + i, t);
+  }
+  *index = i;
+}
+
+/// Writes dot(color - origin, axis) of count colors to out.
+inline void ProjectColors(const float* red, const float* green,
+                          const float* blue, const float* origin,
+                          const float* axis, size_t count, float* out) {
+  size_t index = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  ProjectColorsWith<SimdFloatOps>(red, green, blue, origin, axis, &index,
+                                  count, out);
+#endif
+  ProjectColorsWith<ScalarFloatOps>(red, green, blue, origin, axis, &index,
+                                    count, out);
+}
+
+/// Adds the sums of the colors, and of their products (r, g, b, rr, rg, rb,
+/// gg, gb, bb) to sums, from *index, while a full SIMD batch fits before
+/// count.
+template <typename Ops>
+inline void SumMomentsWith(const float* red, const float* green,
+                           const float* blue, size_t* index, size_t count,
+                           float* sums) {
+  typedef typename Ops::Float Float;
+  Float moments[9];
+  for (Float& moment : moments) {
+    moment = Ops::Splat(0.0f);
+  }
+  size_t i = *index;
+  for (; i + Ops::kWidth <= count; i += Ops::kWidth) {
+    Float r = Ops::Load(red + i), g = Ops::Load(green + i),
+          b = Ops::Load(blue + i);
+    moments[0] = Ops::Add(moments[0], r);
+    moments[1] = Ops::Add(moments[1], g);
+    moments[2] = Ops::Add(moments[2], b);
+    moments[3] = Ops::Add(moments[3], Ops::Mul(r, r));
+    moments[4] = Ops::Add(moments[4], Ops::Mul(r, g));
+    moments[5] = Ops::Add(moments[5], Ops::Mul(r, b));
+    moments[6] = Ops::Add(moments[6], Ops::Mul(g, g));
+    moments[7] = Ops::Add(moments[7], Ops::Mul(g, b));
+    moments[8] = Ops::Add(moments[8], Ops::Mul(b, b));
+  }
+  *index = i;
+  float lanes[Ops::kWidth];
+  for (size_t moment = 0; moment < 9; ++moment) {
+    Ops::Store(lanes, moments[moment]);
+    for (size_t lane = 0; lane < Ops::kWidth; ++lane) {
+      sums[moment] += lanes[lane];
+    }
+  }
+}
+
+/// Writes the sums of count colors, and of their products (r, g, b, rr, rg,
+/// rb, gg, gb, bb) to sums.
+inline void SumMoments(const float* red, const float* green,
+                       const float* blue, size_t count, float* sums) {
+  std::fill(sums, sums + 9, 0.0f);
+  size_t index = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  SumMomentsWith<SimdFloatOps>(red, green, blue, &index, count, sums);
+#endif
+  SumMomentsWith<ScalarFloatOps>(red, green, blue, &index, count, sums);
+}
+
+/**
+ * @brief A mipmap chain encoded to a block compressed format on the CPU.
+ *
+ * Compressing offline (or once, and caching the result) instead of passing
+ * a generic compressed internal format to the driver makes the load times
+ * and the quality independent of the driver.
+ * @code
+ *   gl::MipChain mips = gl::MipChain::Generate(pixels, width, height, 4,
+ *                                              options, &pool);
+ *   gl::CompressedMipChain bc3 = gl::CompressedMipChain::Encode(
+ *       mips, gl::CompressedMipChain::Format::kBc3, true, &pool);
+ *   bc3.write(gl::CompressedMipChain::CacheFile(file, ...));
+ *   bc3.upload(texture);
+ * @endcode
+ * BC1 and BC3 color endpoints are fit along the principal axis of the
+ * texels of the block, and refined with least squares. The projections of
+ * the texels are computed with SIMD, and the block rows of a level can be
+ * split between the threads of a ThreadPool.
+ *
+ * Written files are DDS files with a DX10 header, so they can be read with
+ * TextureContainer.
+ */
+class CompressedMipChain {
+ public:
+  /// The block compressed formats.
+  enum class Format {
+    kBc1,  ///< RGB, 4 bits per texel.
+    kBc3,  ///< RGBA, 8 bits per texel.
+    kBc4,  ///< The first channel, 4 bits per texel.
+    kBc5,  ///< The first two channels, 8 bits per texel.
+  };
+
+  /// The size and location of a level in data().
+  struct Level {
+    GLsizei width;
+    GLsizei height;
+    size_t offset;
+    size_t size;
+  };
+
+  /// Creates an empty chain.
+  CompressedMipChain() : format_(0) {}
+
+  /**
+   * @brief Encodes every level of a mipmap chain.
+   *
+   * Images with less than 3 channels are encoded to BC1 and BC3 as gray.
+   * The alpha of BC3 is the last channel of 2 and 4 channel images, and
+   * opaque otherwise.
+   *
+   * @param mips    The levels to encode.
+   * @param format  The block compressed format.
+   * @param srgb    If the colors are sRGB encoded (only used by BC1 and BC3).
+   * @param pool    The threads to split the block rows between, or nullptr
+   *                to encode on the calling thread.
+   */
+  static CompressedMipChain Encode(const MipChain& mips, Format format,
+                                   bool srgb = false,
+                                   ThreadPool* pool = nullptr) {
+    CompressedMipChain chain;
+    chain.format_ = InternalFormat(format, srgb);
+    size_t offset = 0;
+    for (const MipChain::Level& level : mips.levels()) {
+      size_t size = BlockCount(level.width) * BlockCount(level.height) *
+                    BlockBytes(format);
+      chain.levels_.push_back(Level{level.width, level.height, offset, size});
+      offset += size;
+    }
+    chain.data_.resize(offset);
+    for (GLsizei i = 0; i < mips.levelCount(); ++i) {
+      chain.encodeLevel(mips, i, format, pool);
+    }
+    return chain;
+  }
+
+  /// Returns the levels.
+  const std::vector<Level>& levels() const { return levels_; }
+
+  /// Returns the number of levels.
+  GLsizei levelCount() const { return GLsizei(levels_.size()); }
+
+  /// Returns the compressed internal format of the levels.
+  GLenum format() const { return format_; }
+
+  /// Returns the encoded blocks of a level.
+  const unsigned char* data(GLsizei level) const {
+    return data_.data() + levels_[level].offset;
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glTexStorage2D) && defined(glCompressedTexSubImage2D))
+  /// Uploads every level to the texture, that has to be bound.
+  template <Texture2DType texture_t>
+  void upload(Texture2DBase<texture_t>& texture) const {
+    if (levels_.empty()) {
+      return;
+    }
+    texture.storage(levelCount(), format_, levels_[0].width,
+                    levels_[0].height);
+    for (GLsizei i = 0; i < levelCount(); ++i) {
+      texture.compressedSubUploadMipmap(i, 0, 0, levels_[i].width,
+                                        levels_[i].height, format_,
+                                        GLsizei(levels_[i].size), data(i));
+    }
+  }
+#endif  // glTexStorage2D && glCompressedTexSubImage2D
+
+  /// Writes the chain to a DDS file.
+  /** The file is written under a temporary name, and renamed at the end, so
+    * a concurrent reader never sees a partial file.
+    * @return If the file could be written. */
+  bool write(const std::string& file) const {
+    if (levels_.empty()) {
+      return false;
+    }
+    uint32_t header[32 + 5] = {0};
+    header[0] = FourCC("DDS ");
+    header[1] = 124;                      // size of the header
+    header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;  // flags
+    header[3] = uint32_t(levels_[0].height);
+    header[4] = uint32_t(levels_[0].width);
+    header[5] = uint32_t(levels_[0].size);  // linear size
+    header[7] = uint32_t(levels_.size());
+    header[19] = 32;                      // size of the pixel format
+    header[20] = 0x4;                     // DDPF_FOURCC
+    header[21] = FourCC("DX10");
+    header[27] = 0x1000 | 0x400000 | 0x8;  // texture, mipmap, complex
+    header[32] = DxgiFormat(format_);
+    header[33] = 3;                       // DIMENSION_TEXTURE2D
+    header[35] = 1;                       // array size
+
+    std::ostringstream temporary;
+    temporary << file << '.' << std::this_thread::get_id() << ".tmp";
+    {
+      std::ofstream stream(temporary.str(), std::ios::binary);
+      stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+      stream.write(reinterpret_cast<const char*>(data_.data()),
+                   std::streamsize(data_.size()));
+      if (!stream) {
+        stream.close();
+        std::remove(temporary.str().c_str());
+        return false;
+      }
+    }
+    if (std::rename(temporary.str().c_str(), file.c_str()) != 0) {
+      std::remove(temporary.str().c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /// Returns the path of the cache file of an image, next to the image.
+  /** The name contains a hash of the contents of the image file, and of the
+    * settings of the encoding, so a changed image or different settings
+    * never reuse a stale cache file.
+    * @return The path, or an empty string if the image can't be read. */
+  static std::string CacheFile(const std::string& image_file, Format format,
+                               bool srgb, const MipChain::Options& options) {
+    std::ifstream stream(image_file, std::ios::binary);
+    if (!stream) {
+      return std::string();
+    }
+    uint64_t hash = 0xcbf29ce484222325ull, bytes = 0;
+    std::vector<char> buffer(1 << 16);
+    while (stream) {
+      stream.read(buffer.data(), std::streamsize(buffer.size()));
+      size_t count = size_t(stream.gcount());
+      bytes += count;
+      // The tail of the last read is hashed as a zero padded word, the size
+      // of the file tells apart the files, that only differ in trailing
+      // zero bytes.
+      std::memset(buffer.data() + count, 0, (8 - count % 8) % 8);
+      for (size_t i = 0; i < count; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, buffer.data() + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+      }
+    }
+    uint64_t settings[] = {
+      bytes, kVersion, uint64_t(format), srgb, uint64_t(options.filter),
+      options.srgb, options.preserve_alpha_coverage,
+      uint64_t(options.alpha_cutoff * 65536.0f), options.wrap,
+      uint64_t(options.max_levels)
+    };
+    for (uint64_t word : settings) {
+      hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    char name[24];
+    std::snprintf(name, sizeof(name), ".%016llx.dds",
+                  static_cast<unsigned long long>(hash));
+    return image_file + name;
+  }
+
+ private:
+  // Changing the encoders or the hash of CacheFile should change this, to
+  // invalidate the old caches.
+  static constexpr uint64_t kVersion = 2;
+
+  std::vector<unsigned char> data_;
+  std::vector<Level> levels_;
+  GLenum format_;
+
+  static size_t BlockCount(GLsizei size) { return (size_t(size) + 3) / 4; }
+
+  static size_t BlockBytes(Format format) {
+    return format == Format::kBc1 || format == Format::kBc4 ? 8 : 16;
+  }
+
+  static uint32_t FourCC(const char* code) {
+    return uint32_t(code[0]) | uint32_t(code[1]) << 8 |
+           uint32_t(code[2]) << 16 | uint32_t(code[3]) << 24;
+  }
+
+  // The GL enums of the compression extensions, so they don't have to be in
+  // the loaded GL header.
+  static GLenum InternalFormat(Format format, bool srgb) {
+    switch (format) {
+      case Format::kBc1: return srgb ? 0x8C4D : 0x83F1;
+      case Format::kBc3: return srgb ? 0x8C4F : 0x83F3;
+      case Format::kBc4: return 0x8DBB;
+      default: return 0x8DBD;
+    }
+  }
+
+  static uint32_t DxgiFormat(GLenum format) {
+    switch (format) {
+      case 0x83F1: return 71;  // BC1_UNORM
+      case 0x8C4D: return 72;  // BC1_UNORM_SRGB
+      case 0x83F3: return 77;  // BC3_UNORM
+      case 0x8C4F: return 78;  // BC3_UNORM_SRGB
+      case 0x8DBB: return 80;  // BC4_UNORM
+      default: return 83;      // BC5_UNORM
+    }
+  }
+
+  // The texels of a block, with the edge texels repeated for partial blocks.
+  struct Block {
+    float red[16], green[16], blue[16], alpha[16];
+  };
+
+  static void Load(const unsigned char* pixels, const MipChain::Level& level,
+                   unsigned channels, size_t block_x, size_t block_y,
+                   Block* block) {
+    size_t columns[4];
+    for (size_t x = 0; x < 4; ++x) {
+      columns[x] = std::min(block_x * 4 + x, size_t(level.width) - 1)
+                   * channels;
+    }
+    for (size_t y = 0; y < 4; ++y) {
+      const unsigned char* row = pixels + level.row_stride *
+          std::min(block_y * 4 + y, size_t(level.height) - 1);
+      for (size_t x = 0; x < 4; ++x) {
+        const unsigned char* texel = row + columns[x];
+        size_t i = y * 4 + x;
+        switch (channels) {
+          case 1:
+            block->red[i] = block->green[i] = block->blue[i] = texel[0];
+            block->alpha[i] = 255.0f;
+            break;
+          case 2:
+            block->red[i] = block->green[i] = block->blue[i] = texel[0];
+            block->alpha[i] = texel[1];
+            break;
+          case 3:
+            block->red[i] = texel[0];
+            block->green[i] = texel[1];
+            block->blue[i] = texel[2];
+            block->alpha[i] = 255.0f;
+            break;
+          default:
+            block->red[i] = texel[0];
+            block->green[i] = texel[1];
+            block->blue[i] = texel[2];
+            block->alpha[i] = texel[3];
+            break;
+        }
+      }
+    }
+  }
+
+  void encodeLevel(const MipChain& mips, GLsizei level, Format format,
+                   ThreadPool* pool) {
+    const Level& info = levels_[level];
+    size_t blocks_x = BlockCount(info.width);
+    size_t blocks_y = BlockCount(info.height);
+    const unsigned char* pixels = mips.data(level);
+    unsigned char* out = data_.data() + info.offset;
+    size_t block_bytes = BlockBytes(format);
+
+    auto encode_rows = [&](size_t begin, size_t end) {
+      Block block;
+      for (size_t y = begin; y < end; ++y) {
+        for (size_t x = 0; x < blocks_x; ++x) {
+          unsigned char* blocks = out + (y * blocks_x + x) * block_bytes;
+          Load(pixels, mips.levels()[level], mips.channels(), x, y, &block);
+          switch (format) {
+            case Format::kBc1:
+              EncodeColor(block, blocks);
+              break;
+            case Format::kBc3:
+              EncodeChannel(block.alpha, blocks);
+              EncodeColor(block, blocks + 8);
+              break;
+            case Format::kBc4:
+              EncodeChannel(block.red, blocks);
+              break;
+            case Format::kBc5:
+              EncodeChannel(block.red, blocks);
+              // The second channel of 2 channel images is loaded as alpha.
+              EncodeChannel(mips.channels() == 2 ? block.alpha : block.green,
+                            blocks + 8);
+              break;
+          }
+        }
+      }
+    };
+
+    // A band of block rows should be worth the scheduling overhead.
+    const size_t kMinBlocksPerBand = 256;
+    size_t band_count = 1;
+    if (pool && pool->size() > 1) {
+      band_count = std::min(
+          std::min(blocks_y, pool->size() * 4),
+          std::max<size_t>(1, blocks_y * blocks_x / kMinBlocksPerBand));
+    }
+    if (band_count == 1) {
+      encode_rows(0, blocks_y);
+      return;
+    }
+    pool->run(band_count, [&](size_t band) {
+      encode_rows(band * blocks_y / band_count,
+                  (band + 1) * blocks_y / band_count);
+    });
+  }
+
+  // A BC1 endpoint, as 5:6:5 bits, and expanded to 8 bits.
+  struct Endpoint {
+    uint16_t bits;
+    float color[3];
+  };
+
+  static Endpoint Quantize(const float* color) {
+    auto channel = [](float value, int max) {
+      return int(std::min(std::max(value, 0.0f), 255.0f) * (max / 255.0f)
+                 + 0.5f);
+    };
+    int r = channel(color[0], 31), g = channel(color[1], 63),
+        b = channel(color[2], 31);
+    return Endpoint{uint16_t(r << 11 | g << 5 | b),
+                    {float(r << 3 | r >> 2), float(g << 2 | g >> 4),
+                     float(b << 3 | b >> 2)}};
+  }
+
+  // Chooses the palette entries along the line of the endpoints.
+  // Returns the squared error, and writes the weight of the second endpoint
+  // (0 - 3) of every texel.
+  static float SelectIndices(const Block& block, const Endpoint& first,
+                             const Endpoint& second, int* weights) {
+    float direction[3], axis[3];
+    float length_squared = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+      direction[c] = second.color[c] - first.color[c];
+      length_squared += direction[c] * direction[c];
+    }
+    float t[16];
+    if (length_squared > 0.0f) {
+      // Projects to 0 at the first, and 3 at the second endpoint.
+      for (int c = 0; c < 3; ++c) {
+        axis[c] = direction[c] * 3.0f / length_squared;
+      }
+      ProjectColors(block.red, block.green, block.blue, first.color, axis, 16,
+                    t);
+    } else {
+      std::fill(t, t + 16, 0.0f);
+    }
+
+    float palette[4][3];
+    for (int weight = 0; weight < 4; ++weight) {
+      for (int c = 0; c < 3; ++c) {
+        palette[weight][c] = first.color[c] + direction[c] * weight / 3.0f;
+      }
+    }
+    float error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+      int weight = int(std::min(std::max(t[i] + 0.5f, 0.0f), 3.0f));
+      weights[i] = weight;
+      float dr = palette[weight][0] - block.red[i];
+      float dg = palette[weight][1] - block.green[i];
+      float db = palette[weight][2] - block.blue[i];
+      error += dr * dr + dg * dg + db * db;
+    }
+    return error;
+  }
+
+  // Encodes the colors of a block to BC1 (always in 4 color mode, so it is
+  // also valid as the color block of BC3).
+  static void EncodeColor(const Block& block, unsigned char* out) {
+    const float* channels[3] = {block.red, block.green, block.blue};
+
+    // The principal axis of the colors, with a few power iterations on their
+    // covariance matrix.
+    float sums[9];
+    SumMoments(block.red, block.green, block.blue, 16, sums);
+    float mean[3] = {sums[0] / 16.0f, sums[1] / 16.0f, sums[2] / 16.0f};
+    float covariance[3][3];
+    const int kProduct[3][3] = {{3, 4, 5}, {4, 6, 7}, {5, 7, 8}};
+    for (int a = 0; a < 3; ++a) {
+      for (int b = 0; b < 3; ++b) {
+        covariance[a][b] = sums[kProduct[a][b]] - 16.0f * mean[a] * mean[b];
+      }
+    }
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 4; ++iteration) {
+      float next[3], max = 0.0f;
+      for (int a = 0; a < 3; ++a) {
+        next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] +
+                  covariance[a][2] * axis[2];
+        max = std::max(max, std::abs(next[a]));
+      }
+      if (max == 0.0f) {
+        break;
+      }
+      for (int a = 0; a < 3; ++a) {
+        axis[a] = next[a] / max;
+      }
+    }
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] +
+                             axis[2] * axis[2]);
+    for (int a = 0; a < 3; ++a) {
+      axis[a] /= length;
+    }
+
+    // The endpoints are the extremes of the colors along the axis.
+    float t[16];
+    ProjectColors(block.red, block.green, block.blue, mean, axis, 16, t);
+    float t_min = *std::min_element(t, t + 16);
+    float t_max = *std::max_element(t, t + 16);
+    float color[3];
+    for (int c = 0; c < 3; ++c) {
+      color[c] = mean[c] + axis[c] * t_max;
+    }
+    Endpoint first = Quantize(color);
+    for (int c = 0; c < 3; ++c) {
+      color[c] = mean[c] + axis[c] * t_min;
+    }
+    Endpoint second = Quantize(color);
+
+    int weights[16], best_weights[16];
+    float best_error = SelectIndices(block, first, second, best_weights);
+    Endpoint best_first = first, best_second = second;
+
+    // Least squares fit of the endpoints to the chosen palette entries.
+    for (int iteration = 0; iteration < 2 && best_error > 0.0f;
+         ++iteration) {
+      float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+      float ax[3] = {0.0f, 0.0f, 0.0f}, bx[3] = {0.0f, 0.0f, 0.0f};
+      for (int i = 0; i < 16; ++i) {
+        float b = best_weights[i] * (1.0f / 3.0f), a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c) {
+          ax[c] += a * channels[c][i];
+          bx[c] += b * channels[c][i];
+        }
+      }
+      float determinant = aa * bb - ab * ab;
+      if (std::abs(determinant) < 1e-6f) {
+        break;
+      }
+      float first_color[3], second_color[3];
+      for (int c = 0; c < 3; ++c) {
+        first_color[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+        second_color[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+      }
+      first = Quantize(first_color);
+      second = Quantize(second_color);
+      float error = SelectIndices(block, first, second, weights);
+      if (error >= best_error) {
+        break;
+      }
+      best_error = error;
+      best_first = first;
+      best_second = second;
+      std::copy(weights, weights + 16, best_weights);
+    }
+
+    // The 4 color mode needs the first endpoint to be the larger.
+    bool swap = best_first.bits < best_second.bits;
+    if (swap) {
+      std::swap(best_first, best_second);
+    }
+    uint32_t indices = 0;
+    if (best_first.bits != best_second.bits) {
+      // Palette order: first, second, 2/3 first + 1/3 second, and
+      // 1/3 first + 2/3 second.
+      static const uint32_t kIndex[4] = {0, 2, 3, 1};
+      for (int i = 0; i < 16; ++i) {
+        int weight = swap ? 3 - best_weights[i] : best_weights[i];
+        indices |= kIndex[weight] << (2 * i);
+      }
+    }
+    out[0] = uint8_t(best_first.bits);
+    out[1] = uint8_t(best_first.bits >> 8);
+    out[2] = uint8_t(best_second.bits);
+    out[3] = uint8_t(best_second.bits >> 8);
+    for (int i = 0; i < 4; ++i) {
+      out[4 + i] = uint8_t(indices >> (8 * i));
+    }
+  }
+
+  // Encodes a channel of a block to a BC4 block (which is also the alpha
+  // block of BC3, and half of a BC5 block), in 8 value mode.
+  static void EncodeChannel(const float* values, unsigned char* out) {
+    float min = *std::min_element(values, values + 16);
+    float max = *std::max_element(values, values + 16);
+    out[0] = uint8_t(max);
+    out[1] = uint8_t(min);
+    uint64_t indices = 0;
+    if (max > min) {
+      // Palette order: max, min, then 6/7 max + 1/7 min ... 1/7 max + 6/7 min.
+      float scale = 7.0f / (max - min);
+      for (int i = 0; i < 16; ++i) {
+        int weight = int((values[i] - min) * scale + 0.5f);
+        uint64_t index = weight == 7 ? 0 : weight == 0 ? 1 : 8 - weight;
+        indices |= index << (3 * i);
+      }
+    }
+    for (int i = 0; i < 6; ++i) {
+      out[2 + i] = uint8_t(indices >> (8 * i));
+    }
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_BLOCK_COMPRESSOR_H_
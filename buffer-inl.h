@@ -6,6 +6,13 @@
 #include "./buffer.h"
 #include "context/binding.h"
 
+#if OGLWRAP_USE_SSE2
+  #include <emmintrin.h>
+#endif
+#if OGLWRAP_USE_NEON
+  #include <arm_neon.h>
+#endif
+
 #include "./define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
@@ -106,6 +113,121 @@ BufferObject<BUFFER_TYPE>::TypedMap<T>::~TypedMap() {
 
 #endif  // glMapBuffer && glUnmapBuffer && glMapBufferRange
 
+/// Returns the smallest index type, that can represent every index.
+inline IndexType SmallestIndexType(const GLuint* indices, size_t count) {
+  // Only the highest set bit matters, so or-ing the indices together is
+  // enough, and is cheaper than a max.
+  GLuint all_bits = 0;
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  __m128i bits0 = _mm_setzero_si128(), bits1 = _mm_setzero_si128();
+  for (; i + 8 <= count; i += 8) {
+    bits0 = _mm_or_si128(bits0, _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(indices + i)));
+    bits1 = _mm_or_si128(bits1, _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(indices + i + 4)));
+  }
+  bits0 = _mm_or_si128(bits0, bits1);
+  bits0 = _mm_or_si128(bits0, _mm_shuffle_epi32(bits0, _MM_SHUFFLE(1, 0, 3, 2)));
+  bits0 = _mm_or_si128(bits0, _mm_shuffle_epi32(bits0, _MM_SHUFFLE(2, 3, 0, 1)));
+  all_bits = GLuint(_mm_cvtsi128_si32(bits0));
+#elif OGLWRAP_USE_NEON
+  uint32x4_t bits = vdupq_n_u32(0);
+  for (; i + 4 <= count; i += 4) {
+    bits = vorrq_u32(bits, vld1q_u32(indices + i));
+  }
+  uint32x2_t half = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+  all_bits = vget_lane_u32(half, 0) | vget_lane_u32(half, 1);
+#endif
+  for (; i < count; ++i) {
+    all_bits |= indices[i];
+  }
+
+  if (all_bits <= 0xff) {
+    return IndexType::kUnsignedByte;
+  } else if (all_bits <= 0xffff) {
+    return IndexType::kUnsignedShort;
+  } else {
+    return IndexType::kUnsignedInt;
+  }
+}
+
+/// Converts indices to GLushort, they all must be less than 65536.
+inline void NarrowIndices(const GLuint* src, size_t count, GLushort* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  for (; i + 8 <= count; i += 8) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+    // Sign extend the low 16 bits, so the saturating pack won't change them.
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+#elif OGLWRAP_USE_NEON
+  for (; i + 8 <= count; i += 8) {
+    vst1q_u16(dst + i, vcombine_u16(vmovn_u32(vld1q_u32(src + i)),
+                                    vmovn_u32(vld1q_u32(src + i + 4))));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = GLushort(src[i]);
+  }
+}
+
+/// Converts indices to GLubyte, they all must be less than 256.
+inline void NarrowIndices(const GLuint* src, size_t count, GLubyte* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  for (; i + 16 <= count; i += 16) {
+    const __m128i* block = reinterpret_cast<const __m128i*>(src + i);
+    __m128i lo = _mm_packs_epi32(_mm_loadu_si128(block),
+                                 _mm_loadu_si128(block + 1));
+    __m128i hi = _mm_packs_epi32(_mm_loadu_si128(block + 2),
+                                 _mm_loadu_si128(block + 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+#elif OGLWRAP_USE_NEON
+  for (; i + 8 <= count; i += 8) {
+    uint16x8_t shorts = vcombine_u16(vmovn_u32(vld1q_u32(src + i)),
+                                     vmovn_u32(vld1q_u32(src + i + 4)));
+    vst1_u8(dst + i, vmovn_u16(shorts));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = GLubyte(src[i]);
+  }
+}
+
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(GL_ELEMENT_ARRAY_BUFFER) \
+                                  && defined(glBufferData))
+inline void IndexBuffer::indices(const GLuint* indices, size_t count,
+                                 BufferUsage usage) {
+  IndexType type = SmallestIndexType(indices, count);
+  switch (type) {
+    case IndexType::kUnsignedByte: {
+      std::vector<GLubyte> narrow(count);
+      NarrowIndices(indices, count, narrow.data());
+      data(narrow, usage);
+      break;
+    }
+    case IndexType::kUnsignedShort: {
+      std::vector<GLushort> narrow(count);
+      NarrowIndices(indices, count, narrow.data());
+      data(narrow, usage);
+      break;
+    }
+    default:
+      data(GLsizei(count * sizeof(GLuint)), indices, usage);
+      break;
+  }
+  index_type_ = type;
+  index_count_ = count;
+}
+#endif  // GL_ELEMENT_ARRAY_BUFFER && glBufferData
+
 #endif
 
 }  // namespace oglwrap
@@ -14,6 +14,7 @@
 #include "enums/indexed_buffer_type.h"
 #include "enums/indexed_buffer_binding.h"
 #include "enums/buffer_usage.h"
+#include "enums/index_type.h"
 #include "enums/buffer_map_access.h"
 #include "enums/buffer_map_access_flags.h"
 
@@ -162,6 +163,12 @@ using ArrayBuffer = BufferObject<BufferType::kArrayBuffer>;
 #endif  // GL_ARRAY_BUFFER
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_ELEMENT_ARRAY_BUFFER)
+#if OGLWRAP_INSTANTIATE
+  template class BufferObject<BufferType::kElementArrayBuffer>;
+#else
+  extern template class BufferObject<BufferType::kElementArrayBuffer>;
+#endif
+
 /// A buffer that stores the order of the vertices for a draw call.
 /** All rendering functions of the form gl*Draw*Elements*​ will use the pointer
   * field as a byte offset from the beginning of the buffer object bound to this
@@ -169,16 +176,54 @@ using ArrayBuffer = BufferObject<BufferType::kArrayBuffer>;
   * object. Note that this binding target is part of a Vertex Array Objects
   * state, so a VAO must be bound before binding a buffer here.
   * @see GL_ELEMENT_ARRAY_BUFFER */
-using IndexBuffer = BufferObject<BufferType::kElementArrayBuffer>;
+class IndexBuffer : public BufferObject<BufferType::kElementArrayBuffer> {
+ public:
+  IndexBuffer() : index_type_(IndexType::kUnsignedInt), index_count_(0) {}
 
-#if OGLWRAP_INSTANTIATE
-  template class BufferObject<BufferType::kElementArrayBuffer>;
-#else
-  extern template class BufferObject<BufferType::kElementArrayBuffer>;
-#endif
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBufferData)
+  /// Uploads indices with the smallest type, that can represent all of them.
+  /** The chosen type is remembered, and the DrawElements overloads taking an
+    * IndexBuffer use it. Meshes with less than 65536 vertices need only half
+    * of the memory and bandwidth this way.
+    * @param indices  Specifies the indices to upload.
+    * @param count    Specifies the number of indices.
+    * @param usage    Specifies the expected usage pattern of the data store.
+    * @see glBufferData */
+  void indices(const GLuint* indices, size_t count,
+               BufferUsage usage = BufferUsage::kStaticDraw);
+
+  /// Uploads indices with the smallest type, that can represent all of them.
+  /** @param indices  Specifies a vector of indices to upload.
+    * @param usage    Specifies the expected usage pattern of the data store.
+    * @see glBufferData */
+  void indices(const std::vector<GLuint>& indices,
+               BufferUsage usage = BufferUsage::kStaticDraw) {
+    this->indices(indices.data(), indices.size(), usage);
+  }
+#endif  // glBufferData
+
+  /// Returns the type picked by the last indices() call.
+  /** It is IndexType::kUnsignedInt if indices() wasn't called yet. */
+  IndexType indexType() const { return index_type_; }
+
+  /// Returns the number of indices uploaded by the last indices() call.
+  size_t indexCount() const { return index_count_; }
+
+ private:
+  IndexType index_type_;
+  size_t index_count_;
+};
 
 #endif  // GL_ELEMENT_ARRAY_BUFFER
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_DRAW_INDIRECT_BUFFER)
+/// A buffer that stores the parameters of indirect draw calls.
+/** The Draw*Indirect functions read DrawArraysIndirectCommand or
+  * DrawElementsIndirectCommand structures from the buffer bound here.
+  * @see GL_DRAW_INDIRECT_BUFFER */
+using IndirectBuffer = BufferObject<BufferType::kDrawIndirectBuffer>;
+#endif  // GL_DRAW_INDIRECT_BUFFER
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_TEXTURE_BUFFER)
 /// A Buffer that stores texture pixels.
 /** This buffer has no special semantics, it is intended to use as a buffer
@@ -187,6 +232,14 @@ using IndexBuffer = BufferObject<BufferType::kElementArrayBuffer>;
 using TextureBuffer = BufferObject<BufferType::kTextureBuffer>;
 #endif  // GL_TEXTURE_BUFFER
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_PIXEL_UNPACK_BUFFER)
+/// A buffer that is the source of the texture uploads.
+/** While a buffer is bound here, the data pointer of the texture upload
+  * functions is a byte offset into the buffer, instead of client memory.
+  * @see GL_PIXEL_UNPACK_BUFFER */
+using PixelUnpackBuffer = BufferObject<BufferType::kPixelUnpackBuffer>;
+#endif  // GL_PIXEL_UNPACK_BUFFER
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBufferBase)
 template<IndexedBufferType BUFFER_TYPE>
 /// Buffer objects that have an array of binding targets, like UniformBuffers.
@@ -207,6 +260,18 @@ using UniformBuffer = IndexedBufferObject<IndexedBufferType::kUniformBuffer>;
 using TransformFeedbackBuffer = IndexedBufferObject<IndexedBufferType::kTransformFeedbackBuffer> ;
 #endif  // GL_TRANSFORM_FEEDBACK_BUFFER
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_SHADER_STORAGE_BUFFER)
+/// An indexed buffer binding for buffers used as shader storage blocks.
+/** @see GL_SHADER_STORAGE_BUFFER */
+using ShaderStorageBuffer = IndexedBufferObject<IndexedBufferType::kShaderStorageBuffer>;
+#endif  // GL_SHADER_STORAGE_BUFFER
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_ATOMIC_COUNTER_BUFFER)
+/// An indexed buffer binding for buffers used as storage for atomic counters.
+/** @see GL_ATOMIC_COUNTER_BUFFER */
+using AtomicCounterBuffer = IndexedBufferObject<IndexedBufferType::kAtomicCounterBuffer>;
+#endif  // GL_ATOMIC_COUNTER_BUFFER
+
 #endif  // glBindBufferBase
 #endif  // glGenBuffers && glDeleteBuffers
 
@@ -0,0 +1,385 @@
+// Copyright (c) Tamas Csala
+
+/** @file command_buffer.h
+    @brief Implements a draw command buffer, that sorts the draws by state
+           before submitting them.
+*/
+
+#ifndef OGLWRAP_COMMAND_BUFFER_H_
+#define OGLWRAP_COMMAND_BUFFER_H_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./config.h"
+#include "./program.h"
+#include "./vertex_array.h"
+#include "context/binding.h"
+#include "context/drawing.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glUseProgram) && defined(glBindVertexArray))
+
+/// Binds the state of a material (textures, uniforms, etc.) before a draw.
+/** The material pointer is the one given at the recording of the draw. */
+typedef void (*MaterialBinder)(const void* material);
+
+/**
+ * @brief Builds a 64 bit sort key for a draw command.
+ *
+ * The fields are compared in this order (from the most significant bits):
+ *  - pass (8 bits): for ex. shadow, opaque, translucent.
+ *  - program (12 bits), material (16 bits), VAO (12 bits): the state changes,
+ *    ordered from the most expensive to the cheapest.
+ *  - depth (16 bits): [0, 1], draws with smaller depth go first. For back to
+ *    front ordering (translucent passes) use 1 - depth.
+ *
+ * The ids are truncated to the size of their fields, which only matters for
+ * the sort order, it doesn't change what is bound for a draw.
+ */
+inline uint64_t MakeDrawSortKey(GLuint pass, GLuint program, GLuint material,
+                                GLuint vao, GLfloat depth) {
+  GLfloat clamped_depth = std::min(std::max(depth, 0.0f), 1.0f);
+  uint64_t quantized_depth = uint64_t(clamped_depth * 65535.0f + 0.5f);
+  return (uint64_t(pass & 0xff) << 56) |
+         (uint64_t(program & 0xfff) << 44) |
+         (uint64_t(material & 0xffff) << 28) |
+         (uint64_t(vao & 0xfff) << 16) |
+         quantized_depth;
+}
+
+/// Builds a sort key using the handles of the program and the VAO as ids.
+/** @see MakeDrawSortKey(GLuint, GLuint, GLuint, GLuint, GLfloat) */
+inline uint64_t MakeDrawSortKey(GLuint pass, const Program& program,
+                                GLuint material, const VertexArray& vao,
+                                GLfloat depth) {
+  return MakeDrawSortKey(pass, program.expose(), material, vao.expose(), depth);
+}
+
+/// A single recorded draw. It's a POD, so recording is just a copy.
+struct DrawCommand {
+  /// The kind of the draw call.
+  enum Kind : GLubyte { kArrays, kElements };
+
+  uint64_t key;
+  const Program* program;
+  const VertexArray* vao;
+  MaterialBinder material_binder;  // can be nullptr
+  const void* material;
+  Kind kind;
+  PrimType primitive;
+  IndexType index_type;  // only for kElements
+  GLint first;           // first vertex for kArrays, first index for kElements
+  GLsizei count;
+  GLsizei inst_count;
+  GLint base_vertex;     // only for kElements
+  GLuint base_instance;
+};
+
+template <typename GLtype>
+/// Issues an indexed draw command with the given index type.
+inline void ReplayDrawElements(const DrawCommand& command) {
+  const GLtype* offset = reinterpret_cast<const GLtype*>(
+      size_t(command.first) * sizeof(GLtype));
+  if (command.base_instance != 0) {
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || defined(glDrawElementsInstancedBaseVertexBaseInstance)
+    DrawElementsInstancedBaseVertexBaseInstance(
+        command.primitive, command.count, offset, command.inst_count,
+        command.base_vertex, command.base_instance);
+#else
+    throw std::runtime_error("ReplayDraw() is called with a base "
+      "instance, but the glDrawElementsInstancedBaseVertexBaseInstance "
+      "symbol is missing.");
+#endif  // glDrawElementsInstancedBaseVertexBaseInstance
+  } else if (command.base_vertex != 0) {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawElementsInstancedBaseVertex)
+    DrawElementsInstancedBaseVertex(command.primitive, command.count, offset,
+                                    command.inst_count, command.base_vertex);
+#else
+    throw std::runtime_error("ReplayDraw() is called with a base "
+      "vertex, but the glDrawElementsInstancedBaseVertex symbol is missing.");
+#endif  // glDrawElementsInstancedBaseVertex
+  } else if (command.inst_count != 1) {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawElementsInstanced)
+    DrawElementsInstanced(command.primitive, command.count, offset,
+                          command.inst_count);
+#else
+    throw std::runtime_error("ReplayDraw() is called with an "
+      "instanced draw, but the glDrawElementsInstanced symbol is missing.");
+#endif  // glDrawElementsInstanced
+  } else {
+    DrawElements(command.primitive, command.count, offset);
+  }
+}
+
+/// Issues the draw call of a command (doesn't bind its state).
+/** Picks the simplest draw function, that supports the parameters. */
+inline void ReplayDraw(const DrawCommand& command) {
+  if (command.kind == DrawCommand::kArrays) {
+    if (command.base_instance != 0) {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawArraysInstancedBaseInstance)
+      DrawArraysInstancedBaseInstance(command.primitive, command.first,
+                                      command.count, command.inst_count,
+                                      command.base_instance);
+#else
+      throw std::runtime_error("ReplayDraw() is called with a "
+        "base instance, but the glDrawArraysInstancedBaseInstance symbol "
+        "is missing.");
+#endif  // glDrawArraysInstancedBaseInstance
+    } else if (command.inst_count != 1) {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawArraysInstanced)
+      DrawArraysInstanced(command.primitive, command.first, command.count,
+                          command.inst_count);
+#else
+      throw std::runtime_error("ReplayDraw() is called with an "
+        "instanced draw, but the glDrawArraysInstanced symbol is missing.");
+#endif  // glDrawArraysInstanced
+    } else {
+      DrawArrays(command.primitive, command.first, command.count);
+    }
+    return;
+  }
+
+  switch (command.index_type) {
+    case IndexType::kUnsignedByte:
+      ReplayDrawElements<GLubyte>(command);
+      break;
+    case IndexType::kUnsignedShort:
+      ReplayDrawElements<GLushort>(command);
+      break;
+    case IndexType::kUnsignedInt:
+      ReplayDrawElements<GLuint>(command);
+      break;
+  }
+}
+
+/**
+ * @brief Records draw calls, sorts them by a state key, and replays them
+ *        with the least possible program, material and VAO changes.
+ *
+ * @code
+ *   gl::CommandBuffer commands;
+ *   for (const Mesh& mesh : scene) {
+ *     uint64_t key = gl::MakeDrawSortKey(kOpaquePass, mesh.program,
+ *                                        mesh.material_id, mesh.vao, depth);
+ *     commands.drawElements(key, mesh.program, mesh.vao, BindMaterial,
+ *                           &mesh.material, gl::PrimType::kTriangles,
+ *                           mesh.index_type, mesh.index_count);
+ *   }
+ *   commands.sort();
+ *   commands.submit();
+ *   commands.clear();
+ * @endcode
+ * The objects referenced by the commands must outlive the submission.
+ */
+class CommandBuffer {
+ public:
+  /// The counters of the last submit().
+  struct Statistics {
+    size_t draws;
+    size_t program_changes;
+    size_t material_changes;
+    size_t vao_changes;
+  };
+
+  CommandBuffer() : sorted_(false), statistics_{0, 0, 0, 0} {}
+
+  /// Preallocates space for the given number of commands.
+  void reserve(size_t count) {
+    commands_.reserve(count);
+    order_.reserve(count);
+    scratch_.reserve(count);
+  }
+
+  /// Records a non-indexed draw.
+  /** @param key              The sort key, see MakeDrawSortKey.
+    * @param program          The program to use for the draw.
+    * @param vao              The VAO to use for the draw.
+    * @param material_binder  The function that binds the material, or nullptr.
+    * @param material         The argument for material_binder.
+    * @param primitive        Specifies what kind of primitives to render.
+    * @param first            Specifies the starting index in the enabled arrays.
+    * @param count            Specifies the number of indices to be rendered.
+    * @param inst_count       Specifies the number of instances to render.
+    * @param base_instance    Specifies the base instance for use in fetching
+    *                         instanced vertex attributes.
+    * @see DrawArrays, DrawArraysInstanced, DrawArraysInstancedBaseInstance */
+  void drawArrays(uint64_t key, const Program& program, const VertexArray& vao,
+                  MaterialBinder material_binder, const void* material,
+                  PrimType primitive, GLint first, GLsizei count,
+                  GLsizei inst_count = 1, GLuint base_instance = 0) {
+    push(DrawCommand{key, &program, &vao, material_binder, material,
+                     DrawCommand::kArrays, primitive, IndexType::kUnsignedInt,
+                     first, count, inst_count, 0, base_instance});
+  }
+
+  /// Records an indexed draw, using the index buffer of the VAO.
+  /** @param key              The sort key, see MakeDrawSortKey.
+    * @param program          The program to use for the draw.
+    * @param vao              The VAO to use for the draw.
+    * @param material_binder  The function that binds the material, or nullptr.
+    * @param material         The argument for material_binder.
+    * @param primitive        Specifies what kind of primitives to render.
+    * @param index_type       Specifies the type of the indices.
+    * @param count            Specifies the number of indices to be rendered.
+    * @param first            Specifies the first index to be rendered.
+    * @param inst_count       Specifies the number of instances to render.
+    * @param base_vertex      Specifies a constant that should be added to each
+    *                         index.
+    * @param base_instance    Specifies the base instance for use in fetching
+    *                         instanced vertex attributes.
+    * @see DrawElements, DrawElementsInstanced, DrawElementsInstancedBaseVertex,
+    *      DrawElementsInstancedBaseVertexBaseInstance */
+  void drawElements(uint64_t key, const Program& program,
+                    const VertexArray& vao, MaterialBinder material_binder,
+                    const void* material, PrimType primitive,
+                    IndexType index_type, GLsizei count, GLint first = 0,
+                    GLsizei inst_count = 1, GLint base_vertex = 0,
+                    GLuint base_instance = 0) {
+    push(DrawCommand{key, &program, &vao, material_binder, material,
+                     DrawCommand::kElements, primitive, index_type,
+                     first, count, inst_count, base_vertex, base_instance});
+  }
+
+  /// Records an indexed draw, with the index type of an IndexBuffer.
+  /** @see drawElements, IndexBuffer::indices */
+  void drawElements(uint64_t key, const Program& program,
+                    const VertexArray& vao, MaterialBinder material_binder,
+                    const void* material, PrimType primitive,
+                    const IndexBuffer& indices) {
+    drawElements(key, program, vao, material_binder, material, primitive,
+                 indices.indexType(), GLsizei(indices.indexCount()));
+  }
+
+  /// Sorts the commands by their keys (stable, so equal keys keep the
+  /// recording order).
+  /** It's a LSD radix sort on the keys, that skips the bytes, that are the
+    * same for every key. */
+  void sort() {
+    size_t count = commands_.size();
+    order_.resize(count);
+    scratch_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      order_[i] = SortEntry{commands_[i].key, GLuint(i)};
+    }
+
+    // Counting every digit in a single pass.
+    size_t histograms[8][256] = {};
+    for (const SortEntry& entry : order_) {
+      for (int digit = 0; digit < 8; ++digit) {
+        histograms[digit][(entry.key >> (8*digit)) & 0xff]++;
+      }
+    }
+
+    for (int digit = 0; digit < 8; ++digit) {
+      size_t* histogram = histograms[digit];
+      if (count == 0 || histogram[(order_[0].key >> (8*digit)) & 0xff] == count) {
+        continue;  // every key has the same value here
+      }
+      size_t offset = 0;
+      for (int bucket = 0; bucket < 256; ++bucket) {
+        size_t bucket_size = histogram[bucket];
+        histogram[bucket] = offset;
+        offset += bucket_size;
+      }
+      for (const SortEntry& entry : order_) {
+        scratch_[histogram[(entry.key >> (8*digit)) & 0xff]++] = entry;
+      }
+      order_.swap(scratch_);
+    }
+
+    sorted_ = true;
+  }
+
+  /// Replays the commands (in the sorted order if sort() was called after
+  /// the last recording), skipping the redundant binds.
+  /** The last used program and VAO stay bound after this call. */
+  void submit() {
+    statistics_ = Statistics{0, 0, 0, 0};
+    const Program* program = nullptr;
+    const VertexArray* vao = nullptr;
+    MaterialBinder material_binder = nullptr;
+    const void* material = nullptr;
+    bool first_command = true;
+
+    for (size_t i = 0; i < commands_.size(); ++i) {
+      const DrawCommand& command = this->command(i);
+
+      if (first_command || program->expose() != command.program->expose()) {
+        Bind(*command.program);
+        statistics_.program_changes++;
+      }
+      if (first_command || vao->expose() != command.vao->expose()) {
+        Bind(*command.vao);
+        statistics_.vao_changes++;
+      }
+      if (command.material_binder && (first_command ||
+          material_binder != command.material_binder ||
+          material != command.material)) {
+        command.material_binder(command.material);
+        statistics_.material_changes++;
+      }
+      program = command.program;
+      vao = command.vao;
+      material_binder = command.material_binder;
+      material = command.material;
+      first_command = false;
+
+      ReplayDraw(command);
+      statistics_.draws++;
+    }
+  }
+
+  /// Removes every command.
+  void clear() {
+    commands_.clear();
+    order_.clear();
+    sorted_ = false;
+  }
+
+  /// Returns the number of recorded commands.
+  size_t size() const { return commands_.size(); }
+
+  /// Returns the recorded commands, in the recording order.
+  const std::vector<DrawCommand>& commands() const { return commands_; }
+
+  /// Returns the i-th command in the submission order.
+  const DrawCommand& command(size_t i) const {
+    return commands_[sorted_ ? order_[i].index : i];
+  }
+
+  /// Returns the counters of the last submit().
+  const Statistics& statistics() const { return statistics_; }
+
+ private:
+  struct SortEntry {
+    uint64_t key;
+    GLuint index;
+  };
+
+  std::vector<DrawCommand> commands_;
+  std::vector<SortEntry> order_, scratch_;
+  bool sorted_;  // true if order_ is up to date
+  Statistics statistics_;
+
+  void push(const DrawCommand& command) {
+    commands_.push_back(command);
+    sorted_ = false;
+  }
+};
+
+#endif  // glUseProgram && glBindVertexArray
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_COMMAND_BUFFER_H_
@@ -0,0 +1,359 @@
+// Copyright (c) Tamas Csala
+
+/** @file command_list.h
+    @brief Implements command lists, that can be recorded on any thread, and
+           replayed on the thread that owns the OpenGL context.
+*/
+
+#ifndef OGLWRAP_COMMAND_LIST_H_
+#define OGLWRAP_COMMAND_LIST_H_
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "./program.h"
+#include "./uniform.h"
+#include "./vertex_array.h"
+#include "./command_buffer.h"
+#include "context/binding.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glUseProgram) && defined(glBindVertexArray))
+/**
+ * @brief A list of state changes and draws, encoded as POD commands, that can
+ *        be recorded without an OpenGL context.
+ *
+ * Recording only writes into the list's own arena (a chain of memory blocks,
+ * that are kept between the frames), so any number of threads can record
+ * their own lists in parallel, without locks. A list must be recorded by one
+ * thread at a time, and executed on the thread of the context.
+ *
+ * The lists reference the objects (programs, VAOs, uniforms), they have to
+ * outlive the execution.
+ * @code
+ *   gl::CommandList list;
+ *   list.useProgram(program);
+ *   list.uniform(mvp_uniform, mvp);
+ *   list.bindVertexArray(vao);
+ *   list.drawElements(gl::PrimType::kTriangles, index_buffer);
+ *   ...
+ *   list.execute();  // on the GL thread
+ *   list.reset();
+ * @endcode
+ */
+class CommandList {
+ public:
+  /// The binding state, that is carried between the executed lists.
+  struct State {
+    const Program* program;
+    const VertexArray* vao;
+    size_t commands;       ///< The commands executed.
+    size_t skipped_binds;  ///< The binds, that were redundant.
+  };
+
+  /// Creates an empty list.
+  /** @param block_size  The size of the arena's memory blocks in bytes. */
+  explicit CommandList(size_t block_size = 64 * 1024)
+      : block_size_(block_size), current_block_(0), size_(0) {}
+
+  /// Records a program change.
+  /** @see Bind(const Program&) */
+  void useProgram(const Program& program) {
+    const Program* pointer = &program;
+    record(kUseProgram, &pointer, sizeof(pointer));
+  }
+
+  /// Records a vertex array change.
+  /** @see Bind(const VertexArray&) */
+  void bindVertexArray(const VertexArray& vao) {
+    const VertexArray* pointer = &vao;
+    record(kBindVertexArray, &pointer, sizeof(pointer));
+  }
+
+  template <typename GLtype>
+  /// Records setting a uniform of the program, that is in use at that point.
+  /** The value is copied into the list. */
+  void uniform(UniformObject<GLtype>& uniform, const GLtype& value) {
+    static_assert(std::is_trivially_copyable<GLtype>::value,
+                  "Uniform values are copied into the command list");
+    static_assert(alignof(GLtype) <= kAlignment,
+                  "The arena doesn't support this alignment");
+    UniformPayload<GLtype> payload = {&SetUniform<GLtype>, &uniform, value};
+    record(kCall, &payload, sizeof(payload));
+  }
+
+  /// Records a call to a function, that sets some state (textures, etc.).
+  /** The function is called with the given argument on the GL thread. */
+  void call(MaterialBinder function, const void* argument) {
+    CallPayload payload = {&CallFunction, function, argument};
+    record(kCall, &payload, sizeof(payload));
+  }
+
+  /// Records a non-indexed draw, with the currently recorded state.
+  /** @see DrawArrays, DrawArraysInstanced, DrawArraysInstancedBaseInstance */
+  void drawArrays(PrimType primitive, GLint first, GLsizei count,
+                  GLsizei inst_count = 1, GLuint base_instance = 0) {
+    DrawCommand command = {0, nullptr, nullptr, nullptr, nullptr,
+                           DrawCommand::kArrays, primitive,
+                           IndexType::kUnsignedInt, first, count, inst_count,
+                           0, base_instance};
+    record(kDraw, &command, sizeof(command));
+  }
+
+  /// Records an indexed draw, with the currently recorded state.
+  /** @see DrawElements, DrawElementsInstanced,
+    *      DrawElementsInstancedBaseVertex,
+    *      DrawElementsInstancedBaseVertexBaseInstance */
+  void drawElements(PrimType primitive, IndexType index_type, GLsizei count,
+                    GLint first = 0, GLsizei inst_count = 1,
+                    GLint base_vertex = 0, GLuint base_instance = 0) {
+    DrawCommand command = {0, nullptr, nullptr, nullptr, nullptr,
+                           DrawCommand::kElements, primitive, index_type,
+                           first, count, inst_count, base_vertex,
+                           base_instance};
+    record(kDraw, &command, sizeof(command));
+  }
+
+  /// Records drawing every index of an IndexBuffer.
+  /** @see IndexBuffer::indices */
+  void drawElements(PrimType primitive, const IndexBuffer& indices) {
+    drawElements(primitive, indices.indexType(),
+                 GLsizei(indices.indexCount()));
+  }
+
+  /// Executes the commands in the recording order.
+  /** Must be called on the thread of the context. */
+  void execute() const {
+    State state = {nullptr, nullptr, 0, 0};
+    execute(&state);
+  }
+
+  /// Executes the commands, skipping the binds, that would bind the state
+  /// that is already bound according to state.
+  void execute(State* state) const {
+    for (size_t i = 0; i < blocks_.size() && i <= current_block_; ++i) {
+      const unsigned char* command = blocks_[i].data.get();
+      const unsigned char* end = command + blocks_[i].used;
+      while (command < end) {
+        Header header;
+        std::memcpy(&header, command, sizeof(header));
+        executeCommand(header.opcode, command + sizeof(Header), state);
+        state->commands++;
+        command += header.size;
+      }
+    }
+  }
+
+  /// Removes every command, but keeps the memory of the arena.
+  void reset() {
+    for (Block& block : blocks_) {
+      block.used = 0;
+    }
+    current_block_ = 0;
+    size_ = 0;
+  }
+
+  /// Returns the number of recorded commands.
+  size_t size() const { return size_; }
+
+  /// Returns true if no command was recorded since the last reset.
+  bool empty() const { return size_ == 0; }
+
+ private:
+  enum Opcode : GLuint { kUseProgram, kBindVertexArray, kCall, kDraw };
+
+  struct Header {
+    GLuint opcode;
+    GLuint size;  // of the whole command including the header, in bytes
+  };
+
+  typedef void (*Executor)(const void* payload);
+
+  struct CallPayload {
+    Executor executor;
+    MaterialBinder function;
+    const void* argument;
+  };
+
+  template <typename GLtype>
+  struct UniformPayload {
+    Executor executor;
+    UniformObject<GLtype>* uniform;
+    GLtype value;
+  };
+
+  struct Block {
+    std::unique_ptr<unsigned char[]> data;
+    size_t size;
+    size_t used;
+  };
+
+  static constexpr size_t kAlignment = 8;
+
+  std::vector<Block> blocks_;
+  size_t block_size_;
+  size_t current_block_;
+  size_t size_;
+
+  static void CallFunction(const void* payload) {
+    const CallPayload* call = static_cast<const CallPayload*>(payload);
+    call->function(call->argument);
+  }
+
+  template <typename GLtype>
+  static void SetUniform(const void* payload) {
+    const UniformPayload<GLtype>* uniform =
+        static_cast<const UniformPayload<GLtype>*>(payload);
+    uniform->uniform->set(uniform->value);
+  }
+
+  void record(Opcode opcode, const void* payload, size_t payload_size) {
+    size_t size = (sizeof(Header) + payload_size + kAlignment - 1)
+                  & ~(kAlignment - 1);
+    unsigned char* command = allocate(size);
+    Header header = {opcode, GLuint(size)};
+    std::memcpy(command, &header, sizeof(header));
+    std::memcpy(command + sizeof(Header), payload, payload_size);
+    size_++;
+  }
+
+  unsigned char* allocate(size_t size) {
+    while (current_block_ < blocks_.size()) {
+      Block& block = blocks_[current_block_];
+      if (block.used + size <= block.size) {
+        unsigned char* memory = block.data.get() + block.used;
+        block.used += size;
+        return memory;
+      }
+      if (current_block_ + 1 == blocks_.size()) {
+        break;
+      }
+      blocks_[++current_block_].used = 0;
+    }
+
+    size_t block_size = std::max(block_size_, size);
+    blocks_.push_back(Block{std::unique_ptr<unsigned char[]>(
+        new unsigned char[block_size]), block_size, size});
+    current_block_ = blocks_.size() - 1;
+    return blocks_.back().data.get();
+  }
+
+  static void executeCommand(GLuint opcode, const unsigned char* payload,
+                             State* state) {
+    switch (opcode) {
+      case kUseProgram: {
+        const Program* program;
+        std::memcpy(&program, payload, sizeof(program));
+        if (state->program &&
+            state->program->expose() == program->expose()) {
+          state->skipped_binds++;
+        } else {
+          Bind(*program);
+          state->program = program;
+        }
+        break;
+      }
+      case kBindVertexArray: {
+        const VertexArray* vao;
+        std::memcpy(&vao, payload, sizeof(vao));
+        if (state->vao && state->vao->expose() == vao->expose()) {
+          state->skipped_binds++;
+        } else {
+          Bind(*vao);
+          state->vao = vao;
+        }
+        break;
+      }
+      case kCall: {
+        Executor executor;
+        std::memcpy(&executor, payload, sizeof(executor));
+        executor(payload);
+        break;
+      }
+      case kDraw: {
+        ReplayDraw(*reinterpret_cast<const DrawCommand*>(payload));
+        break;
+      }
+    }
+  }
+};
+
+/**
+ * @brief A fixed set of command lists, that are executed together, in the
+ *        order of their indices.
+ *
+ * Give every parallel task its own list (for ex. by the task index of a
+ * ThreadPool), and the submission order will be the same, regardless of
+ * which thread recorded which list, or when they finished.
+ * @code
+ *   gl::CommandListSet lists(chunk_count);
+ *   pool.run(chunk_count, [&](size_t chunk) {
+ *     for (const Object& object : chunks[chunk]) {
+ *       object.record(&lists[chunk]);
+ *     }
+ *   });
+ *   lists.submit();  // on the GL thread
+ *   lists.reset();
+ * @endcode
+ */
+class CommandListSet {
+ public:
+  /// Creates count empty lists.
+  explicit CommandListSet(size_t count, size_t block_size = 64 * 1024) {
+    lists_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      lists_.emplace_back(block_size);
+    }
+    statistics_ = CommandList::State{nullptr, nullptr, 0, 0};
+  }
+
+  /// Returns the i-th list.
+  CommandList& operator[](size_t i) { return lists_[i]; }
+  const CommandList& operator[](size_t i) const { return lists_[i]; }
+
+  /// Returns the number of lists.
+  size_t size() const { return lists_.size(); }
+
+  /// Executes the lists in the order of their indices.
+  /** The binding state is carried between the lists, so a bind at the start
+    * of a list is skipped if the previous list left the same object bound.
+    * Must be called on the thread of the context, after every recording
+    * thread finished. */
+  void submit() {
+    statistics_ = CommandList::State{nullptr, nullptr, 0, 0};
+    for (const CommandList& list : lists_) {
+      list.execute(&statistics_);
+    }
+  }
+
+  /// Resets every list, keeping their memory.
+  void reset() {
+    for (CommandList& list : lists_) {
+      list.reset();
+    }
+  }
+
+  /// Returns the counters (and the last bound state) of the last submit().
+  const CommandList::State& statistics() const { return statistics_; }
+
+ private:
+  std::vector<CommandList> lists_;
+  CommandList::State statistics_;
+};
+#endif  // glUseProgram && glBindVertexArray
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_COMMAND_LIST_H_
@@ -82,6 +82,45 @@
   #define OGLWRAP_USE_IMAGEMAGICK 0
 #endif
 
+/**
+ * @brief The instruction sets the CPU side (SIMD) helpers may use.
+ *
+ * By default they are enabled if the compiler targets them. Define any of
+ * them to 0 to force the scalar fallback.
+ */
+#ifndef OGLWRAP_USE_SSE2
+  #if defined(__SSE2__) || defined(_M_X64) \
+      || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OGLWRAP_USE_SSE2 1
+  #else
+    #define OGLWRAP_USE_SSE2 0
+  #endif
+#endif
+
+#ifndef OGLWRAP_USE_AVX2
+  #if defined(__AVX2__)
+    #define OGLWRAP_USE_AVX2 1
+  #else
+    #define OGLWRAP_USE_AVX2 0
+  #endif
+#endif
+
+#ifndef OGLWRAP_USE_F16C
+  #if defined(__F16C__)
+    #define OGLWRAP_USE_F16C 1
+  #else
+    #define OGLWRAP_USE_F16C 0
+  #endif
+#endif
+
+#ifndef OGLWRAP_USE_NEON
+  #if defined(__aarch64__) || defined(_M_ARM64)
+    #define OGLWRAP_USE_NEON 1
+  #else
+    #define OGLWRAP_USE_NEON 0
+  #endif
+#endif
+
 /**
  * @brief If true, includes every oglwrap header, not just the commonly used ones.
  *
@@ -3,6 +3,8 @@
 #ifndef OGLWRAP_CONTEXT_BINDING_H_
 #define OGLWRAP_CONTEXT_BINDING_H_
 
+#include <cassert>
+
 #include "../buffer.h"
 #include "../renderbuffer.h"
 #include "../framebuffer.h"
@@ -10,6 +12,9 @@
 #include "../vertex_array.h"
 #include "../textures/texture_base.h"
 #include "../program.h"
+#include "../sampler.h"
+#include "./extensions.h"
+#include "./state_cache.h"
 
 #include "../define_internal_macros.h"
 
@@ -17,27 +22,34 @@ namespace OGLWRAP_NAMESPACE_NAME {
 
 // Buffer
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBuffer)
+inline void Unbind(BufferType BUFFER_TYPE) {
+  if (StateCache::Current() &&
+      !CacheBinding(GLenum(GetBindingTarget(BUFFER_TYPE)),
+                    StateCache::kNoIndex, 0)) {
+    return;
+  }
+  gl(BindBuffer(GLenum(BUFFER_TYPE), 0));
+}
+
 template<BufferType BUFFER_TYPE>
 void Bind(const BufferObject<BUFFER_TYPE>& buffer) {
+  if (StateCache::Current() &&
+      !CacheBinding(GLenum(GetBindingTarget(BUFFER_TYPE)),
+                    StateCache::kNoIndex, buffer.expose())) {
+    return;
+  }
   gl(BindBuffer(GLenum(BUFFER_TYPE), buffer.expose()));
 }
 
 template<BufferType BUFFER_TYPE>
 void Unbind(const BufferObject<BUFFER_TYPE>&) {
-  gl(BindBuffer(GLenum(BUFFER_TYPE), 0));
-}
-
-inline void Unbind(BufferType BUFFER_TYPE) {
-  gl(BindBuffer(GLenum(BUFFER_TYPE), 0));
+  Unbind(BUFFER_TYPE);
 }
 
 template<BufferType BUFFER_TYPE>
 bool IsBound(const BufferObject<BUFFER_TYPE>& buffer) {
-  GLint currently_bound_buffer;
-  gl(GetIntegerv(GLenum(GetBindingTarget(BUFFER_TYPE)),
-                 &currently_bound_buffer));
-
-  return buffer.expose() == GLuint(currently_bound_buffer);
+  return buffer.expose() ==
+         CachedBoundName(GLenum(GetBindingTarget(BUFFER_TYPE)));
 }
 #endif
 
@@ -45,6 +57,14 @@ bool IsBound(const BufferObject<BUFFER_TYPE>& buffer) {
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBufferBase)
 template<IndexedBufferType BUFFER_TYPE>
 void BindBase(const IndexedBufferObject<BUFFER_TYPE>& buffer, GLuint index) {
+  if (StateCache::Current()) {
+    GLenum binding = GLenum(GetBindingTarget(BUFFER_TYPE));
+    if (!CacheBinding(binding, index, buffer.expose())) {
+      return;
+    }
+    // glBindBufferBase binds to the generic binding point too.
+    CacheBinding(binding, StateCache::kNoIndex, buffer.expose());
+  }
   gl(BindBufferBase(GLenum(BUFFER_TYPE), index, buffer.expose()));
 }
 
@@ -52,7 +72,14 @@ void BindBase(const IndexedBufferObject<BUFFER_TYPE>& buffer, GLuint index) {
 template<IndexedBufferType BUFFER_TYPE>
 void BindRange(const IndexedBufferObject<BUFFER_TYPE>& buffer, GLuint index,
                GLintptr offset, GLsizeiptr size) {
-  gl(BindBufferRange(GLenum(BUFFER_TYPE), index, offset, size, buffer.expose()));
+  if (StateCache::Current()) {
+    GLenum binding = GLenum(GetBindingTarget(BUFFER_TYPE));
+    if (!CacheBinding(binding, index, buffer.expose(), offset, size)) {
+      return;
+    }
+    CacheBinding(binding, StateCache::kNoIndex, buffer.expose());
+  }
+  gl(BindBufferRange(GLenum(BUFFER_TYPE), index, buffer.expose(), offset, size));
 }
 #endif
 
@@ -63,156 +90,630 @@ bool IsBound(const IndexedBufferObject<BUFFER_TYPE>& buffer) {
 
 template<IndexedBufferType BUFFER_TYPE>
 bool IsBound(const IndexedBufferObject<BUFFER_TYPE>& buffer, GLuint index) {
-  GLint currently_bound_buffer;
-  gl(GetIntegeri_v(GLenum(GetBindingTarget(BUFFER_TYPE)), index,
-                   &currently_bound_buffer));
-  return buffer.expose() == GLuint(currently_bound_buffer);
+  return buffer.expose() ==
+         CachedBoundName(GLenum(GetBindingTarget(BUFFER_TYPE)), index);
 }
 
-template<IndexedBufferType BUFFER_TYPE>
-void UnbindBase(const IndexedBufferObject<BUFFER_TYPE>&, GLuint index) {
+inline void UnbindBase(IndexedBufferType BUFFER_TYPE, GLuint index) {
+  if (StateCache::Current()) {
+    GLenum binding = GLenum(GetBindingTarget(BUFFER_TYPE));
+    if (!CacheBinding(binding, index, 0)) {
+      return;
+    }
+    CacheBinding(binding, StateCache::kNoIndex, 0);
+  }
   gl(BindBufferBase(GLenum(BUFFER_TYPE), index, 0));
 }
 
-inline void UnbindBase(IndexedBufferType BUFFER_TYPE, GLuint index) {
-  gl(BindBufferBase(GLenum(BUFFER_TYPE), index, 0));
+template<IndexedBufferType BUFFER_TYPE>
+void UnbindBase(const IndexedBufferObject<BUFFER_TYPE>&, GLuint index) {
+  UnbindBase(BUFFER_TYPE, index);
 }
 #endif
 
 // Renderbuffer
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindRenderbuffer)
 inline void Bind(const Renderbuffer& buffer) {
-  gl(BindRenderbuffer(GL_RENDERBUFFER, buffer.expose()));
+  if (CacheBinding(GL_RENDERBUFFER_BINDING, StateCache::kNoIndex,
+                   buffer.expose())) {
+    gl(BindRenderbuffer(GL_RENDERBUFFER, buffer.expose()));
+  }
 }
 
-inline void Unbind(const Renderbuffer&) {
-  gl(BindRenderbuffer(GL_RENDERBUFFER, 0));
+inline void Unbind(RenderbufferType) {
+  if (CacheBinding(GL_RENDERBUFFER_BINDING, StateCache::kNoIndex, 0)) {
+    gl(BindRenderbuffer(GL_RENDERBUFFER, 0));
+  }
 }
 
-inline void Unbind(RenderbufferType) {
-  gl(BindRenderbuffer(GL_RENDERBUFFER, 0));
+inline void Unbind(const Renderbuffer&) {
+  Unbind(RenderbufferType::kRenderbuffer);
 }
 
 inline bool IsBound(const Renderbuffer& buffer) {
-  GLint currently_bound_buffer;
-  gl(GetIntegerv(GLenum(GetBindingTarget(RenderbufferType::kRenderbuffer)),
-                 &currently_bound_buffer));
-  return buffer.expose() == GLuint(currently_bound_buffer);
+  return buffer.expose() == CachedBoundName(
+      GLenum(GetBindingTarget(RenderbufferType::kRenderbuffer)));
 }
 #endif  // glBindRenderbuffer
 
 // Framebuffer
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindFramebuffer)
+/// Records a framebuffer binding in the current StateCache.
+/** Returns if the GL call, that makes the binding, has to be made. */
+inline bool CacheFramebufferBinding(FramebufferType fbo_type, GLuint name) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  // GL_FRAMEBUFFER sets both the draw and the read binding.
+  bool draw = fbo_type != FramebufferType::kReadFramebuffer &&
+              cache->binding(GL_DRAW_FRAMEBUFFER_BINDING).set(
+                  StateCache::Binding{name, 0, 0});
+  bool read = fbo_type != FramebufferType::kDrawFramebuffer &&
+              cache->binding(GL_READ_FRAMEBUFFER_BINDING).set(
+                  StateCache::Binding{name, 0, 0});
+  if (draw || read) {
+    return true;
+  }
+  cache->countSkippedCall();
+  return false;
+}
+
+inline void Unbind(FramebufferType FBO_TYPE) {
+  if (CacheFramebufferBinding(FBO_TYPE, 0)) {
+    gl(BindFramebuffer(GLenum(FBO_TYPE), 0));
+  }
+}
+
 template<FramebufferType FBO_TYPE>
 void Bind(const FramebufferObject<FBO_TYPE>& fbo) {
-  gl(BindFramebuffer(GLenum(FBO_TYPE), fbo.expose()));
+  if (CacheFramebufferBinding(FBO_TYPE, fbo.expose())) {
+    gl(BindFramebuffer(GLenum(FBO_TYPE), fbo.expose()));
+  }
 }
 
 template<FramebufferType FBO_TYPE>
 bool IsBound(const FramebufferObject<FBO_TYPE>& fbo) {
-  GLint currently_bound_buffer;
-  gl(GetIntegerv(GLenum(GetBindingTarget(FBO_TYPE)), &currently_bound_buffer));
-  return fbo.expose() == GLuint(currently_bound_buffer);
+  return fbo.expose() == CachedBoundName(GLenum(GetBindingTarget(FBO_TYPE)));
 }
 
 template<FramebufferType FBO_TYPE>
 void Unbind(const FramebufferObject<FBO_TYPE>& fbo) {
-  gl(BindFramebuffer(GLenum(FBO_TYPE), 0));
-}
-
-inline void Unbind(FramebufferType FBO_TYPE) {
-  gl(BindFramebuffer(GLenum(FBO_TYPE), 0));
+  Unbind(FBO_TYPE);
 }
 #endif
 
 
 // TransformFeedback
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindTransformFeedback)
-inline void Bind(const TransformFeedback& tfb)  {
-  gl(BindTransformFeedback(GL_TRANSFORM_FEEDBACK, tfb.expose()));
+inline void Unbind(TransformFeedbackType) {
+  if (CacheBinding(GL_TRANSFORM_FEEDBACK_BINDING, StateCache::kNoIndex, 0)) {
+    // The buffer bindings are the state of the transform feedback object.
+    ForgetBindings(GL_TRANSFORM_FEEDBACK_BUFFER_BINDING);
+    gl(BindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0));
+  }
 }
 
-inline void Unbind(const TransformFeedback& tfb) {
-  gl(BindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0));
+inline void Bind(const TransformFeedback& tfb)  {
+  if (CacheBinding(GL_TRANSFORM_FEEDBACK_BINDING, StateCache::kNoIndex,
+                   tfb.expose())) {
+    ForgetBindings(GL_TRANSFORM_FEEDBACK_BUFFER_BINDING);
+    gl(BindTransformFeedback(GL_TRANSFORM_FEEDBACK, tfb.expose()));
+  }
 }
 
-inline void Unbind(TransformFeedbackType) {
-  gl(BindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0));
+inline void Unbind(const TransformFeedback& tfb) {
+  Unbind(TransformFeedbackType::kTransformFeedback);
 }
 
 inline bool IsBound(const TransformFeedback& tfb)  {
-  GLint currently_bound_tfb;
-  gl(GetIntegerv(GLenum(GetBindingTarget(TransformFeedbackType::kTransformFeedback)),
-                 &currently_bound_tfb));
-  return tfb.expose() == GLuint(currently_bound_tfb);
+  return tfb.expose() == CachedBoundName(GLenum(
+      GetBindingTarget(TransformFeedbackType::kTransformFeedback)));
 }
 #endif
 
 
 // VertexArray
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBindVertexArray)
+inline void Unbind(VertexArrayType) {
+  if (CacheBinding(GL_VERTEX_ARRAY_BINDING, StateCache::kNoIndex, 0)) {
+    // The index buffer binding is the state of the VAO.
+    ForgetBindings(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+    gl(BindVertexArray(0));
+  }
+}
+
 inline void Bind(const VertexArray& vao) {
-  gl(BindVertexArray(vao.expose()));
+  if (CacheBinding(GL_VERTEX_ARRAY_BINDING, StateCache::kNoIndex,
+                   vao.expose())) {
+    ForgetBindings(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+    gl(BindVertexArray(vao.expose()));
+  }
 }
 
 inline void Unbind(const VertexArray& vao) {
-  gl(BindVertexArray(0));
+  Unbind(VertexArrayType::kVertexArray);
 }
 
-inline void Unbind(VertexArrayType) {
-  gl(BindVertexArray(0));
+inline bool IsBound(const VertexArray& vao) {
+  return vao.expose() == CachedBoundName(
+      GLenum(GetBindingTarget(VertexArrayType::kVertexArray)));
 }
+#endif
 
-inline bool IsBound(const VertexArray& vao) {
-  GLint currently_bound_vao;
-  gl(GetIntegerv(GLenum(GetBindingTarget(VertexArrayType::kVertexArray)),
-                 &currently_bound_vao));
-  return vao.expose() == GLuint(currently_bound_vao);
+// Vertex buffer binding points (ARB_vertex_attrib_binding)
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindVertexBuffer)
+/**
+ * @brief Binds a buffer to a vertex buffer binding point of the currently
+ *        bound VAO.
+ *
+ * The attributes associated with the binding point (see
+ * VertexAttribObject::binding()) will source their data from this buffer.
+ * @param binding_index  The index of the vertex buffer binding point.
+ * @param buffer         The buffer to bind.
+ * @param offset         The offset of the first element in the buffer.
+ * @param stride         The distance between two vertices in the buffer.
+ * @see glBindVertexBuffer
+ */
+inline void BindVertexBuffer(GLuint binding_index, const ArrayBuffer& buffer,
+                             GLintptr offset, GLsizei stride) {
+  gl(BindVertexBuffer(binding_index, buffer.expose(), offset, stride));
+}
+
+/// Detaches the buffer from a vertex buffer binding point.
+/** @see glBindVertexBuffer */
+inline void UnbindVertexBuffer(GLuint binding_index) {
+  gl(BindVertexBuffer(binding_index, 0, 0, 0));
+}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindVertexBuffers)
+/**
+ * @brief Binds count buffers to consecutive vertex buffer binding points
+ *        with a single call.
+ *
+ * @param first    The first binding point.
+ * @param count    The number of binding points to change.
+ * @param buffers  The buffer handles (ArrayBuffer::expose()), or nullptr to
+ *                 detach every buffer in the range.
+ * @param offsets  The offsets of the first elements in the buffers.
+ * @param strides  The distances between two vertices in the buffers.
+ * @see glBindVertexBuffers
+ * @version OpenGL 4.4
+ */
+inline void BindVertexBuffers(GLuint first, GLsizei count,
+                              const GLuint* buffers,
+                              const GLintptr* offsets,
+                              const GLsizei* strides) {
+  gl(BindVertexBuffers(first, count, buffers, offsets, strides));
+}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glVertexBindingDivisor)
+/**
+ * @brief Modifies the rate at which the attributes sourced from a binding
+ *        point advance during instanced rendering.
+ *
+ * @param binding_index  The index of the vertex buffer binding point.
+ * @param divisor        The number of instances that will pass between
+ *                       updates of the attributes.
+ * @see glVertexBindingDivisor
+ */
+inline void VertexBindingDivisor(GLuint binding_index, GLuint divisor) {
+  gl(VertexBindingDivisor(binding_index, divisor));
 }
 #endif
 
 // Texture
+inline void ActiveTexture(GLuint tex_unit) {
+  if (CacheState(&StateCache::active_texture, tex_unit)) {
+    gl(ActiveTexture(GL_TEXTURE0 + tex_unit));
+  }
+}
+
+inline void Unbind(TextureType texture_t) {
+  if (StateCache::Current() &&
+      !CacheTextureBinding(GLenum(GetBindingTarget(texture_t)), 0)) {
+    return;
+  }
+  gl(BindTexture(GLenum(texture_t), 0));
+}
+
 template <TextureType texture_t>
 void Bind(const TextureBase<texture_t>& tex) {
+  if (StateCache::Current() &&
+      !CacheTextureBinding(GLenum(GetBindingTarget(texture_t)),
+                           tex.expose())) {
+    return;
+  }
   gl(BindTexture(GLenum(texture_t), tex.expose()));
 }
 
 template <TextureType texture_t>
 void BindToTexUnit(const TextureBase<texture_t>& tex, GLuint tex_unit) {
-  gl(ActiveTexture(GL_TEXTURE0 + tex_unit));
-  gl(BindTexture(GLenum(texture_t), tex.expose()));
+  ActiveTexture(tex_unit);
+  Bind(tex);
 }
 
 template <TextureType texture_t>
 void Unbind(const TextureBase<texture_t>& tex) {
-  gl(BindTexture(GLenum(texture_t), 0));
+  Unbind(texture_t);
 }
 
-inline void Unbind(TextureType texture_t) {
-  gl(BindTexture(GLenum(texture_t), 0));
+inline void UnbindFromTexUnit(TextureType texture_t, GLuint tex_unit) {
+  ActiveTexture(tex_unit);
+  Unbind(texture_t);
 }
 
 template <TextureType texture_t>
 void UnbindFromTexUnit(const TextureBase<texture_t>& tex, GLuint tex_unit) {
-  gl(ActiveTexture(GL_TEXTURE0 + tex_unit));
-  gl(BindTexture(GLenum(texture_t), 0));
+  UnbindFromTexUnit(texture_t, tex_unit);
 }
 
-inline void UnbindFromTexUnit(TextureType texture_t, GLuint tex_unit) {
-  gl(ActiveTexture(GL_TEXTURE0 + tex_unit));
-  gl(BindTexture(GLenum(texture_t), 0));
+template <TextureType texture_t>
+bool IsBound(const TextureBase<texture_t>& tex) {
+  return tex.expose() == CachedBoundTexture(GLenum(GetBindingTarget(texture_t)));
+}
+
+// Multi-bind (OpenGL 4.4 or ARB_multi_bind)
+/// Returns if the multi-bind functions (glBindTextures, glBindSamplers,
+/// glBindBuffersBase, ...) can be used.
+/** It is checked once, with the context that is current at the first call.
+  * The BindTextures, BindSamplers, BindBuffersBase and BindBuffersRange
+  * functions fall back to binding one by one without them. */
+inline bool MultiBindSupported() {
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glBindTextures) && defined(glBindSamplers) \
+        && defined(glBindBuffersBase) && defined(glBindBuffersRange) \
+        && defined(glGetStringi))
+  static const bool supported = IsFeatureSupported(4, 4, "GL_ARB_multi_bind");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+/// Narrows the range [0, count) of a multi-bind to the part, that contains
+/// every binding, that isn't known to be bound already.
+/** Returns false if every binding is known to be bound. */
+template <typename IsBound>
+inline bool NarrowMultiBind(GLsizei count, IsBound is_bound,
+                            GLsizei* begin, GLsizei* end) {
+  while (*begin < count && is_bound(*begin)) {
+    ++*begin;
+  }
+  if (*begin == count) {
+    return false;
+  }
+  *end = count;
+  while (is_bound(*end - 1)) {
+    --*end;
+  }
+  return true;
+}
+
+/**
+ * @brief Binds count textures to consecutive texture units with a single
+ *        call.
+ *
+ * The textures are bound to their own targets, and the active texture unit
+ * doesn't change. While a StateCache is current, only the range of the units,
+ * that have a different texture bound is rebound (or nothing at all).
+ * @param first     The first texture unit.
+ * @param count     The number of units to change.
+ * @param textures  The texture handles, or nullptr to unbind the targets.
+ * @param targets   The targets of the textures (like GL_TEXTURE_2D). Required
+ *                  even when unbinding: glBindTextures with nullptr resets
+ *                  every target of the units, but without multi-bind only
+ *                  the given targets are reset.
+ * @see glBindTextures
+ * @version OpenGL 4.4
+ */
+inline void BindTextures(GLuint first, GLsizei count, const GLuint* textures,
+                         const GLenum* targets) {
+  assert(targets);
+  StateCache* cache = StateCache::Current();
+  GLsizei begin = 0, end = count;
+  if (cache && textures && !NarrowMultiBind(count, [&](GLsizei i) {
+        CachedState<StateCache::Binding>& bound = cache->textureBinding(
+            GLenum(GetBindingTarget(TextureType(targets[i]))), first + i);
+        return bound.known() && bound.value().name == textures[i];
+      }, &begin, &end)) {
+    cache->countSkippedCall();
+    return;
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindTextures)
+  if (MultiBindSupported()) {
+    gl(BindTextures(first + begin, end - begin,
+                    textures ? textures + begin : nullptr));
+  } else
+#endif
+  {
+    GLuint active_unit = CachedActiveTexture();
+    for (GLsizei i = begin; i < end; ++i) {
+      ActiveTexture(first + i);
+      gl(BindTexture(targets[i], textures ? textures[i] : 0));
+    }
+    ActiveTexture(active_unit);
+  }
+
+  if (cache) {
+    for (GLsizei i = begin; i < end; ++i) {
+      if (textures) {
+        cache->textureBinding(
+            GLenum(GetBindingTarget(TextureType(targets[i]))), first + i)
+            .set(StateCache::Binding{textures[i], 0, 0});
+      } else {
+        cache->forgetTextureUnit(first + i);
+      }
+    }
+  }
 }
 
 template <TextureType texture_t>
-bool IsBound(const TextureBase<texture_t>& tex) {
-  GLint currently_bound_texture;
-  gl(GetIntegerv(GLenum(GetBindingTarget(texture_t)), &currently_bound_texture));
-  return tex.expose() == GLuint(currently_bound_texture);
+GLenum TextureTargetOf(const TextureBase<texture_t>&) {
+  return GLenum(texture_t);
+}
+
+/// Binds the textures to consecutive texture units, starting from first.
+/** The textures can be of different types.
+  * @code
+  *   gl::BindTextures(0, material.diffuse, material.normal_map,
+  *                    environment_cube_map);
+  * @endcode
+  * @see BindTextures(GLuint, GLsizei, const GLuint*, const GLenum*) */
+template <TextureType texture_t, typename... Textures>
+void BindTextures(GLuint first, const TextureBase<texture_t>& texture,
+                  const Textures&... textures) {
+  const GLuint names[] = {GLuint(texture.expose()),
+                          GLuint(textures.expose())...};
+  const GLenum targets[] = {GLenum(texture_t), TextureTargetOf(textures)...};
+  BindTextures(first, GLsizei(1 + sizeof...(textures)), names, targets);
+}
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindSampler)
+/**
+ * @brief Binds count sampler objects to consecutive texture units with a
+ *        single call.
+ *
+ * While a StateCache is current, only the range of the units, that have a
+ * different sampler bound is rebound (or nothing at all).
+ * @param first     The first texture unit.
+ * @param count     The number of units to change.
+ * @param samplers  The sampler handles, or nullptr to unbind the samplers.
+ * @see glBindSamplers
+ * @version OpenGL 4.4
+ */
+inline void BindSamplers(GLuint first, GLsizei count, const GLuint* samplers) {
+  StateCache* cache = StateCache::Current();
+  GLsizei begin = 0, end = count;
+  if (cache && !NarrowMultiBind(count, [&](GLsizei i) {
+        CachedState<StateCache::Binding>& bound =
+            cache->binding(GL_SAMPLER_BINDING, first + i);
+        return bound.known() &&
+               bound.value().name == (samplers ? samplers[i] : 0);
+      }, &begin, &end)) {
+    cache->countSkippedCall();
+    return;
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindSamplers)
+  if (MultiBindSupported()) {
+    gl(BindSamplers(first + begin, end - begin,
+                    samplers ? samplers + begin : nullptr));
+  } else
+#endif
+  {
+    for (GLsizei i = begin; i < end; ++i) {
+      gl(BindSampler(first + i, samplers ? samplers[i] : 0));
+    }
+  }
+
+  if (cache) {
+    for (GLsizei i = begin; i < end; ++i) {
+      cache->binding(GL_SAMPLER_BINDING, first + i).set(
+          StateCache::Binding{samplers ? samplers[i] : 0, 0, 0});
+    }
+  }
 }
+#endif
 
-inline void ActiveTexture(GLuint tex_unit) {
-  gl(ActiveTexture(GL_TEXTURE0 + tex_unit));
+#if OGLWRAP_DEFINE_EVERYTHING || \
+    (defined(glGenSamplers) && defined(glDeleteSamplers) && \
+     defined(glSamplerParameteri) && defined(glBindSampler))
+/// Binds a sampler to a texture unit.
+/** Unlike textures, samplers are bound to a unit without changing the active
+  * texture unit.
+  * @see glBindSampler */
+inline void Bind(const Sampler& sampler, GLuint unit) {
+  if (CacheBinding(GL_SAMPLER_BINDING, unit, sampler.expose())) {
+    gl(BindSampler(unit, sampler.expose()));
+  }
+}
+
+/// Unbinds the sampler of a texture unit, so the unit uses the parameters
+/// of its texture again.
+/** @see glBindSampler */
+inline void UnbindSampler(GLuint unit) {
+  if (CacheBinding(GL_SAMPLER_BINDING, unit, 0)) {
+    gl(BindSampler(unit, 0));
+  }
+}
+
+/// Returns if the sampler is bound to the texture unit.
+inline bool IsBound(const Sampler& sampler, GLuint unit) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    CachedState<StateCache::Binding>& bound =
+        cache->binding(GL_SAMPLER_BINDING, unit);
+    if (bound.known()) {
+      return bound.value().name == sampler.expose();
+    }
+  }
+  GLuint active_unit = CachedActiveTexture();
+  ActiveTexture(unit);
+  GLint name;
+  gl(GetIntegerv(GL_SAMPLER_BINDING, &name));
+  ActiveTexture(active_unit);
+  if (cache) {
+    cache->binding(GL_SAMPLER_BINDING, unit).set(
+        StateCache::Binding{GLuint(name), 0, 0});
+    cache->countQuery();
+  }
+  return GLuint(name) == sampler.expose();
+}
+
+/// Binds the samplers to consecutive texture units, starting from first.
+/** @code
+  *   gl::BindTextures(0, material.diffuse, material.normal_map);
+  *   gl::BindSamplers(0, samplers.get(trilinear), samplers.get(trilinear));
+  * @endcode
+  * @see BindSamplers(GLuint, GLsizei, const GLuint*) */
+template <typename... Samplers>
+void BindSamplers(GLuint first, const Sampler& sampler,
+                  const Samplers&... samplers) {
+  const GLuint names[] = {GLuint(sampler.expose()),
+                          GLuint(samplers.expose())...};
+  BindSamplers(first, GLsizei(1 + sizeof...(samplers)), names);
+}
+#endif  // glGenSamplers && glBindSampler
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBufferRange)
+/**
+ * @brief Binds count buffers (or ranges of them) to consecutive indices of
+ *        an indexed buffer target with a single call.
+ *
+ * Unlike BindBase() and BindRange(), the generic binding point of the target
+ * doesn't change. While a StateCache is current, only the range of the
+ * indices, that have a different buffer (or range) bound is rebound.
+ * @param type     The indexed buffer target.
+ * @param first    The first index.
+ * @param count    The number of indices to change.
+ * @param buffers  The buffer handles, or nullptr to unbind the indices.
+ * @param offsets  The start of the ranges, or nullptr to bind whole buffers.
+ * @param sizes    The sizes of the ranges, or nullptr to bind whole buffers.
+ * @see glBindBuffersBase, glBindBuffersRange
+ * @version OpenGL 4.4
+ */
+inline void BindBuffersRange(IndexedBufferType type, GLuint first,
+                             GLsizei count, const GLuint* buffers,
+                             const GLintptr* offsets = nullptr,
+                             const GLsizeiptr* sizes = nullptr) {
+  bool ranges = buffers && offsets && sizes;
+  auto binding_of = [&](GLsizei i) {
+    return StateCache::Binding{buffers ? buffers[i] : 0,
+                               ranges ? offsets[i] : 0,
+                               ranges ? sizes[i] : 0};
+  };
+
+  StateCache* cache = StateCache::Current();
+  GLenum binding = GLenum(GetBindingTarget(type));
+  GLsizei begin = 0, end = count;
+  if (cache && !NarrowMultiBind(count, [&](GLsizei i) {
+        CachedState<StateCache::Binding>& bound =
+            cache->binding(binding, first + i);
+        return bound.known() && bound.value() == binding_of(i);
+      }, &begin, &end)) {
+    cache->countSkippedCall();
+    return;
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glBindBuffersBase) && defined(glBindBuffersRange))
+  if (MultiBindSupported()) {
+    const GLuint* names = buffers ? buffers + begin : nullptr;
+    if (ranges) {
+      gl(BindBuffersRange(GLenum(type), first + begin, end - begin, names,
+                          offsets + begin, sizes + begin));
+    } else {
+      gl(BindBuffersBase(GLenum(type), first + begin, end - begin, names));
+    }
+  } else
+#endif
+  {
+    for (GLsizei i = begin; i < end; ++i) {
+      StateCache::Binding bound = binding_of(i);
+      if (ranges) {
+        gl(BindBufferRange(GLenum(type), first + i, bound.name,
+                           bound.offset, bound.size));
+      } else {
+        gl(BindBufferBase(GLenum(type), first + i, bound.name));
+      }
+    }
+    // Binding one by one changes the generic binding point too.
+    if (cache) {
+      cache->binding(binding).set(
+          StateCache::Binding{binding_of(end - 1).name, 0, 0});
+    }
+  }
+
+  if (cache) {
+    for (GLsizei i = begin; i < end; ++i) {
+      cache->binding(binding, first + i).set(binding_of(i));
+    }
+  }
+}
+
+/// Binds count buffers to consecutive indices of an indexed buffer target
+/// with a single call.
+/** @see BindBuffersRange, glBindBuffersBase */
+inline void BindBuffersBase(IndexedBufferType type, GLuint first,
+                            GLsizei count, const GLuint* buffers) {
+  BindBuffersRange(type, first, count, buffers);
+}
+
+template <IndexedBufferType BUFFER_TYPE>
+GLuint IndexedBufferName(const IndexedBufferObject<BUFFER_TYPE>& buffer) {
+  return buffer.expose();
+}
+
+/// Binds the buffers to consecutive indices, starting from first.
+/** The buffers must be of the same type.
+  * @code
+  *   gl::BindBuffersBase(0, camera_ubo, lights_ubo, material_ubo);
+  * @endcode
+  * @see BindBuffersBase(IndexedBufferType, GLuint, GLsizei, const GLuint*) */
+template <IndexedBufferType BUFFER_TYPE, typename... Buffers>
+void BindBuffersBase(GLuint first,
+                     const IndexedBufferObject<BUFFER_TYPE>& buffer,
+                     const Buffers&... buffers) {
+  const GLuint names[] = {GLuint(buffer.expose()),
+                          IndexedBufferName<BUFFER_TYPE>(buffers)...};
+  BindBuffersRange(BUFFER_TYPE, first, GLsizei(1 + sizeof...(buffers)),
+                   names);
 }
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindImageTextures)
+/**
+ * @brief Binds the level 0 of count textures to consecutive image units with
+ *        a single call, with read-write access and their internal format.
+ *
+ * There is no fallback for older contexts, as glBindImageTexture would need
+ * the internal formats. The image units are not tracked by the StateCache.
+ * @param first     The first image unit.
+ * @param count     The number of image units to change.
+ * @param textures  The texture handles, or nullptr to unbind the units.
+ * @see glBindImageTextures
+ * @version OpenGL 4.4
+ */
+inline void BindImageTextures(GLuint first, GLsizei count,
+                              const GLuint* textures) {
+  gl(BindImageTextures(first, count, textures));
+}
+
+/// Binds the level 0 of the textures to consecutive image units, starting
+/// from first.
+/** @see BindImageTextures(GLuint, GLsizei, const GLuint*) */
+template <TextureType texture_t, typename... Textures>
+void BindImageTextures(GLuint first, const TextureBase<texture_t>& texture,
+                       const Textures&... textures) {
+  const GLuint names[] = {GLuint(texture.expose()),
+                          GLuint(textures.expose())...};
+  BindImageTextures(first, GLsizei(1 + sizeof...(textures)), names);
+}
+#endif
 
 // Program
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glUseProgram)
@@ -225,38 +726,39 @@ inline void Bind(const Program& prog) {
     const_cast<Program&>(prog).link();
   }
 #endif
-  gl(UseProgram(prog.expose()));
+  if (CacheBinding(GL_CURRENT_PROGRAM, StateCache::kNoIndex, prog.expose())) {
+    gl(UseProgram(prog.expose()));
+  }
 }
 
 inline void Use(const Program& prog) {
   Bind(prog);
 }
 
-inline void Unbind(const Program&) {
-  gl(UseProgram(0));
+inline void UnbindProgram() {
+  if (CacheBinding(GL_CURRENT_PROGRAM, StateCache::kNoIndex, 0)) {
+    gl(UseProgram(0));
+  }
 }
 
-inline void Unuse(const Program&) {
-  gl(UseProgram(0));
+inline void UnuseProgram() {
+  UnbindProgram();
 }
 
-inline void UnbindProgram() {
-  gl(UseProgram(0));
+inline void Unbind(const Program&) {
+  UnbindProgram();
 }
 
-inline void UnuseProgram() {
-  gl(UseProgram(0));
+inline void Unuse(const Program&) {
+  UnbindProgram();
 }
 
 inline bool IsBound(const Program& prog) {
-  GLint current_program;
-  gl(GetIntegerv(GL_CURRENT_PROGRAM, &current_program));
-
 #if OGLWRAP_DEBUG
   DebugOutput::LastUsedBindTarget() = "GL_CURRENT_PROGRAM";
 #endif
 
-  return prog.expose() == GLuint(current_program);
+  return prog.expose() == CachedBoundName(GL_CURRENT_PROGRAM);
 }
 
 inline bool IsActive(const Program& prog) {
@@ -264,6 +766,142 @@ inline bool IsActive(const Program& prog) {
 }
 #endif
 
+/**
+ * @brief Binds an object, and binds the previously bound one back when the
+ *        variable goes out of scope.
+ *
+ * The old binding is read from the current StateCache (or queried without
+ * one), and nothing is bound if the object is already bound. Textures are
+ * bound to the texture unit, that is active when the guard is created, and
+ * that unit must be active when it is destroyed. A guard of a Framebuffer
+ * (GL_FRAMEBUFFER) restores the old draw framebuffer to both bindings.
+ * @code
+ *   {
+ *     gl::TemporaryBind bind(buffer);
+ *     buffer.subData(...);
+ *   }  // the previous array buffer is bound again
+ * @endcode
+ */
+class TemporaryBind {
+ public:
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBuffer)
+  template<BufferType BUFFER_TYPE>
+  explicit TemporaryBind(const BufferObject<BUFFER_TYPE>& buffer)
+      : TemporaryBind(GLenum(BUFFER_TYPE),
+                      GLenum(GetBindingTarget(BUFFER_TYPE)),
+                      CachedBoundName(GLenum(GetBindingTarget(BUFFER_TYPE))),
+                      buffer.expose(), &BindBufferName) {}
+#endif
+
+  template <TextureType texture_t>
+  explicit TemporaryBind(const TextureBase<texture_t>& tex)
+      : TemporaryBind(GLenum(texture_t), GLenum(GetBindingTarget(texture_t)),
+                      CachedBoundTexture(GLenum(GetBindingTarget(texture_t))),
+                      tex.expose(), &BindTextureName) {}
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindRenderbuffer)
+  explicit TemporaryBind(const Renderbuffer& buffer)
+      : TemporaryBind(GL_RENDERBUFFER, GL_RENDERBUFFER_BINDING,
+                      CachedBoundName(GL_RENDERBUFFER_BINDING),
+                      buffer.expose(), &BindRenderbufferName) {}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindFramebuffer)
+  template<FramebufferType FBO_TYPE>
+  explicit TemporaryBind(const FramebufferObject<FBO_TYPE>& fbo)
+      : TemporaryBind(GLenum(FBO_TYPE), GLenum(GetBindingTarget(FBO_TYPE)),
+                      CachedBoundName(GLenum(GetBindingTarget(FBO_TYPE))),
+                      fbo.expose(), &BindFramebufferName) {}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindVertexArray)
+  explicit TemporaryBind(const VertexArray& vao)
+      : TemporaryBind(GL_VERTEX_ARRAY, GL_VERTEX_ARRAY_BINDING,
+                      CachedBoundName(GL_VERTEX_ARRAY_BINDING),
+                      vao.expose(), &BindVertexArrayName) {}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glUseProgram)
+  explicit TemporaryBind(const Program& prog)
+      : TemporaryBind(GL_CURRENT_PROGRAM, GL_CURRENT_PROGRAM,
+                      CachedBoundName(GL_CURRENT_PROGRAM),
+                      prog.expose(), &UseProgramName) {}
+#endif
+
+  ~TemporaryBind() {
+    if (changed_) {
+      bind_(target_, binding_, old_name_);
+    }
+  }
+
+  TemporaryBind(const TemporaryBind&) = delete;
+  TemporaryBind& operator=(const TemporaryBind&) = delete;
+
+ private:
+  typedef void (*Binder)(GLenum target, GLenum binding, GLuint name);
+
+  GLenum target_, binding_;
+  GLuint old_name_;
+  Binder bind_;
+  bool changed_;
+
+  TemporaryBind(GLenum target, GLenum binding, GLuint old_name, GLuint name,
+                Binder bind)
+      : target_(target), binding_(binding), old_name_(old_name), bind_(bind)
+      , changed_(old_name != name) {
+    if (changed_) {
+      bind_(target_, binding_, name);
+    }
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindBuffer)
+  static void BindBufferName(GLenum target, GLenum binding, GLuint name) {
+    if (CacheBinding(binding, StateCache::kNoIndex, name)) {
+      gl(BindBuffer(target, name));
+    }
+  }
+#endif
+
+  static void BindTextureName(GLenum target, GLenum binding, GLuint name) {
+    if (CacheTextureBinding(binding, name)) {
+      gl(BindTexture(target, name));
+    }
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindRenderbuffer)
+  static void BindRenderbufferName(GLenum target, GLenum, GLuint name) {
+    if (CacheBinding(GL_RENDERBUFFER_BINDING, StateCache::kNoIndex, name)) {
+      gl(BindRenderbuffer(target, name));
+    }
+  }
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindFramebuffer)
+  static void BindFramebufferName(GLenum target, GLenum, GLuint name) {
+    if (CacheFramebufferBinding(FramebufferType(target), name)) {
+      gl(BindFramebuffer(target, name));
+    }
+  }
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBindVertexArray)
+  static void BindVertexArrayName(GLenum, GLenum, GLuint name) {
+    if (CacheBinding(GL_VERTEX_ARRAY_BINDING, StateCache::kNoIndex, name)) {
+      ForgetBindings(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+      gl(BindVertexArray(name));
+    }
+  }
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glUseProgram)
+  static void UseProgramName(GLenum, GLenum, GLuint name) {
+    if (CacheBinding(GL_CURRENT_PROGRAM, StateCache::kNoIndex, name)) {
+      gl(UseProgram(name));
+    }
+  }
+#endif
+};
+
 }  // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
@@ -9,6 +9,7 @@
 #include "../config.h"
 #include "../enums/blend_equation.h"
 #include "../enums/blend_function.h"
+#include "./state_cache.h"
 
 #include "../define_internal_macros.h"
 
@@ -22,7 +23,10 @@ namespace OGLWRAP_NAMESPACE_NAME {
  * @version 1.0
  */
 inline void BlendEquation(enums::BlendEquation eq) {
-  gl(BlendEquation(GLenum(eq)));
+  if (CacheState(&StateCache::blend_equation,
+                 glm::uvec2(GLenum(eq), GLenum(eq)))) {
+    gl(BlendEquation(GLenum(eq)));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendEquationi)
@@ -36,6 +40,7 @@ inline void BlendEquation(enums::BlendEquation eq) {
  * @version 4.0
  */
 inline void BlendEquation(GLuint buffer, enums::BlendEquation eq) {
+  ForgetCachedState(&StateCache::blend_equation);
   gl(BlendEquationi(buffer, GLenum(eq)));
 }
 #endif
@@ -54,7 +59,10 @@ inline void BlendEquation(GLuint buffer, enums::BlendEquation eq) {
  */
 inline void BlendEquationSeparate(enums::BlendEquation mode_rgb,
                                  enums::BlendEquation mode_a) {
-  gl(BlendEquationSeparate(GLenum(mode_rgb), GLenum(mode_a)));
+  if (CacheState(&StateCache::blend_equation,
+                 glm::uvec2(GLenum(mode_rgb), GLenum(mode_a)))) {
+    gl(BlendEquationSeparate(GLenum(mode_rgb), GLenum(mode_a)));
+  }
 }
 #endif
 
@@ -74,6 +82,7 @@ inline void BlendEquationSeparate(enums::BlendEquation mode_rgb,
  */
 inline void BlendEquationSeparate(GLuint buffer, enums::BlendEquation mode_rgb,
                                  enums::BlendEquation mode_a) {
+  ForgetCachedState(&StateCache::blend_equation);
   gl(BlendEquationSeparatei(buffer, GLenum(mode_rgb), GLenum(mode_a)));
 }
 #endif
@@ -83,7 +92,11 @@ inline void BlendEquationSeparate(GLuint buffer, enums::BlendEquation mode_rgb,
  * @version 1.0
  */
 inline void BlendFunc(enums::BlendFunction src, enums::BlendFunction dst) {
-  gl(BlendFunc(GLenum(src), GLenum(dst)));
+  if (CacheState(&StateCache::blend_func,
+                 glm::uvec4(GLenum(src), GLenum(dst),
+                            GLenum(src), GLenum(dst)))) {
+    gl(BlendFunc(GLenum(src), GLenum(dst)));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendFunci)
@@ -93,11 +106,12 @@ inline void BlendFunc(enums::BlendFunction src, enums::BlendFunction dst) {
  */
 inline void BlendFunc(GLuint buffer, enums::BlendFunction src,
                      enums::BlendFunction dst) {
+  ForgetCachedState(&StateCache::blend_func);
   gl(BlendFunci(buffer, GLenum(src), GLenum(dst)));
 }
 #endif
 
-#if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendFuncSeparatei)
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendFuncSeparate)
 /**
  * @see glBlendFuncSeparate
  * @version 1.4
@@ -106,8 +120,12 @@ inline void BlendFuncSeparate(enums::BlendFunction src_rgb,
                               enums::BlendFunction dst_rgb,
                               enums::BlendFunction src_a,
                               enums::BlendFunction dst_a) {
-  gl(BlendFuncSeparate(GLenum(src_rgb), GLenum(dst_rgb),
-                       GLenum(src_a), GLenum(dst_a)));
+  if (CacheState(&StateCache::blend_func,
+                 glm::uvec4(GLenum(src_rgb), GLenum(dst_rgb),
+                            GLenum(src_a), GLenum(dst_a)))) {
+    gl(BlendFuncSeparate(GLenum(src_rgb), GLenum(dst_rgb),
+                         GLenum(src_a), GLenum(dst_a)));
+  }
 }
 #endif
 
@@ -121,6 +139,7 @@ inline void BlendFuncSeparate(GLuint buffer,
                               enums::BlendFunction dst_rgb,
                               enums::BlendFunction src_a,
                               enums::BlendFunction dst_a) {
+  ForgetCachedState(&StateCache::blend_func);
   gl(BlendFuncSeparatei(buffer, GLenum(src_rgb), GLenum(dst_rgb),
                         GLenum(src_a), GLenum(dst_a)));
 }
@@ -131,7 +150,9 @@ inline void BlendFuncSeparate(GLuint buffer,
  * @version 1.0
  */
 inline void BlendColor(glm::vec4 blend_color) {
-  gl(BlendColor(blend_color.r, blend_color.g, blend_color.b, blend_color.a));
+  if (CacheState(&StateCache::blend_color, blend_color)) {
+    gl(BlendColor(blend_color.r, blend_color.g, blend_color.b, blend_color.a));
+  }
 }
 
 /**
@@ -140,9 +161,102 @@ inline void BlendColor(glm::vec4 blend_color) {
  */
 inline void BlendColor(GLfloat red, GLfloat green,
                        GLfloat blue, GLfloat alpha) {
-  gl(BlendColor(red, green, blue, alpha));
+  BlendColor(glm::vec4(red, green, blue, alpha));
+}
+
+/**
+ * @brief Returns the constant blend color.
+ * @see glGetFloatv, GL_BLEND_COLOR
+ * @version 1.0
+ */
+inline glm::vec4 GetBlendColor() {
+  return CachedQuery(&StateCache::blend_color, [] {
+    glm::vec4 data;
+    gl(GetFloatv(GL_BLEND_COLOR, &data.r));
+    return data;
+  });
+}
+
+/// Sets the constant blend color, and sets the old one back when the variable
+/// goes out of scope.
+class TemporaryBlendColor : TemporaryValue<glm::vec4> {
+ public:
+  explicit TemporaryBlendColor(glm::vec4 blend_color)
+      : TemporaryValue<glm::vec4>(GetBlendColor(), blend_color,
+                                  [](const glm::vec4& old_color) {
+                                    BlendColor(old_color);
+                                  }) {}
+};
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendEquationSeparate)
+/// Returns the RGB and the alpha blend equation.
+/** @see glGetIntegerv, GL_BLEND_EQUATION_RGB, GL_BLEND_EQUATION_ALPHA */
+inline glm::uvec2 CachedBlendEquation() {
+  return CachedQuery(&StateCache::blend_equation, [] {
+    GLint data[2];
+    gl(GetIntegerv(GL_BLEND_EQUATION_RGB, &data[0]));
+    gl(GetIntegerv(GL_BLEND_EQUATION_ALPHA, &data[1]));
+    return glm::uvec2(data[0], data[1]);
+  });
 }
 
+/// Sets the blend equations, and sets the old ones back when the variable goes
+/// out of scope.
+class TemporaryBlendEquation : TemporaryValue<glm::uvec2> {
+ public:
+  explicit TemporaryBlendEquation(enums::BlendEquation eq)
+      : TemporaryBlendEquation(eq, eq) {}
+
+  TemporaryBlendEquation(enums::BlendEquation mode_rgb,
+                         enums::BlendEquation mode_a)
+      : TemporaryValue<glm::uvec2>(
+          CachedBlendEquation(), glm::uvec2(GLenum(mode_rgb), GLenum(mode_a)),
+          [](const glm::uvec2& old_eq) {
+            BlendEquationSeparate(enums::BlendEquation(old_eq.x),
+                                  enums::BlendEquation(old_eq.y));
+          }) {}
+};
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glBlendFuncSeparate)
+/// Returns the source and destination blend functions of the RGB and the
+/// alpha components.
+/** @see glGetIntegerv, GL_BLEND_SRC_RGB, GL_BLEND_DST_RGB,
+  *      GL_BLEND_SRC_ALPHA, GL_BLEND_DST_ALPHA */
+inline glm::uvec4 CachedBlendFunc() {
+  return CachedQuery(&StateCache::blend_func, [] {
+    GLint data[4];
+    gl(GetIntegerv(GL_BLEND_SRC_RGB, &data[0]));
+    gl(GetIntegerv(GL_BLEND_DST_RGB, &data[1]));
+    gl(GetIntegerv(GL_BLEND_SRC_ALPHA, &data[2]));
+    gl(GetIntegerv(GL_BLEND_DST_ALPHA, &data[3]));
+    return glm::uvec4(data[0], data[1], data[2], data[3]);
+  });
+}
+
+/// Sets the blend functions, and sets the old ones back when the variable
+/// goes out of scope.
+class TemporaryBlendFunc : TemporaryValue<glm::uvec4> {
+ public:
+  TemporaryBlendFunc(enums::BlendFunction src, enums::BlendFunction dst)
+      : TemporaryBlendFunc(src, dst, src, dst) {}
+
+  TemporaryBlendFunc(enums::BlendFunction src_rgb,
+                     enums::BlendFunction dst_rgb,
+                     enums::BlendFunction src_a,
+                     enums::BlendFunction dst_a)
+      : TemporaryValue<glm::uvec4>(
+          CachedBlendFunc(), glm::uvec4(GLenum(src_rgb), GLenum(dst_rgb),
+                                        GLenum(src_a), GLenum(dst_a)),
+          [](const glm::uvec4& old_func) {
+            BlendFuncSeparate(enums::BlendFunction(old_func.x),
+                              enums::BlendFunction(old_func.y),
+                              enums::BlendFunction(old_func.z),
+                              enums::BlendFunction(old_func.w));
+          }) {}
+};
+#endif
+
 } // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
@@ -8,6 +8,7 @@
 
 #include "../config.h"
 #include "../enums/buffer_select_bit.h"
+#include "./state_cache.h"
 
 #include "../define_internal_macros.h"
 
@@ -16,48 +17,60 @@ namespace OGLWRAP_NAMESPACE_NAME {
 /// Specify clear values for the color buffers.
 /** @see glClearColor */
 inline void ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
-	gl(ClearColor(r, g, b, a));
+	if (CacheState(&StateCache::clear_color, glm::vec4(r, g, b, a))) {
+		gl(ClearColor(r, g, b, a));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_COLOR_CLEAR_VALUE)
 /// Returns the clear values for the color buffers.
 /** @see glGetFloatv, GL_COLOR_CLEAR_VALUE */
 inline glm::vec4 GetClearColor() {
-	GLfloat data[4];
-	gl(GetFloatv(GL_COLOR_CLEAR_VALUE, data));
-	return glm::vec4(data[0], data[1], data[2], data[3]);
+	return CachedQuery(&StateCache::clear_color, [] {
+		GLfloat data[4];
+		gl(GetFloatv(GL_COLOR_CLEAR_VALUE, data));
+		return glm::vec4(data[0], data[1], data[2], data[3]);
+	});
 }
 #endif
 
 /// Specify the clear value for the depth buffers.
 /** @see glClearDepth */
 inline void ClearDepth(GLdouble d) {
-	gl(ClearDepth(d));
+	if (CacheState(&StateCache::clear_depth, d)) {
+		gl(ClearDepth(d));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_DEPTH_CLEAR_VALUE)
 /// Returns the clear value for the depth buffers.
 /** @see glGetDoublev, GL_DEPTH_CLEAR_VALUE */
 inline double GetClearDepth() {
-	GLdouble data;
-	gl(GetDoublev(GL_DEPTH_CLEAR_VALUE, &data));
-	return data;
+	return CachedQuery(&StateCache::clear_depth, [] {
+		GLdouble data;
+		gl(GetDoublev(GL_DEPTH_CLEAR_VALUE, &data));
+		return data;
+	});
 }
 #endif
 
 /// Specify the clear value for the stencil buffers.
 /** @see glClearStencil */
 inline void ClearStencil(GLuint mask) {
-	gl(ClearStencil(mask));
+	if (CacheState(&StateCache::clear_stencil, GLint(mask))) {
+		gl(ClearStencil(mask));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_STENCIL_CLEAR_VALUE)
 /// Returns the clear value for the stencil buffers.
 /** @see GetIntegerv, GL_STENCIL_CLEAR_VALUE */
 inline GLuint GetClearStencil() {
-	GLuint data;
-	gl(GetIntegerv(GL_STENCIL_CLEAR_VALUE, reinterpret_cast<GLint*>(&data)));
-	return data;
+	return GLuint(CachedQuery(&StateCache::clear_stencil, [] {
+		GLint data;
+		gl(GetIntegerv(GL_STENCIL_CLEAR_VALUE, &data));
+		return data;
+	}));
 }
 #endif
 
@@ -6,6 +6,7 @@
 #include <tuple>
 #include "../config.h"
 #include "../enums/face.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
@@ -13,24 +14,48 @@ namespace OGLWRAP_NAMESPACE_NAME {
 /// Enables and disables writing of frame buffer color components.
 /** @see glColorMask */
 inline void ColorMask(bool r, bool g, bool b, bool a) {
-  gl(ColorMask(r, g, b, a));
+  if (CacheState(&StateCache::color_mask, glm::bvec4(r, g, b, a))) {
+    gl(ColorMask(r, g, b, a));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_COLOR_WRITEMASK)
 /// Returns the color mask.
 /** @see glGetBooleanv, GL_COLOR_WRITEMASK */
 inline std::tuple<bool, bool, bool, bool> ColorMask() {
-  GLboolean data[4];
-  gl(GetBooleanv(GL_COLOR_WRITEMASK, data));
-  return std::tuple<bool, bool, bool, bool>(
-            data[0], data[1], data[2], data[3]);
+  glm::bvec4 mask = CachedQuery(&StateCache::color_mask, [] {
+    GLboolean data[4];
+    gl(GetBooleanv(GL_COLOR_WRITEMASK, data));
+    return glm::bvec4(data[0], data[1], data[2], data[3]);
+  });
+  return std::tuple<bool, bool, bool, bool>(mask.r, mask.g, mask.b, mask.a);
 }
+
+/// Sets the color mask, and sets the old one back when the variable goes
+/// out of scope.
+class TemporaryColorMask : TemporaryValue<glm::bvec4> {
+ public:
+  TemporaryColorMask(bool r, bool g, bool b, bool a)
+      : TemporaryValue<glm::bvec4>(CurrentMask(), glm::bvec4(r, g, b, a),
+                                   [](const glm::bvec4& old_mask) {
+                                     ColorMask(old_mask.r, old_mask.g,
+                                               old_mask.b, old_mask.a);
+                                   }) {}
+
+ private:
+  static glm::bvec4 CurrentMask() {
+    bool r, g, b, a;
+    std::tie(r, g, b, a) = ColorMask();
+    return glm::bvec4(r, g, b, a);
+  }
+};
 #endif
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glColorMaski)
 /// Enables and disables writing of frame buffer color components for a particular buffer.
 /** @see glColorMaski */
 inline void ColorMask(GLuint buffer, bool r, bool g, bool b, bool a) {
+  ForgetCachedState(&StateCache::color_mask);
   gl(ColorMaski(buffer, r, g, b, a));
 }
 #endif
@@ -38,30 +63,71 @@ inline void ColorMask(GLuint buffer, bool r, bool g, bool b, bool a) {
 /// Enables or disables writing into the depth buffer.
 /** @see glDepthMask */
 inline void DepthMask(bool mask) {
-  gl(DepthMask(mask));
+  if (CacheState(&StateCache::depth_mask, mask)) {
+    gl(DepthMask(mask));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_DEPTH_WRITEMASK)
 /// Returns the depth mask.
 /** @see glGetBooleanv, GL_DEPTH_WRITEMASK */
 inline bool DepthMask() {
-  GLboolean data;
-  gl(GetBooleanv(GL_DEPTH_WRITEMASK, &data));
-  return data;
+  return CachedQuery(&StateCache::depth_mask, [] {
+    GLboolean data;
+    gl(GetBooleanv(GL_DEPTH_WRITEMASK, &data));
+    return data != GL_FALSE;
+  });
 }
+
+/// Enables or disables writing into the depth buffer, and sets the old mask
+/// back when the variable goes out of scope.
+class TemporaryDepthMask : TemporaryValue<bool> {
+ public:
+  explicit TemporaryDepthMask(bool mask)
+      : TemporaryValue<bool>(DepthMask(), mask, [](const bool& old_mask) {
+          DepthMask(old_mask);
+        }) {}
+};
 #endif
 
+/// Stores the stencil write mask of the specified faces in the current
+/// StateCache.
+/** Returns if the GL call, that sets the value, has to be made. */
+inline bool CacheStencilMask(Face face, GLuint mask) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  bool changed = false;
+  if (face != Face::kBack) {
+    changed |= cache->stencil_mask.set(mask);
+  }
+  if (face != Face::kFront) {
+    changed |= cache->stencil_back_mask.set(mask);
+  }
+  if (changed) {
+    cache->stateChanged();
+  } else {
+    cache->countSkippedCall();
+  }
+  return changed;
+}
+
 /// Controls the front and back writing of individual bits in the stencil planes.
 /** @see glStencilMask */
 inline void StencilMask(GLuint mask) {
-  gl(StencilMask(mask));
+  if (CacheStencilMask(Face::kFrontAndBack, mask)) {
+    gl(StencilMask(mask));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glStencilMaskSeparate)
 /// Control the front and/or back writing of individual bits in the stencil planes.
 /** @see glStencilMaskSeparate */
 inline void StencilMask(Face face, GLuint mask) {
-  gl(StencilMaskSeparate(GLenum(face), mask));
+  if (CacheStencilMask(face, mask)) {
+    gl(StencilMaskSeparate(GLenum(face), mask));
+  }
 }
 #endif
 
@@ -69,14 +135,39 @@ inline void StencilMask(Face face, GLuint mask) {
 /// Returns the value of stencil write mask for the specified face.
 /** @see glGetIntegerv, GL_STENCIL_WRITEMASK, GL_STENCIL_BACK_WRITEMASK */
 inline GLuint StencilMask(bool front_face = true) {
-  GLuint data;
-  if (front_face) {
-    glGetIntegerv(GL_STENCIL_WRITEMASK, reinterpret_cast<GLint*>(&data));
-  } else {
-    glGetIntegerv(GL_STENCIL_BACK_WRITEMASK, reinterpret_cast<GLint*>(&data));
-  }
-  return data;
+  return CachedQuery(front_face ? &StateCache::stencil_mask
+                                : &StateCache::stencil_back_mask, [front_face] {
+    GLuint data;
+    if (front_face) {
+      gl(GetIntegerv(GL_STENCIL_WRITEMASK, reinterpret_cast<GLint*>(&data)));
+    } else {
+      gl(GetIntegerv(GL_STENCIL_BACK_WRITEMASK,
+                     reinterpret_cast<GLint*>(&data)));
+    }
+    return data;
+  });
 }
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glStencilMaskSeparate)
+/// Sets the stencil write mask of the front and/or back faces, and sets the
+/// old masks back when the variable goes out of scope.
+class TemporaryStencilMask {
+ public:
+  explicit TemporaryStencilMask(GLuint mask, Face face = Face::kFrontAndBack)
+      : front_(StencilMask(true), face != Face::kBack ? mask : StencilMask(true),
+               [](const GLuint& old_mask) {
+                 StencilMask(Face::kFront, old_mask);
+               })
+      , back_(StencilMask(false),
+              face != Face::kFront ? mask : StencilMask(false),
+              [](const GLuint& old_mask) {
+                StencilMask(Face::kBack, old_mask);
+              }) {}
+
+ private:
+  TemporaryValue<GLuint> front_, back_;
+};
+#endif
 #endif
 
 } // namespace oglwrap
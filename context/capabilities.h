@@ -8,21 +8,49 @@
 
 #include "../config.h"
 #include "../enums/capability.h"
+#include "./state_cache.h"
 
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
+/// Stores the value of a capability in the current StateCache.
+/** Returns if the GL call, that sets the value, has to be made. */
+inline bool CacheCapability(Capability capability, bool value) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  if (cache->capability(GLenum(capability)).set(value)) {
+    cache->stateChanged();
+    return true;
+  }
+  cache->countSkippedCall();
+  return false;
+}
+
+/// Marks the value of a capability unknown in the current StateCache.
+inline void ForgetCachedCapability(Capability capability) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    cache->capability(GLenum(capability)).forget();
+    cache->stateChanged();
+  }
+}
+
 /// Enables a capability.
 /** @see glEnable */
 inline void Enable(Capability capability) {
-  gl(Enable(GLenum(capability)));
+  if (CacheCapability(capability, true)) {
+    gl(Enable(GLenum(capability)));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glEnablei)
 /// Enables a capability for an index target.
 /** @see glEnablei */
 inline void Enable(Capability capability, GLuint index) {
+	ForgetCachedCapability(capability);
 	gl(Enablei(GLenum(capability), index));
 }
 #endif
@@ -30,13 +58,16 @@ inline void Enable(Capability capability, GLuint index) {
 /// Disables a capability.
 /** @see glDisable */
 inline void Disable(Capability capability) {
-	gl(Disable(GLenum(capability)));
+	if (CacheCapability(capability, false)) {
+		gl(Disable(GLenum(capability)));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glDisablei)
 /// Disables a capability for an index target.
 /** @see glDisablei */
 inline void Disable(Capability capability, GLuint index) {
+	ForgetCachedCapability(capability);
 	gl(Disablei(GLenum(capability), index));
 }
 #endif
@@ -44,7 +75,17 @@ inline void Disable(Capability capability, GLuint index) {
 /// Checks if a capability is enabled.
 /** @see glIsEnabled */
 inline bool IsEnabled(Capability capability) {
-	return gl(IsEnabled(GLenum(capability)));
+	StateCache* cache = StateCache::Current();
+	if (!cache) {
+		return gl(IsEnabled(GLenum(capability)));
+	}
+	CachedState<bool>& cached = cache->capability(GLenum(capability));
+	if (!cached.known()) {
+		GLboolean enabled = gl(IsEnabled(GLenum(capability)));
+		cached.set(enabled != GL_FALSE);
+		cache->countQuery();
+	}
+	return cached.value();
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glIsEnabledi)
@@ -5,6 +5,7 @@
 
 #include "../config.h"
 #include "../enums/compare_func.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
@@ -53,7 +54,9 @@ namespace OGLWRAP_NAMESPACE_NAME {
  * @version OpenGL 1.0
  */
 inline void DepthFunc(CompareFunc function) {
-  gl(DepthFunc(GLenum(function)));
+  if (CacheState(&StateCache::depth_func, GLenum(function))) {
+    gl(DepthFunc(GLenum(function)));
+  }
 }
 
 /**
@@ -62,11 +65,24 @@ inline void DepthFunc(CompareFunc function) {
  * @version OpenGL 1.0
  */
 inline CompareFunc DepthFunc() {
-  GLint data;
-  gl(GetIntegerv(GL_DEPTH_FUNC, &data));
-  return static_cast<CompareFunc>(data);
+  return static_cast<CompareFunc>(CachedQuery(&StateCache::depth_func, [] {
+    GLint data;
+    gl(GetIntegerv(GL_DEPTH_FUNC, &data));
+    return GLenum(data);
+  }));
 }
 
+/// Sets the depth function, and sets the old one back when the variable goes
+/// out of scope.
+class TemporaryDepthFunc : TemporaryValue<CompareFunc> {
+ public:
+  explicit TemporaryDepthFunc(CompareFunc function)
+      : TemporaryValue<CompareFunc>(DepthFunc(), function,
+                                    [](const CompareFunc& old_function) {
+                                      DepthFunc(old_function);
+                                    }) {}
+};
+
 } // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
@@ -4,6 +4,7 @@
 #define OGLWRAP_CONTEXT_DRAWING_H_
 
 #include "../config.h"
+#include "../buffer.h"
 #include "../enums/index_type.h"
 #include "../enums/primitive_type.h"
 
@@ -130,6 +131,29 @@ inline void DrawArraysInstancedBaseInstance(PrimType type,
 }
 #endif
 
+/// The parameters of a draw, that DrawArraysIndirect and
+/// MultiDrawArraysIndirect read from the GL_DRAW_INDIRECT_BUFFER.
+struct DrawArraysIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first;
+  GLuint base_instance;
+};
+static_assert(sizeof(DrawArraysIndirectCommand) == 4 * sizeof(GLuint),
+              "DrawArraysIndirectCommand must be tightly packed");
+
+/// The parameters of a draw, that DrawElementsIndirect and
+/// MultiDrawElementsIndirect read from the GL_DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(GLuint),
+              "DrawElementsIndirectCommand must be tightly packed");
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawArraysIndirect)
 /**
  * @brief Renders primitives from array data, taking parameters from memory.
@@ -819,14 +843,14 @@ inline void DrawElementsIndirect(PrimType type,
  *
  * @param type       Specifies what kind of primitives to render.
  * @param index_type Specifies the type of data in the IndexBuffer.
- * @param draw_count Specifies a byte offset (cast to a pointer type) into the
+ * @param draw_count Specifies the number of elements in the array addressed
+ *                   by indirect.
+ * @param stride     Specifies the distance in basic machine units between
+ *                   elements of the draw parameter array.
+ * @param indirect   Specifies a byte offset (cast to a pointer type) into the
  *                   buffer bound to GL_DRAW_INDIRECT_BUFFER​, which designates
  *                   the starting point of the structure containing the draw
  *                   parameters.
- * @param stride     Specifies the number of elements in the array addressed
- *                   by indirect.
- * @param indirect   Specifies the distance in basic machine units between
- *                   elements of the draw parameter array.
  * @see glMultiDrawElementsIndirect
  * @version OpenGL 4.3
  */
@@ -841,6 +865,45 @@ inline void MultiDrawElementsIndirect(PrimType type,
 }
 #endif
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glMultiDrawElementsIndirectCount)
+/**
+ * @brief Render indexed primitives from array data, taking parameters and
+ *        the number of draws from buffer objects.
+ *
+ * Behaves like glMultiDrawElementsIndirect, except that the number of draws
+ * is read from the buffer bound to GL_PARAMETER_BUFFER, at draw_count_offset,
+ * and is clamped to max_draw_count. This lets the GPU (for ex. a compute
+ * shader) decide how many draws are executed, without a round trip to the
+ * CPU.
+ *
+ * @param type               Specifies what kind of primitives to render.
+ * @param index_type         Specifies the type of data in the IndexBuffer.
+ * @param draw_count_offset  Specifies the offset (in bytes) into the
+ *                           parameter buffer, where the draw count is stored.
+ * @param max_draw_count     Specifies the maximum number of draws, that will
+ *                           be executed.
+ * @param stride             Specifies the distance in basic machine units
+ *                           between elements of the draw parameter array.
+ * @param indirect           Specifies a byte offset (cast to a pointer type)
+ *                           into the buffer bound to GL_DRAW_INDIRECT_BUFFER,
+ *                           which designates the starting point of the
+ *                           structure containing the draw parameters.
+ * @see glMultiDrawElementsIndirectCount
+ * @version OpenGL 4.6
+ */
+inline void MultiDrawElementsIndirectCount(PrimType type,
+                                           IndexType index_type,
+                                           GLintptr draw_count_offset,
+                                           GLsizei max_draw_count,
+                                           GLsizei stride = 0,
+                                           const void* indirect = nullptr) {
+  gl(MultiDrawElementsIndirectCount(
+    GLenum(type), GLenum(index_type), indirect, draw_count_offset,
+    max_draw_count, stride
+  ));
+}
+#endif
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawElementsBaseVertex)
 /**
  * @brief render primitives from array data with a per-element offset
@@ -1608,6 +1671,93 @@ inline void DrawElementsInstancedBaseVertexBaseInstance<GLuint>(
 }
 #endif
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_ELEMENT_ARRAY_BUFFER)
+/**
+ * @brief Draws a range of the indices uploaded with IndexBuffer::indices(),
+ *        using the index type that was picked for them.
+ *
+ * The index buffer isn't bound by this call, it has to be bound already
+ * (usually through the bound VAO), it's only used to look up the type and
+ * the number of the indices.
+ *
+ * @param type     Specifies what kind of primitives to render.
+ * @param indices  The currently bound index buffer.
+ * @param first    Specifies the first index to be rendered.
+ * @param count    Specifies the number of indices to be rendered, or -1 to
+ *                 render all of them after first.
+ * @see glDrawElements
+ * @version OpenGL 1.1
+ */
+inline void DrawElements(PrimType type, const IndexBuffer& indices,
+                         GLsizei first = 0, GLsizei count = -1) {
+  if (count < 0) {
+    count = GLsizei(indices.indexCount()) - first;
+  }
+  switch (indices.indexType()) {
+    case IndexType::kUnsignedByte:
+      DrawElements(type, count, reinterpret_cast<const GLubyte*>(
+          size_t(first) * sizeof(GLubyte)));
+      break;
+    case IndexType::kUnsignedShort:
+      DrawElements(type, count, reinterpret_cast<const GLushort*>(
+          size_t(first) * sizeof(GLushort)));
+      break;
+    case IndexType::kUnsignedInt:
+      DrawElements(type, count, reinterpret_cast<const GLuint*>(
+          size_t(first) * sizeof(GLuint)));
+      break;
+  }
+}
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawElementsInstanced)
+/**
+ * @brief Draws multiple instances of the indices uploaded with
+ *        IndexBuffer::indices(), using the index type that was picked for them.
+ *
+ * The index buffer has to be bound already, see
+ * DrawElements(PrimType, const IndexBuffer&, GLsizei, GLsizei).
+ *
+ * @param type        Specifies what kind of primitives to render.
+ * @param indices     The currently bound index buffer.
+ * @param inst_count  Specifies the number of instances to be rendered.
+ * @see glDrawElementsInstanced
+ * @version OpenGL 3.1
+ */
+inline void DrawElementsInstanced(PrimType type, const IndexBuffer& indices,
+                                  GLsizei inst_count) {
+  DrawElementsInstanced(type, GLsizei(indices.indexCount()),
+                        indices.indexType(), inst_count);
+}
+#endif
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glDrawElementsInstancedBaseInstance)
+/**
+ * @brief Draws multiple instances of the indices uploaded with
+ *        IndexBuffer::indices(), fetching the instanced attributes from
+ *        base_instance.
+ *
+ * The index buffer has to be bound already, see
+ * DrawElements(PrimType, const IndexBuffer&, GLsizei, GLsizei).
+ *
+ * @param type           Specifies what kind of primitives to render.
+ * @param indices        The currently bound index buffer.
+ * @param inst_count     Specifies the number of instances to be rendered.
+ * @param base_instance  Specifies the base instance for use in fetching
+ *                       instanced vertex attributes.
+ * @see glDrawElementsInstancedBaseInstance
+ * @version OpenGL 4.2
+ */
+inline void DrawElementsInstancedBaseInstance(PrimType type,
+                                              const IndexBuffer& indices,
+                                              GLsizei inst_count,
+                                              GLuint base_instance) {
+  DrawElementsInstancedBaseInstance(type, GLsizei(indices.indexCount()),
+                                    indices.indexType(), inst_count,
+                                    base_instance);
+}
+#endif
+#endif  // GL_ELEMENT_ARRAY_BUFFER
+
 } // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
@@ -48,6 +48,31 @@ inline bool IsExtensionSupported(const char *extension) {
   return false;
 }
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glGetStringi)
+/// Returns if the context's version is at least major.minor, or if it
+/// supports the extension (that adds the same functionality).
+/** Unlike IsExtensionSupported, it works with core profile contexts. */
+inline bool IsFeatureSupported(GLint major, GLint minor,
+                               const char* extension) {
+  GLint context_major = 0, context_minor = 0;
+  gl(GetIntegerv(GL_MAJOR_VERSION, &context_major));
+  gl(GetIntegerv(GL_MINOR_VERSION, &context_minor));
+  if (context_major > major ||
+      (context_major == major && context_minor >= minor)) {
+    return true;
+  }
+  GLint extension_count = 0;
+  gl(GetIntegerv(GL_NUM_EXTENSIONS, &extension_count));
+  for (GLint i = 0; i < extension_count; ++i) {
+    const GLubyte* name = gl(GetStringi(GL_EXTENSIONS, i));
+    if (strcmp(reinterpret_cast<const char*>(name), extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
 } // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
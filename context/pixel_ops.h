@@ -13,6 +13,7 @@
 #include "../enums/pixel_data_format.h"
 #include "../enums/pixel_storage_mode.h"
 #include "../enums/buffer_select_bit.h"
+#include "./state_cache.h"
 
 #include "../define_internal_macros.h"
 
@@ -26,6 +27,10 @@ namespace OGLWRAP_NAMESPACE_NAME {
  * @version OpenGL 1.0
  */
 inline void PixelStore(PixelStorageMode parameter, GLfloat value) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    cache->pixelStore(GLenum(parameter)).forget();
+  }
   gl(PixelStoref(GLenum(parameter), value));
 }
 
@@ -37,9 +42,75 @@ inline void PixelStore(PixelStorageMode parameter, GLfloat value) {
  * @version OpenGL 1.0
  */
 inline void PixelStore(PixelStorageMode parameter, GLint value) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    if (!cache->pixelStore(GLenum(parameter)).set(value)) {
+      cache->countSkippedCall();
+      return;
+    }
+  }
   gl(PixelStorei(GLenum(parameter), value));
 }
 
+/**
+ * @brief Returns the value of a pixel storage mode.
+ * @param parameter Specifies the symbolic name of the parameter to be queried.
+ * @see <a href="https://www.opengl.org/wiki/GLAPI/glGet">glGetIntegerv</a>
+ * @version OpenGL 1.0
+ */
+inline GLint PixelStore(PixelStorageMode parameter) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    GLint data;
+    gl(GetIntegerv(GLenum(parameter), &data));
+    return data;
+  }
+  CachedState<GLint>& cached = cache->pixelStore(GLenum(parameter));
+  if (!cached.known()) {
+    GLint data;
+    gl(GetIntegerv(GLenum(parameter), &data));
+    cached.set(data);
+    cache->countQuery();
+  }
+  return cached.value();
+}
+
+/// Sets a pixel storage mode, and sets the old value back when the variable
+/// goes out of scope.
+/** Texture uploads use it for ex. to change the unpack alignment:
+  * @code
+  *   gl::TemporaryPixelStore alignment(gl::PixelStorageMode::kUnpackAlignment, 1);
+  * @endcode */
+class TemporaryPixelStore {
+ public:
+  TemporaryPixelStore(PixelStorageMode parameter, GLint value)
+      : TemporaryPixelStore(parameter, value, true) {}
+
+  /// Does nothing (not even query the old value) if enabled is false, for
+  /// ex. when the rows of an image are known to be aligned already.
+  TemporaryPixelStore(PixelStorageMode parameter, GLint value, bool enabled)
+      : parameter_(parameter), old_value_(enabled ? PixelStore(parameter) : 0)
+      , changed_(enabled && old_value_ != value) {
+    if (changed_) {
+      PixelStore(parameter_, value);
+    }
+  }
+
+  ~TemporaryPixelStore() {
+    if (changed_) {
+      PixelStore(parameter_, old_value_);
+    }
+  }
+
+  TemporaryPixelStore(const TemporaryPixelStore&) = delete;
+  TemporaryPixelStore& operator=(const TemporaryPixelStore&) = delete;
+
+ private:
+  PixelStorageMode parameter_;
+  GLint old_value_;
+  bool changed_;
+};
+
 /**
  * read a block of pixels from the frame buffer
  * @see <a href="https://www.opengl.org/wiki/GLAPI/glReadPixels">glReadPixels</a>
@@ -11,6 +11,7 @@
 #include "../enums/face_orientation.h"
 #include "../enums/poly_mode.h"
 #include "../enums/provoke_mode.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
@@ -18,61 +19,89 @@ namespace OGLWRAP_NAMESPACE_NAME {
 /// Define front- and back-facing polygons.
 /** @see glFrontFace */
 inline void FrontFace(FaceOrientation orintation) {
-	gl(FrontFace(GLenum(orintation)));
+	if (CacheState(&StateCache::front_face, GLenum(orintation))) {
+		gl(FrontFace(GLenum(orintation)));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_FRONT_FACE)
 /// Returns the orientation of the front facing polygons.
 /** @see GetIntegerv, GL_FRONT_FACE */
 inline FaceOrientation FrontFace() {
-	GLint data;
-	gl(GetIntegerv(GL_FRONT_FACE, &data));
-	return static_cast<FaceOrientation>(data);
+	return static_cast<FaceOrientation>(CachedQuery(&StateCache::front_face, [] {
+		GLint data;
+		gl(GetIntegerv(GL_FRONT_FACE, &data));
+		return GLenum(data);
+	}));
 }
 #endif
 
 /// Specify whether front- or back-facing facets can be culled.
 /** @see glCullFace */
 inline void CullFace(Face face) {
-	gl(CullFace(GLenum(face)));
+	if (CacheState(&StateCache::cull_face, GLenum(face))) {
+		gl(CullFace(GLenum(face)));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_CULL_FACE_MODE)
 /// Returns whether front- or back-facing facets can be culled.
 /** @see GetIntegerv, GL_CULL_FACE_MODE */
 inline Face CullFace() {
-	GLint data;
-	gl(GetIntegerv(GL_CULL_FACE_MODE, &data));
-	return static_cast<Face>(data);
+	return static_cast<Face>(CachedQuery(&StateCache::cull_face, [] {
+		GLint data;
+		gl(GetIntegerv(GL_CULL_FACE_MODE, &data));
+		return GLenum(data);
+	}));
 }
 #endif
 
 /// Sets the polygon rasterization mode.
 /** @see glPolygonMode */
 inline void PolygonMode(Face face, PolyMode mode) {
+	if (face == Face::kFrontAndBack) {
+		if (!CacheState(&StateCache::polygon_mode, GLenum(mode))) {
+			return;
+		}
+	} else {
+		// The cache only tracks a mode, that is common for both faces.
+		ForgetCachedState(&StateCache::polygon_mode);
+	}
 	gl(PolygonMode(GLenum(face), GLenum(mode)));
 }
 
 /// Sets the polygon rasterization mode.
 /** @see glPolygonMode */
 inline void PolygonMode(PolyMode mode) {
-	gl(PolygonMode(GLenum(Face::kFrontAndBack), GLenum(mode)));
+	PolygonMode(Face::kFrontAndBack, mode);
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_POLYGON_MODE)
 /// Returns the polygon rasterization mode.
-/** @see GetIntegerv, GL_POLYGON_MODE */
+/** The mode of the front faces, if the two faces differ.
+  * @see GetIntegerv, GL_POLYGON_MODE */
 inline PolyMode PolygonMode() {
-	GLint data;
-	gl(GetIntegerv(GL_POLYGON_MODE, &data));
-	return static_cast<PolyMode>(data);
+	StateCache* cache = StateCache::Current();
+	if (cache && cache->polygon_mode.known()) {
+		return static_cast<PolyMode>(cache->polygon_mode.value());
+	}
+	GLint data[2];
+	gl(GetIntegerv(GL_POLYGON_MODE, data));
+	// The cache only tracks a mode, that is common for both faces.
+	if (cache && data[0] == data[1]) {
+		cache->polygon_mode.set(GLenum(data[0]));
+		cache->countQuery();
+	}
+	return static_cast<PolyMode>(data[0]);
 }
 #endif
 
 /// Sets the scale and units used to calculate depth values.
 /** @see glPolygonOffset */
 inline void PolygonOffset(GLfloat factor, GLfloat units) {
-	gl(PolygonOffset(factor, units));
+	if (CacheState(&StateCache::polygon_offset, glm::vec2(factor, units))) {
+		gl(PolygonOffset(factor, units));
+	}
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING \
@@ -80,10 +109,12 @@ inline void PolygonOffset(GLfloat factor, GLfloat units) {
 /// Returns the scale and units used to calculate depth values.
 /** @see GetFloatv, GL_POLYGON_OFFSET_FACTOR, GL_POLYGON_OFFSET_UNITS */
 inline glm::vec2 PolygonOffset() {
-	glm::vec2 data;
-	gl(GetFloatv(GL_POLYGON_OFFSET_FACTOR, &data.x));
-	gl(GetFloatv(GL_POLYGON_OFFSET_UNITS, &data.y));
-	return data;
+	return CachedQuery(&StateCache::polygon_offset, [] {
+		glm::vec2 data;
+		gl(GetFloatv(GL_POLYGON_OFFSET_FACTOR, &data.x));
+		gl(GetFloatv(GL_POLYGON_OFFSET_UNITS, &data.y));
+		return data;
+	});
 }
 #endif
 
@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 
 #include "../config.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
@@ -36,7 +37,10 @@ namespace OGLWRAP_NAMESPACE_NAME {
  * @version OpenGL 1.1
  */
 inline void Scissor(GLint left, GLint bottom, GLsizei width, GLsizei height) {
-  gl(Scissor(left, bottom, width, height));
+  if (CacheState(&StateCache::scissor_box,
+                 glm::ivec4(left, bottom, width, height))) {
+    gl(Scissor(left, bottom, width, height));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glScissorIndexed)
@@ -68,6 +72,7 @@ inline void Scissor(GLint left, GLint bottom, GLsizei width, GLsizei height) {
  */
 inline void Scissor(GLuint viewport, GLint left, GLint bottom,
                     GLsizei width, GLsizei height) {
+  ForgetCachedState(&StateCache::scissor_box);
   gl(ScissorIndexed(viewport, left, bottom, width, height));
 }
 #endif
@@ -101,6 +106,7 @@ inline void Scissor(GLuint viewport, GLint left, GLint bottom,
  * @version OpenGL 4.1
  */
 inline void Scissor(GLuint viewport, GLint *v) {
+  ForgetCachedState(&StateCache::scissor_box);
   gl(ScissorIndexedv(viewport, v));
 }
 #endif
@@ -138,6 +144,7 @@ inline void Scissor(GLuint viewport, GLint *v) {
  * @version OpenGL 4.1
  */
 inline void ScissorArray(GLuint first, GLuint count, GLint *v) {
+  ForgetCachedState(&StateCache::scissor_box);
   gl(ScissorArrayv(first, count, v));
 }
 #endif
@@ -149,10 +156,25 @@ inline void ScissorArray(GLuint first, GLuint count, GLint *v) {
  * @version OpenGL 1.1
  */
 inline glm::ivec4 ScissorBox() {
-  GLint data[4];
-  gl(GetIntegerv(GL_SCISSOR_BOX, data));
-  return glm::ivec4{data[0], data[1], data[2], data[3]};
+  return CachedQuery(&StateCache::scissor_box, [] {
+    GLint data[4];
+    gl(GetIntegerv(GL_SCISSOR_BOX, data));
+    return glm::ivec4{data[0], data[1], data[2], data[3]};
+  });
 }
+
+/// Sets the scissor box, and sets the old one back when the variable goes
+/// out of scope.
+class TemporaryScissor : TemporaryValue<glm::ivec4> {
+ public:
+  TemporaryScissor(GLint left, GLint bottom, GLsizei width, GLsizei height)
+      : TemporaryValue<glm::ivec4>(ScissorBox(),
+                                   glm::ivec4(left, bottom, width, height),
+                                   [](const glm::ivec4& old_box) {
+                                     Scissor(old_box.x, old_box.y,
+                                             old_box.z, old_box.w);
+                                   }) {}
+};
 #endif
 
 #if OGLWRAP_DEFINE_EVERYTHING \
@@ -0,0 +1,500 @@
+// Copyright (c) Tamas Csala
+
+/** @file state_cache.h
+    @brief Implements a CPU side mirror of the fixed function state of the
+           context, that lets the setters skip the redundant calls, and the
+           getters avoid the glGet* round-trips.
+*/
+
+#ifndef OGLWRAP_CONTEXT_STATE_CACHE_H_
+#define OGLWRAP_CONTEXT_STATE_CACHE_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "../config.h"
+
+#include "../define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/// A single piece of state, that is either known or has to be queried.
+template <typename T>
+class CachedState {
+ public:
+  CachedState() : value_(), known_(false) {}
+
+  /// Returns if the value reflects the context.
+  bool known() const { return known_; }
+
+  /// Returns the cached value (only meaningful if it's known).
+  const T& value() const { return value_; }
+
+  /// Stores a value, and returns if it differed from the cached one.
+  bool set(const T& value) {
+    if (known_ && value_ == value) {
+      return false;
+    }
+    value_ = value;
+    known_ = true;
+    return true;
+  }
+
+  /// Marks the value unknown, the next getter will query it.
+  void forget() { known_ = false; }
+
+ private:
+  T value_;
+  bool known_;
+};
+
+/**
+ * @brief A mirror of the capabilities, rasterization, blend, depth, stencil,
+ *        scissor, viewport, write mask, clear, pixel store and binding state
+ *        of a context.
+ *
+ * While a cache is current on the thread, the functions in the context
+ * headers (Enable, BlendFunc, StencilFunc, Viewport, ...) skip the GL calls,
+ * that wouldn't change anything, and their getters (IsEnabled, StencilRef,
+ * Viewport, GetClearColor, ...) return the cached values. Every value is
+ * queried from the context when it's first needed, so creating a cache
+ * doesn't cost anything.
+ *
+ * Create one cache per context, and make it current whenever the context is
+ * made current on a thread. If code outside of oglwrap (another library, or
+ * raw gl calls) changes the state, call resync() afterwards.
+ * @code
+ *   gl::StateCache state_cache;  // after the context is created
+ *   ...
+ *   third_party_renderer.render();
+ *   state_cache.resync();
+ * @endcode
+ * Indexed setters (Enable(cap, index), BlendFunc(buffer, ...),
+ * Viewport(index, ...), etc.) are not cached, but they make the affected
+ * values unknown.
+ *
+ * The bindings are tracked per binding point (per texture unit for textures,
+ * and per index for BindBase() and BindRange()), so the redundant binds are
+ * skipped, and IsBound() (that the bind checks of the debug builds call on
+ * every buffer, texture, and uniform operation) is a comparison. Deleting an
+ * object makes its bindings unknown, as the name can be reused.
+ */
+class StateCache {
+ public:
+  /// An object bound to a binding point, or a range of a buffer bound to an
+  /// indexed one.
+  struct Binding {
+    GLuint name;
+    GLintptr offset;  // 0 with size 0 means the whole object
+    GLsizeiptr size;
+
+    bool operator==(const Binding& other) const {
+      return name == other.name && offset == other.offset
+          && size == other.size;
+    }
+  };
+
+  /// The index of the non-indexed binding points.
+  static const GLuint kNoIndex = ~GLuint(0);
+
+  /// Counters of the work, that the cache saved.
+  struct Statistics {
+    size_t skipped_calls;  ///< The setter calls, that were redundant.
+    size_t queries;        ///< The glGet* queries, that filled the cache.
+  };
+
+  /// Creates an empty cache, and makes it current on this thread.
+  StateCache() : pipeline_state_(0), statistics_{0, 0} { makeCurrent(); }
+
+  /// If the cache is current, the thread is left without a cache.
+  ~StateCache() {
+    if (CurrentSlot() == this) {
+      CurrentSlot() = nullptr;
+    }
+  }
+
+  StateCache(const StateCache&) = delete;
+  StateCache& operator=(const StateCache&) = delete;
+
+  /// Makes this cache the one used by the context functions on this thread.
+  void makeCurrent() { CurrentSlot() = this; }
+
+  /// Returns the cache, that is current on this thread, or nullptr.
+  static StateCache* Current() { return CurrentSlot(); }
+
+  /// Makes the thread use no cache, every call goes to GL.
+  static void ClearCurrent() { CurrentSlot() = nullptr; }
+
+  /// Forgets every value, they will be queried from the context again.
+  /** Call this after code, that doesn't use oglwrap, changed the state. */
+  void resync() {
+    stateChanged();
+    for (auto& capability : capabilities_) {
+      capability.second.forget();
+    }
+    front_face.forget();
+    cull_face.forget();
+    polygon_mode.forget();
+    polygon_offset.forget();
+    blend_equation.forget();
+    blend_func.forget();
+    blend_color.forget();
+    depth_func.forget();
+    depth_range.forget();
+    stencil_func.forget();
+    stencil_back_func.forget();
+    stencil_op.forget();
+    stencil_back_op.forget();
+    scissor_box.forget();
+    viewport.forget();
+    color_mask.forget();
+    depth_mask.forget();
+    stencil_mask.forget();
+    stencil_back_mask.forget();
+    clear_color.forget();
+    clear_depth.forget();
+    clear_stencil.forget();
+    active_texture.forget();
+    for (auto& pixel_store : pixel_stores_) {
+      pixel_store.second.forget();
+    }
+    bindings_.clear();
+    texture_bindings_.clear();
+  }
+
+  /// Returns the state of a (non-indexed) capability.
+  CachedState<bool>& capability(GLenum capability) {
+    for (auto& entry : capabilities_) {
+      if (entry.first == capability) {
+        return entry.second;
+      }
+    }
+    capabilities_.push_back(std::make_pair(capability, CachedState<bool>{}));
+    return capabilities_.back().second;
+  }
+
+  /// Returns the value of an integer pixel store parameter.
+  CachedState<GLint>& pixelStore(GLenum parameter) {
+    for (auto& entry : pixel_stores_) {
+      if (entry.first == parameter) {
+        return entry.second;
+      }
+    }
+    pixel_stores_.push_back(std::make_pair(parameter, CachedState<GLint>{}));
+    return pixel_stores_.back().second;
+  }
+
+  /// Returns the object bound to a binding point (like
+  /// GL_ARRAY_BUFFER_BINDING), or to an index of it.
+  CachedState<Binding>& binding(GLenum binding, GLuint index = kNoIndex) {
+    return bindings_[Key(binding, index)];
+  }
+
+  /// Returns the texture bound to a texture unit's binding point (like
+  /// GL_TEXTURE_BINDING_2D).
+  CachedState<Binding>& textureBinding(GLenum binding, GLuint unit) {
+    return texture_bindings_[Key(binding, unit)];
+  }
+
+  /// Makes every texture binding of a texture unit unknown.
+  void forgetTextureUnit(GLuint unit) {
+    for (auto& entry : texture_bindings_) {
+      if (GLuint(entry.first) == unit) {
+        entry.second.forget();
+      }
+    }
+  }
+
+  /// Makes a binding point unknown, including every index of it.
+  void forgetBindings(GLenum binding) {
+    for (auto& entry : bindings_) {
+      if (GLenum(entry.first >> 32) == binding) {
+        entry.second.forget();
+      }
+    }
+  }
+
+  /// Makes every binding of an object name unknown.
+  /** Called when an object is deleted, as its name can be reused. */
+  void forgetName(GLuint name) {
+    for (auto& entry : bindings_) {
+      if (entry.second.value().name == name) {
+        entry.second.forget();
+      }
+    }
+    for (auto& entry : texture_bindings_) {
+      if (entry.second.value().name == name) {
+        entry.second.forget();
+      }
+    }
+  }
+
+  /// Records that a fixed function state value was changed, or forgotten.
+  void stateChanged() { pipeline_state_ = 0; }
+
+  /// Returns the id of the PipelineState, that is known to be applied, or 0
+  /// if any of the values changed since the last PipelineState::apply().
+  uint64_t pipelineState() const { return pipeline_state_; }
+
+  /// Records that the PipelineState with the given id was applied.
+  void pipelineStateApplied(uint64_t id) { pipeline_state_ = id; }
+
+  /// Returns the counters since the creation of the cache.
+  const Statistics& statistics() const { return statistics_; }
+
+  /// Counts a setter call, that was skipped.
+  void countSkippedCall() { statistics_.skipped_calls++; }
+
+  /// Counts a query, that filled the cache.
+  void countQuery() { statistics_.queries++; }
+
+  // The cached values.
+  CachedState<GLenum> front_face;
+  CachedState<GLenum> cull_face;
+  CachedState<GLenum> polygon_mode;  // of both faces
+  CachedState<glm::vec2> polygon_offset;  // factor, units
+  CachedState<glm::uvec2> blend_equation;  // rgb, alpha
+  CachedState<glm::uvec4> blend_func;  // src_rgb, dst_rgb, src_alpha, dst_alpha
+  CachedState<glm::vec4> blend_color;
+  CachedState<GLenum> depth_func;
+  CachedState<glm::dvec2> depth_range;
+  CachedState<glm::uvec3> stencil_func;  // func, ref, value_mask
+  CachedState<glm::uvec3> stencil_back_func;
+  CachedState<glm::uvec3> stencil_op;  // sfail, dpfail, dppass
+  CachedState<glm::uvec3> stencil_back_op;
+  CachedState<glm::ivec4> scissor_box;
+  CachedState<glm::ivec4> viewport;
+  CachedState<glm::bvec4> color_mask;
+  CachedState<bool> depth_mask;
+  CachedState<GLuint> stencil_mask;
+  CachedState<GLuint> stencil_back_mask;
+  CachedState<glm::vec4> clear_color;
+  CachedState<GLdouble> clear_depth;
+  CachedState<GLint> clear_stencil;
+  CachedState<GLuint> active_texture;  // the unit, not GL_TEXTURE0 + unit
+
+ private:
+  std::vector<std::pair<GLenum, CachedState<bool>>> capabilities_;
+  std::vector<std::pair<GLenum, CachedState<GLint>>> pixel_stores_;
+  std::unordered_map<uint64_t, CachedState<Binding>> bindings_;
+  std::unordered_map<uint64_t, CachedState<Binding>> texture_bindings_;
+  uint64_t pipeline_state_;
+  Statistics statistics_;
+
+  static uint64_t Key(GLenum binding, GLuint index) {
+    return (uint64_t(binding) << 32) | index;
+  }
+
+  static StateCache*& CurrentSlot() {
+    static thread_local StateCache* current = nullptr;
+    return current;
+  }
+};
+
+/// Stores a value in the current cache (if there's one).
+/** Returns if the GL call, that sets the value, has to be made. */
+template <typename T>
+inline bool CacheState(CachedState<T> StateCache::*state, const T& value) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  if ((cache->*state).set(value)) {
+    cache->stateChanged();
+    return true;
+  }
+  cache->countSkippedCall();
+  return false;
+}
+
+/// Returns the value from the current cache, or queries it from the context.
+template <typename T, typename Query>
+inline T CachedQuery(CachedState<T> StateCache::*state, Query query) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return query();
+  }
+  CachedState<T>& cached = cache->*state;
+  if (!cached.known()) {
+    cached.set(query());
+    cache->countQuery();
+  }
+  return cached.value();
+}
+
+/// Marks a value unknown in the current cache.
+/** Used by the setters, that change the value, but are not cached. */
+template <typename T>
+inline void ForgetCachedState(CachedState<T> StateCache::*state) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    (cache->*state).forget();
+    cache->stateChanged();
+  }
+}
+
+/**
+ * @brief Sets a value for the lifetime of the object, and sets the old value
+ *        back when it goes out of scope.
+ *
+ * Neither call is made if the new value equals the old one. The old value is
+ * read with the cached getters, so while a StateCache is current, creating a
+ * guard doesn't query the context, and nested guards cost a comparison. The
+ * guards derived from this class are named Temporary*, like
+ * TemporaryViewport or TemporaryDepthFunc.
+ */
+template <typename T>
+class TemporaryValue {
+ public:
+  typedef void (*Setter)(const T&);
+
+  TemporaryValue(const T& old_value, const T& value, Setter setter)
+      : setter_(setter), old_value_(old_value),
+        changed_(!(old_value == value)) {
+    if (changed_) {
+      setter_(value);
+    }
+  }
+
+  ~TemporaryValue() {
+    if (changed_) {
+      setter_(old_value_);
+    }
+  }
+
+  TemporaryValue(const TemporaryValue&) = delete;
+  TemporaryValue& operator=(const TemporaryValue&) = delete;
+
+  /// Returns the value, that is restored at the end of the scope.
+  const T& oldValue() const { return old_value_; }
+
+ private:
+  Setter setter_;
+  T old_value_;
+  bool changed_;
+};
+
+/// Records a binding in the current cache (if there's one).
+/** Returns if the GL call, that makes the binding, has to be made. */
+inline bool CacheBinding(GLenum binding, GLuint index, GLuint name,
+                         GLintptr offset = 0, GLsizeiptr size = 0) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  if (cache->binding(binding, index).set(
+        StateCache::Binding{name, offset, size})) {
+    return true;
+  }
+  cache->countSkippedCall();
+  return false;
+}
+
+/// Makes a binding point (with all of its indices) unknown in the current
+/// cache.
+/** Used by the calls, that change the binding as a side effect. */
+inline void ForgetBindings(GLenum binding) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    cache->forgetBindings(binding);
+  }
+}
+
+/// Makes the bindings of a deleted object unknown in the current cache.
+inline void ForgetBoundName(GLuint name) {
+  StateCache* cache = StateCache::Current();
+  if (cache && name != 0) {
+    cache->forgetName(name);
+  }
+}
+
+/// Returns the name bound to a (non-indexed) binding point. Uses the
+/// current cache, and fills it if the binding is unknown.
+inline GLuint CachedBoundName(GLenum binding) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    CachedState<StateCache::Binding>& cached = cache->binding(binding);
+    if (cached.known()) {
+      return cached.value().name;
+    }
+  }
+  GLint name;
+  gl(GetIntegerv(binding, &name));
+  if (cache) {
+    cache->binding(binding).set(StateCache::Binding{GLuint(name), 0, 0});
+    cache->countQuery();
+  }
+  return GLuint(name);
+}
+
+/// Returns the name bound to an index of an indexed binding point.
+/** The cache is only filled by BindBase() and BindRange(), as a query
+  * couldn't tell if a range, or the whole buffer is bound. */
+inline GLuint CachedBoundName(GLenum binding, GLuint index) {
+  StateCache* cache = StateCache::Current();
+  if (cache) {
+    CachedState<StateCache::Binding>& cached = cache->binding(binding, index);
+    if (cached.known()) {
+      return cached.value().name;
+    }
+  }
+  GLint name;
+  gl(GetIntegeri_v(binding, index, &name));
+  return GLuint(name);
+}
+
+/// Returns the active texture unit (not GL_TEXTURE0 + unit).
+inline GLuint CachedActiveTexture() {
+  return CachedQuery(&StateCache::active_texture, [] {
+    GLint unit;
+    gl(GetIntegerv(GL_ACTIVE_TEXTURE, &unit));
+    return GLuint(unit - GL_TEXTURE0);
+  });
+}
+
+/// Records a texture binding of the active unit in the current cache.
+/** Returns if the GL call, that makes the binding, has to be made. */
+inline bool CacheTextureBinding(GLenum binding, GLuint name) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  CachedState<StateCache::Binding>& cached =
+      cache->textureBinding(binding, CachedActiveTexture());
+  if (cached.set(StateCache::Binding{name, 0, 0})) {
+    return true;
+  }
+  cache->countSkippedCall();
+  return false;
+}
+
+/// Returns the texture bound to the active unit's binding point. Uses the
+/// current cache, and fills it if the binding is unknown.
+inline GLuint CachedBoundTexture(GLenum binding) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    GLint name;
+    gl(GetIntegerv(binding, &name));
+    return GLuint(name);
+  }
+  CachedState<StateCache::Binding>& cached =
+      cache->textureBinding(binding, CachedActiveTexture());
+  if (!cached.known()) {
+    GLint name;
+    gl(GetIntegerv(binding, &name));
+    cached.set(StateCache::Binding{GLuint(name), 0, 0});
+    cache->countQuery();
+  }
+  return cached.value().name;
+}
+
+}  // namespace oglwrap
+
+#include "../undefine_internal_macros.h"
+#endif  // OGLWRAP_CONTEXT_STATE_CACHE_H_
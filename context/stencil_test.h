@@ -7,10 +7,70 @@
 #include "../enums/face.h"
 #include "../enums/compare_func.h"
 #include "../enums/stencil_operation.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
+/// Stores a stencil state of the specified faces in the current StateCache.
+/** Returns if the GL call, that sets the value, has to be made. */
+inline bool CacheStencilState(Face face,
+                              CachedState<glm::uvec3> StateCache::*front,
+                              CachedState<glm::uvec3> StateCache::*back,
+                              const glm::uvec3& value) {
+  StateCache* cache = StateCache::Current();
+  if (!cache) {
+    return true;
+  }
+  bool changed = false;
+  if (face != Face::kBack) {
+    changed |= (cache->*front).set(value);
+  }
+  if (face != Face::kFront) {
+    changed |= (cache->*back).set(value);
+  }
+  if (changed) {
+    cache->stateChanged();
+  } else {
+    cache->countSkippedCall();
+  }
+  return changed;
+}
+
+/// Returns the function, reference value and value mask of a face from the
+/// current StateCache, querying them if they are unknown.
+inline glm::uvec3 CachedStencilFunc(bool backface) {
+  return CachedQuery(
+      backface ? &StateCache::stencil_back_func : &StateCache::stencil_func,
+      [backface] {
+        GLint data[3];
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_FUNC : GL_STENCIL_FUNC,
+                       &data[0]));
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_REF : GL_STENCIL_REF,
+                       &data[1]));
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_VALUE_MASK
+                                : GL_STENCIL_VALUE_MASK, &data[2]));
+        return glm::uvec3(data[0], data[1], data[2]);
+      });
+}
+
+/// Returns the stencil-fail, depth-fail and depth-pass actions of a face from
+/// the current StateCache, querying them if they are unknown.
+inline glm::uvec3 CachedStencilOp(bool backface) {
+  return CachedQuery(
+      backface ? &StateCache::stencil_back_op : &StateCache::stencil_op,
+      [backface] {
+        GLint data[3];
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_FAIL : GL_STENCIL_FAIL,
+                       &data[0]));
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_PASS_DEPTH_FAIL
+                                : GL_STENCIL_PASS_DEPTH_FAIL, &data[1]));
+        gl(GetIntegerv(backface ? GL_STENCIL_BACK_PASS_DEPTH_PASS
+                                : GL_STENCIL_PASS_DEPTH_PASS, &data[2]));
+        return glm::uvec3(data[0], data[1], data[2]);
+      });
+}
+
 /**
  * @brief set front and back function and reference value for stencil testing
  *
@@ -79,7 +139,11 @@ namespace OGLWRAP_NAMESPACE_NAME {
 inline void StencilFunc(CompareFunc func,
                         GLint ref=GLint(0),
                         GLuint mask=~GLuint(0)) {
-  gl(StencilFunc(GLenum(func), ref, mask));
+  if (CacheStencilState(Face::kFrontAndBack, &StateCache::stencil_func,
+                        &StateCache::stencil_back_func,
+                        glm::uvec3(GLenum(func), ref, mask))) {
+    gl(StencilFunc(GLenum(func), ref, mask));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glStencilFuncSeparate)
@@ -153,7 +217,11 @@ inline void StencilFuncSeparate(Face face,
                                 CompareFunc func,
                                 GLint ref=GLint(0),
                                 GLuint mask=~GLuint(0)) {
-  gl(StencilFuncSeparate(GLenum(face), GLenum(func), ref, mask));
+  if (CacheStencilState(face, &StateCache::stencil_func,
+                        &StateCache::stencil_back_func,
+                        glm::uvec3(GLenum(func), ref, mask))) {
+    gl(StencilFuncSeparate(GLenum(face), GLenum(func), ref, mask));
+  }
 }
 #endif
 
@@ -227,7 +295,12 @@ inline void StencilFuncSeparate(Face face,
 inline void StencilOp(StencilOperation sfail = StencilOperation::kKeep,
                       StencilOperation dfail = StencilOperation::kKeep,
                       StencilOperation dpass = StencilOperation::kKeep) {
-  gl(StencilOp(GLenum(sfail), GLenum(dfail), GLenum(dpass)));
+  if (CacheStencilState(Face::kFrontAndBack, &StateCache::stencil_op,
+                        &StateCache::stencil_back_op,
+                        glm::uvec3(GLenum(sfail), GLenum(dfail),
+                                   GLenum(dpass)))) {
+    gl(StencilOp(GLenum(sfail), GLenum(dfail), GLenum(dpass)));
+  }
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glStencilOpSeparate)
@@ -305,8 +378,13 @@ inline void StencilOpSeparate(Face face,
                               StencilOperation sfail = StencilOperation::kKeep,
                               StencilOperation dfail = StencilOperation::kKeep,
                               StencilOperation dpass = StencilOperation::kKeep) {
-  gl(StencilOpSeparate(GLenum(face), GLenum(sfail),
-                       GLenum(dfail), GLenum(dpass)));
+  if (CacheStencilState(face, &StateCache::stencil_op,
+                        &StateCache::stencil_back_op,
+                        glm::uvec3(GLenum(sfail), GLenum(dfail),
+                                   GLenum(dpass)))) {
+    gl(StencilOpSeparate(GLenum(face), GLenum(sfail),
+                         GLenum(dfail), GLenum(dpass)));
+  }
 }
 #endif
 
@@ -317,11 +395,14 @@ inline void StencilOpSeparate(Face face,
  * @version OpenGL 1.0
  */
 inline CompareFunc StencilFunc(bool backface = false) {
+  if (StateCache::Current()) {
+    return static_cast<CompareFunc>(CachedStencilFunc(backface).x);
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_FUNC, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_FUNC, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_FUNC, &data));
   }
   return static_cast<CompareFunc>(data);
 }
@@ -332,12 +413,15 @@ inline CompareFunc StencilFunc(bool backface = false) {
  * @see glGetIntegerv, GL_STENCIL_VALUE_MASK, GL_STENCIL_BACK_VALUE_MASK
  * @version OpenGL 1.0
  */
-inline GLuint StencilValueMask(bool backface = true) {
+inline GLuint StencilValueMask(bool backface = false) {
+  if (StateCache::Current()) {
+    return CachedStencilFunc(backface).z;
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_VALUE_MASK, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_VALUE_MASK, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_VALUE_MASK, &data));
   }
   return data;
 }
@@ -349,11 +433,14 @@ inline GLuint StencilValueMask(bool backface = true) {
  * @version OpenGL 1.0
  */
 inline GLuint StencilRef(bool backface = false) {
+  if (StateCache::Current()) {
+    return CachedStencilFunc(backface).y;
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_REF, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_REF, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_REF, &data));
   }
   return data;
 }
@@ -365,11 +452,14 @@ inline GLuint StencilRef(bool backface = false) {
  * @version OpenGL 1.0
  */
 inline StencilOperation StencilFail(bool backface = false) {
+  if (StateCache::Current()) {
+    return static_cast<StencilOperation>(CachedStencilOp(backface).x);
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_FAIL, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_FAIL, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_FAIL, &data));
   }
   return static_cast<StencilOperation>(data);
 }
@@ -382,11 +472,14 @@ inline StencilOperation StencilFail(bool backface = false) {
  * @version OpenGL 1.0
  */
 inline StencilOperation StencilPassDepthFail(bool backface = false) {
+  if (StateCache::Current()) {
+    return static_cast<StencilOperation>(CachedStencilOp(backface).y);
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_FAIL, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL, &data));
   }
   return static_cast<StencilOperation>(data);
 }
@@ -399,15 +492,77 @@ inline StencilOperation StencilPassDepthFail(bool backface = false) {
  * @version OpenGL 1.0
  */
 inline StencilOperation StencilPassDepthPass(bool backface = false) {
+  if (StateCache::Current()) {
+    return static_cast<StencilOperation>(CachedStencilOp(backface).z);
+  }
   GLint data;
   if (backface) {
-    gl(GetIntegerv(GL_STENCIL_PASS_DEPTH_PASS, &data));
-  } else {
     gl(GetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_PASS, &data));
+  } else {
+    gl(GetIntegerv(GL_STENCIL_PASS_DEPTH_PASS, &data));
   }
   return static_cast<StencilOperation>(data);
 }
 
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || defined(glStencilFuncSeparate) && defined(glStencilOpSeparate)
+/// Sets the stencil function, reference value and value mask of the front
+/// and/or back faces, and sets the old ones back when the variable goes out
+/// of scope.
+class TemporaryStencilFunc {
+ public:
+  TemporaryStencilFunc(CompareFunc func, GLint ref = GLint(0),
+                       GLuint mask = ~GLuint(0),
+                       Face face = Face::kFrontAndBack)
+      : front_(CachedStencilFunc(false),
+               face != Face::kBack ? glm::uvec3(GLenum(func), ref, mask)
+                                   : CachedStencilFunc(false),
+               [](const glm::uvec3& old_func) {
+                 StencilFuncSeparate(Face::kFront, CompareFunc(old_func.x),
+                                     GLint(old_func.y), old_func.z);
+               })
+      , back_(CachedStencilFunc(true),
+              face != Face::kFront ? glm::uvec3(GLenum(func), ref, mask)
+                                   : CachedStencilFunc(true),
+              [](const glm::uvec3& old_func) {
+                StencilFuncSeparate(Face::kBack, CompareFunc(old_func.x),
+                                    GLint(old_func.y), old_func.z);
+              }) {}
+
+ private:
+  TemporaryValue<glm::uvec3> front_, back_;
+};
+
+/// Sets the stencil actions of the front and/or back faces, and sets the old
+/// ones back when the variable goes out of scope.
+class TemporaryStencilOp {
+ public:
+  TemporaryStencilOp(StencilOperation sfail, StencilOperation dfail,
+                     StencilOperation dpass, Face face = Face::kFrontAndBack)
+      : front_(CachedStencilOp(false),
+               face != Face::kBack
+                   ? glm::uvec3(GLenum(sfail), GLenum(dfail), GLenum(dpass))
+                   : CachedStencilOp(false),
+               [](const glm::uvec3& old_op) {
+                 StencilOpSeparate(Face::kFront, StencilOperation(old_op.x),
+                                   StencilOperation(old_op.y),
+                                   StencilOperation(old_op.z));
+               })
+      , back_(CachedStencilOp(true),
+              face != Face::kFront
+                  ? glm::uvec3(GLenum(sfail), GLenum(dfail), GLenum(dpass))
+                  : CachedStencilOp(true),
+              [](const glm::uvec3& old_op) {
+                StencilOpSeparate(Face::kBack, StencilOperation(old_op.x),
+                                  StencilOperation(old_op.y),
+                                  StencilOperation(old_op.z));
+              }) {}
+
+ private:
+  TemporaryValue<glm::uvec3> front_, back_;
+};
+#endif
+
 } // namespace oglwrap
 
 #include "../undefine_internal_macros.h"
@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 
 #include "../config.h"
+#include "./state_cache.h"
 #include "../define_internal_macros.h"
 
 
@@ -15,29 +16,45 @@ namespace OGLWRAP_NAMESPACE_NAME {
 /// Sets the extents of the current viewport.
 /** @see glViewport */
 inline void Viewport(GLint x, GLint y, GLsizei w, GLsizei h) {
-	gl(Viewport(x, y, w, h));
+	if (CacheState(&StateCache::viewport, glm::ivec4(x, y, w, h))) {
+		gl(Viewport(x, y, w, h));
+	}
 }
 
 /// Sets the size of the current viewport starting at (0,0)
 /** @see glViewport */
 inline void Viewport(GLsizei w, GLsizei h) {
-	gl(Viewport(0, 0, w, h));
+	Viewport(0, 0, w, h);
 }
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_VIEWPORT)
 /// Returns the extents of the current viewport.
 /** @see glGetIntegerv, GL_VIEWPORT */
 inline glm::ivec4 Viewport() {
-	GLint data[4];
-	gl(GetIntegerv(GL_VIEWPORT, data));
-	return glm::ivec4(data[0], data[1], data[2], data[3]);
+	return CachedQuery(&StateCache::viewport, [] {
+		GLint data[4];
+		gl(GetIntegerv(GL_VIEWPORT, data));
+		return glm::ivec4(data[0], data[1], data[2], data[3]);
+	});
 }
+
+/// Sets the viewport, and sets the old one back when the variable goes out
+/// of scope.
+class TemporaryViewport : TemporaryValue<glm::ivec4> {
+public:
+	TemporaryViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+			: TemporaryValue<glm::ivec4>(Viewport(), glm::ivec4(x, y, w, h),
+			                             [](const glm::ivec4& old_viewport) {
+				Viewport(old_viewport.x, old_viewport.y, old_viewport.z, old_viewport.w);
+			}) {}
+};
 #endif
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glViewportIndexedf)
 /// Sets the extents of the specified viewport.
 /** @see glViewportIndexedf */
 inline void Viewport(GLuint viewport, GLfloat x, GLfloat y, GLfloat w, GLfloat h) {
+	ForgetCachedState(&StateCache::viewport);
 	gl(ViewportIndexedf(viewport, x, y, w, h));
 }
 #endif
@@ -56,7 +73,10 @@ inline glm::ivec4 Viewport(GLint viewport) {
 /// Sets the depth range of the current viewport.
 /** @see glDepthRangef */
 inline void DepthRange(GLclampf near_z, GLclampf far_z) {
-	gl(DepthRangef(near_z, far_z));
+	if (CacheState(&StateCache::depth_range,
+	               glm::dvec2(GLdouble(near_z), GLdouble(far_z)))) {
+		gl(DepthRangef(near_z, far_z));
+	}
 }
 #endif
 
@@ -64,7 +84,9 @@ inline void DepthRange(GLclampf near_z, GLclampf far_z) {
 /// Sets the depth range of the current viewport.
 /** @see glDepthRange */
 inline void DepthRange(GLclampd near_z, GLclampd far_z) {
-	gl(DepthRange(near_z, far_z));
+	if (CacheState(&StateCache::depth_range, glm::dvec2(near_z, far_z))) {
+		gl(DepthRange(near_z, far_z));
+	}
 }
 #endif
 
@@ -72,9 +94,11 @@ inline void DepthRange(GLclampd near_z, GLclampd far_z) {
 /// Returns the depth range of the current viewport.
 /** @see glDepthRange */
 inline glm::dvec2 DepthRange() {
-	GLdouble data[2];
-	gl(GetDoublev(GL_DEPTH_RANGE, data));
-	return glm::dvec2(data[0], data[1]);
+	return CachedQuery(&StateCache::depth_range, [] {
+		GLdouble data[2];
+		gl(GetDoublev(GL_DEPTH_RANGE, data));
+		return glm::dvec2(data[0], data[1]);
+	});
 }
 #endif
 
@@ -82,6 +106,7 @@ inline glm::dvec2 DepthRange() {
 /// Sets the depth range of the specified viewport.
 /** @see glDepthRangeIndexed */
 inline void DepthRange(GLint viewport, GLclampd near_z, GLclampd far_z) {
+	ForgetCachedState(&StateCache::depth_range);
 	gl(DepthRangeIndexed(viewport, near_z, far_z));
 }
 #endif
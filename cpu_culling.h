@@ -0,0 +1,519 @@
+// Copyright (c) Tamas Csala
+
+/** @file cpu_culling.h
+    @brief Implements SIMD frustum and cone culling of bounding volume lists
+           on the CPU.
+*/
+
+#ifndef OGLWRAP_CPU_CULLING_H_
+#define OGLWRAP_CPU_CULLING_H_
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "./config.h"
+#include "./frustum.h"
+#include "./thread_pool.h"
+
+#if OGLWRAP_USE_AVX2
+  #include <immintrin.h>
+#elif OGLWRAP_USE_SSE2
+  #include <emmintrin.h>
+#endif
+#if OGLWRAP_USE_NEON
+  #include <arm_neon.h>
+#endif
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/*
+ * The bounding volumes are stored in structure of arrays layout, so the
+ * kernels can load the same component of 8 (AVX2) or 4 (SSE2, NEON) volumes
+ * with a single instruction. The kernels write the indices of the visible
+ * volumes into a compacted list, and can split the work between the threads of
+ * a ThreadPool.
+ */
+
+/// A list of bounding spheres in structure of arrays layout.
+class BoundingSpheres {
+ public:
+  /// Preallocates space for count spheres.
+  void reserve(size_t count) {
+    x_.reserve(count); y_.reserve(count); z_.reserve(count);
+    radius_.reserve(count);
+  }
+
+  /// Removes every sphere.
+  void clear() {
+    x_.clear(); y_.clear(); z_.clear(); radius_.clear();
+  }
+
+  /// Appends a sphere, and returns its index.
+  size_t add(const glm::vec3& center, float radius) {
+    x_.push_back(center.x); y_.push_back(center.y); z_.push_back(center.z);
+    radius_.push_back(radius);
+    return x_.size() - 1;
+  }
+
+  /// Changes a sphere (for ex. of a moving object).
+  void set(size_t index, const glm::vec3& center, float radius) {
+    x_[index] = center.x; y_[index] = center.y; z_[index] = center.z;
+    radius_[index] = radius;
+  }
+
+  size_t size() const { return x_.size(); }
+  const float* x() const { return x_.data(); }
+  const float* y() const { return y_.data(); }
+  const float* z() const { return z_.data(); }
+  const float* radius() const { return radius_.data(); }
+
+ private:
+  std::vector<float> x_, y_, z_, radius_;
+};
+
+/// A list of axis aligned bounding boxes in structure of arrays layout.
+/** The boxes are stored as center and half extent. */
+class BoundingBoxes {
+ public:
+  /// Preallocates space for count boxes.
+  void reserve(size_t count) {
+    for (std::vector<float>* v : {&cx_, &cy_, &cz_, &ex_, &ey_, &ez_}) {
+      v->reserve(count);
+    }
+  }
+
+  /// Removes every box.
+  void clear() {
+    for (std::vector<float>* v : {&cx_, &cy_, &cz_, &ex_, &ey_, &ez_}) {
+      v->clear();
+    }
+  }
+
+  /// Appends a box given by its corners, and returns its index.
+  size_t add(const glm::vec3& min, const glm::vec3& max) {
+    cx_.push_back(0); cy_.push_back(0); cz_.push_back(0);
+    ex_.push_back(0); ey_.push_back(0); ez_.push_back(0);
+    set(cx_.size() - 1, min, max);
+    return cx_.size() - 1;
+  }
+
+  /// Changes a box (for ex. of a moving object).
+  void set(size_t index, const glm::vec3& min, const glm::vec3& max) {
+    cx_[index] = (min.x + max.x) * 0.5f; ex_[index] = (max.x - min.x) * 0.5f;
+    cy_[index] = (min.y + max.y) * 0.5f; ey_[index] = (max.y - min.y) * 0.5f;
+    cz_[index] = (min.z + max.z) * 0.5f; ez_[index] = (max.z - min.z) * 0.5f;
+  }
+
+  size_t size() const { return cx_.size(); }
+  const float* centerX() const { return cx_.data(); }
+  const float* centerY() const { return cy_.data(); }
+  const float* centerZ() const { return cz_.data(); }
+  const float* extentX() const { return ex_.data(); }
+  const float* extentY() const { return ey_.data(); }
+  const float* extentZ() const { return ez_.data(); }
+
+ private:
+  std::vector<float> cx_, cy_, cz_, ex_, ey_, ez_;
+};
+
+/**
+ * @brief A list of normal cones in structure of arrays layout.
+ *
+ * A normal cone bounds the facing of a cluster of triangles (a submesh). If
+ * the camera sees every triangle of the cluster from behind, it can be
+ * culled. A cone is described by its apex, its (unit length) axis, and the
+ * cosine of the half angle (cutoff); the cluster is back facing if
+ * dot(normalize(apex - camera), axis) >= cutoff.
+ */
+class BoundingCones {
+ public:
+  /// Preallocates space for count cones.
+  void reserve(size_t count) {
+    for (std::vector<float>* v : {&ax_, &ay_, &az_, &dx_, &dy_, &dz_,
+                                  &cutoff_}) {
+      v->reserve(count);
+    }
+  }
+
+  /// Removes every cone.
+  void clear() {
+    for (std::vector<float>* v : {&ax_, &ay_, &az_, &dx_, &dy_, &dz_,
+                                  &cutoff_}) {
+      v->clear();
+    }
+  }
+
+  /// Appends a cone, and returns its index.
+  size_t add(const glm::vec3& apex, const glm::vec3& axis, float cutoff) {
+    ax_.push_back(apex.x); ay_.push_back(apex.y); az_.push_back(apex.z);
+    dx_.push_back(axis.x); dy_.push_back(axis.y); dz_.push_back(axis.z);
+    cutoff_.push_back(cutoff);
+    return ax_.size() - 1;
+  }
+
+  size_t size() const { return ax_.size(); }
+  const float* apexX() const { return ax_.data(); }
+  const float* apexY() const { return ay_.data(); }
+  const float* apexZ() const { return az_.data(); }
+  const float* axisX() const { return dx_.data(); }
+  const float* axisY() const { return dy_.data(); }
+  const float* axisZ() const { return dz_.data(); }
+  const float* cutoff() const { return cutoff_.data(); }
+
+ private:
+  std::vector<float> ax_, ay_, az_, dx_, dy_, dz_, cutoff_;
+};
+
+/// The scalar operations of the culling kernels, for the leftover volumes
+/// and for targets without SIMD.
+struct ScalarCullingOps {
+  static constexpr size_t kWidth = 1;
+  typedef float Float;
+  typedef bool Mask;
+
+  static Float Load(const float* p) { return *p; }
+  static Float Splat(float value) { return value; }
+  static Float Add(Float a, Float b) { return a + b; }
+  static Float Sub(Float a, Float b) { return a - b; }
+  static Float Mul(Float a, Float b) { return a * b; }
+  static Float Abs(Float a) { return std::abs(a); }
+  static Float Sqrt(Float a) { return std::sqrt(a); }
+  static Mask GreaterEqual(Float a, Float b) { return a >= b; }
+  static Mask Less(Float a, Float b) { return a < b; }
+  static Mask And(Mask a, Mask b) { return a && b; }
+  static unsigned Bits(Mask a) { return a ? 1u : 0u; }
+};
+
+#if OGLWRAP_USE_AVX2
+/// The SIMD operations of the culling kernels, processing 8 volumes at once.
+struct SimdCullingOps {
+  static constexpr size_t kWidth = 8;
+  typedef __m256 Float;
+  typedef __m256 Mask;
+
+  static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+  static Float Splat(float value) { return _mm256_set1_ps(value); }
+  static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+  static Float Abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+  static Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+  static Mask GreaterEqual(Float a, Float b) {
+    return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+  }
+  static Mask Less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+  static unsigned Bits(Mask a) { return unsigned(_mm256_movemask_ps(a)); }
+};
+#elif OGLWRAP_USE_SSE2
+/// The SIMD operations of the culling kernels, processing 4 volumes at once.
+struct SimdCullingOps {
+  static constexpr size_t kWidth = 4;
+  typedef __m128 Float;
+  typedef __m128 Mask;
+
+  static Float Load(const float* p) { return _mm_loadu_ps(p); }
+  static Float Splat(float value) { return _mm_set1_ps(value); }
+  static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float Abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+  static Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+  static Mask GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+  static Mask Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+  static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+  static unsigned Bits(Mask a) { return unsigned(_mm_movemask_ps(a)); }
+};
+#elif OGLWRAP_USE_NEON
+/// The SIMD operations of the culling kernels, processing 4 volumes at once.
+struct SimdCullingOps {
+  static constexpr size_t kWidth = 4;
+  typedef float32x4_t Float;
+  typedef uint32x4_t Mask;
+
+  static Float Load(const float* p) { return vld1q_f32(p); }
+  static Float Splat(float value) { return vdupq_n_f32(value); }
+  static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+  static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+  static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+  static Float Abs(Float a) { return vabsq_f32(a); }
+  static Float Sqrt(Float a) { return vsqrtq_f32(a); }
+  static Mask GreaterEqual(Float a, Float b) { return vcgeq_f32(a, b); }
+  static Mask Less(Float a, Float b) { return vcltq_f32(a, b); }
+  static Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+  static unsigned Bits(Mask a) {
+    const uint32_t weights[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(a, vld1q_u32(weights)));
+  }
+};
+#endif
+
+template <typename Ops>
+/// Appends the indices of the lanes set in bits to the visible list.
+/** Branchless: every index is written, but the count only advances for the
+  * visible ones. visible must have room for kWidth more indices. */
+inline size_t AppendVisible(unsigned bits, size_t first_index, GLuint* visible,
+                            size_t visible_count) {
+  for (size_t lane = 0; lane < Ops::kWidth; ++lane) {
+    visible[visible_count] = GLuint(first_index + lane);
+    visible_count += (bits >> lane) & 1;
+  }
+  return visible_count;
+}
+
+template <typename Ops>
+/// Culls the spheres from *index, while a full SIMD batch fits before end.
+inline size_t CullSpheresWith(const Frustum& frustum,
+                              const BoundingSpheres& spheres, size_t* index,
+                              size_t end, GLuint* visible,
+                              size_t visible_count) {
+  typedef typename Ops::Float Float;
+  typedef typename Ops::Mask Mask;
+
+  Float planes[Frustum::kPlaneNum][4];
+  for (int p = 0; p < Frustum::kPlaneNum; ++p) {
+    for (int c = 0; c < 4; ++c) {
+      planes[p][c] = Ops::Splat(frustum.planes[p][c]);
+    }
+  }
+  Float zero = Ops::Splat(0.0f);
+
+  size_t i = *index;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    Float x = Ops::Load(spheres.x() + i), y = Ops::Load(spheres.y() + i);
+    Float z = Ops::Load(spheres.z() + i);
+    Float neg_radius = Ops::Sub(zero, Ops::Load(spheres.radius() + i));
+    auto in_front = [&](int p) -> Mask {
+      Float distance = Ops::Add(Ops::Add(Ops::Mul(planes[p][0], x),
+                                         Ops::Mul(planes[p][1], y)),
+                                Ops::Add(Ops::Mul(planes[p][2], z),
+                                         planes[p][3]));
+      return Ops::GreaterEqual(distance, neg_radius);
+    };
+    Mask inside = in_front(0);
+    for (int p = 1; p < Frustum::kPlaneNum; ++p) {
+      inside = Ops::And(inside, in_front(p));
+    }
+    visible_count = AppendVisible<Ops>(Ops::Bits(inside), i, visible,
+                                       visible_count);
+  }
+  *index = i;
+  return visible_count;
+}
+
+template <typename Ops>
+/// Culls the boxes from *index, while a full SIMD batch fits before end.
+inline size_t CullBoxesWith(const Frustum& frustum, const BoundingBoxes& boxes,
+                            size_t* index, size_t end, GLuint* visible,
+                            size_t visible_count) {
+  typedef typename Ops::Float Float;
+  typedef typename Ops::Mask Mask;
+
+  Float planes[Frustum::kPlaneNum][4], abs_normals[Frustum::kPlaneNum][3];
+  for (int p = 0; p < Frustum::kPlaneNum; ++p) {
+    for (int c = 0; c < 4; ++c) {
+      planes[p][c] = Ops::Splat(frustum.planes[p][c]);
+    }
+    for (int c = 0; c < 3; ++c) {
+      abs_normals[p][c] = Ops::Splat(std::abs(frustum.planes[p][c]));
+    }
+  }
+  Float zero = Ops::Splat(0.0f);
+
+  size_t i = *index;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    Float cx = Ops::Load(boxes.centerX() + i);
+    Float cy = Ops::Load(boxes.centerY() + i);
+    Float cz = Ops::Load(boxes.centerZ() + i);
+    Float ex = Ops::Load(boxes.extentX() + i);
+    Float ey = Ops::Load(boxes.extentY() + i);
+    Float ez = Ops::Load(boxes.extentZ() + i);
+    auto in_front = [&](int p) -> Mask {
+      // The distance of the corner, that is the farthest along the normal.
+      Float distance = Ops::Add(Ops::Add(Ops::Mul(planes[p][0], cx),
+                                         Ops::Mul(planes[p][1], cy)),
+                                Ops::Add(Ops::Mul(planes[p][2], cz),
+                                         planes[p][3]));
+      Float radius = Ops::Add(Ops::Add(Ops::Mul(abs_normals[p][0], ex),
+                                       Ops::Mul(abs_normals[p][1], ey)),
+                              Ops::Mul(abs_normals[p][2], ez));
+      return Ops::GreaterEqual(Ops::Add(distance, radius), zero);
+    };
+    Mask inside = in_front(0);
+    for (int p = 1; p < Frustum::kPlaneNum; ++p) {
+      inside = Ops::And(inside, in_front(p));
+    }
+    visible_count = AppendVisible<Ops>(Ops::Bits(inside), i, visible,
+                                       visible_count);
+  }
+  *index = i;
+  return visible_count;
+}
+
+template <typename Ops>
+/// Culls the cones from *index, while a full SIMD batch fits before end.
+inline size_t CullConesWith(const glm::vec3& camera, const BoundingCones& cones,
+                            size_t* index, size_t end, GLuint* visible,
+                            size_t visible_count) {
+  typedef typename Ops::Float Float;
+
+  Float camera_x = Ops::Splat(camera.x), camera_y = Ops::Splat(camera.y);
+  Float camera_z = Ops::Splat(camera.z);
+
+  size_t i = *index;
+  for (; i + Ops::kWidth <= end; i += Ops::kWidth) {
+    Float vx = Ops::Sub(Ops::Load(cones.apexX() + i), camera_x);
+    Float vy = Ops::Sub(Ops::Load(cones.apexY() + i), camera_y);
+    Float vz = Ops::Sub(Ops::Load(cones.apexZ() + i), camera_z);
+    Float dot = Ops::Add(Ops::Add(Ops::Mul(vx, Ops::Load(cones.axisX() + i)),
+                                  Ops::Mul(vy, Ops::Load(cones.axisY() + i))),
+                         Ops::Mul(vz, Ops::Load(cones.axisZ() + i)));
+    Float length = Ops::Sqrt(Ops::Add(Ops::Add(Ops::Mul(vx, vx),
+                                               Ops::Mul(vy, vy)),
+                                      Ops::Mul(vz, vz)));
+    // dot(normalize(v), axis) < cutoff, without the division.
+    Float limit = Ops::Mul(Ops::Load(cones.cutoff() + i), length);
+    visible_count = AppendVisible<Ops>(Ops::Bits(Ops::Less(dot, limit)), i,
+                                       visible, visible_count);
+  }
+  *index = i;
+  return visible_count;
+}
+
+/**
+ * @brief Writes the indices of the spheres in [begin, end), that intersect
+ *        the frustum, to visible.
+ *
+ * @param visible  Must have room for end - begin indices.
+ * @return The number of visible spheres.
+ */
+inline size_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres,
+                          size_t begin, size_t end, GLuint* visible) {
+  size_t visible_count = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  visible_count = CullSpheresWith<SimdCullingOps>(
+      frustum, spheres, &begin, end, visible, visible_count);
+#endif
+  return CullSpheresWith<ScalarCullingOps>(frustum, spheres, &begin, end,
+                                           visible, visible_count);
+}
+
+/**
+ * @brief Writes the indices of the boxes in [begin, end), that intersect the
+ *        frustum, to visible.
+ *
+ * @param visible  Must have room for end - begin indices.
+ * @return The number of visible boxes.
+ */
+inline size_t CullBoxes(const Frustum& frustum, const BoundingBoxes& boxes,
+                        size_t begin, size_t end, GLuint* visible) {
+  size_t visible_count = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  visible_count = CullBoxesWith<SimdCullingOps>(
+      frustum, boxes, &begin, end, visible, visible_count);
+#endif
+  return CullBoxesWith<ScalarCullingOps>(frustum, boxes, &begin, end,
+                                         visible, visible_count);
+}
+
+/**
+ * @brief Writes the indices of the cones in [begin, end), that aren't back
+ *        facing from the camera, to visible.
+ *
+ * @param visible  Must have room for end - begin indices.
+ * @return The number of visible cones.
+ */
+inline size_t CullCones(const glm::vec3& camera, const BoundingCones& cones,
+                        size_t begin, size_t end, GLuint* visible) {
+  size_t visible_count = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  visible_count = CullConesWith<SimdCullingOps>(
+      camera, cones, &begin, end, visible, visible_count);
+#endif
+  return CullConesWith<ScalarCullingOps>(camera, cones, &begin, end, visible,
+                                         visible_count);
+}
+
+/// The number of volumes a task of a parallel culling processes.
+constexpr size_t kCullingChunkSize = 16384;
+
+template <typename Kernel>
+/// Runs a culling kernel on chunks of [0, count), and compacts the results.
+/** @param kernel  Called as kernel(begin, end, visible), returns the number
+  *                of indices written. */
+inline size_t CullInChunks(size_t count, GLuint* visible, ThreadPool* pool,
+                           const Kernel& kernel) {
+  size_t chunk_count = (count + kCullingChunkSize - 1) / kCullingChunkSize;
+  std::vector<size_t> chunk_visible(chunk_count);
+  auto cull_chunk = [&](size_t chunk) {
+    size_t begin = chunk * kCullingChunkSize;
+    size_t end = std::min(begin + kCullingChunkSize, count);
+    chunk_visible[chunk] = kernel(begin, end, visible + begin);
+  };
+  if (pool) {
+    pool->run(chunk_count, cull_chunk);
+  } else {
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      cull_chunk(chunk);
+    }
+  }
+
+  // Each chunk wrote its indices to the start of its own range.
+  size_t visible_count = 0;
+  for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+    std::memmove(visible + visible_count, visible + chunk * kCullingChunkSize,
+                 chunk_visible[chunk] * sizeof(GLuint));
+    visible_count += chunk_visible[chunk];
+  }
+  return visible_count;
+}
+
+/// Writes the indices of the spheres, that intersect the frustum, to visible.
+/** @param visible  Must have room for spheres.size() indices.
+  * @param pool     If not null, the work is split between its threads.
+  * @return The number of visible spheres. */
+inline size_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres,
+                          GLuint* visible, ThreadPool* pool = nullptr) {
+  return CullInChunks(spheres.size(), visible, pool,
+      [&](size_t begin, size_t end, GLuint* chunk_visible) {
+    return CullSpheres(frustum, spheres, begin, end, chunk_visible);
+  });
+}
+
+/// Writes the indices of the boxes, that intersect the frustum, to visible.
+/** @param visible  Must have room for boxes.size() indices.
+  * @param pool     If not null, the work is split between its threads.
+  * @return The number of visible boxes. */
+inline size_t CullBoxes(const Frustum& frustum, const BoundingBoxes& boxes,
+                        GLuint* visible, ThreadPool* pool = nullptr) {
+  return CullInChunks(boxes.size(), visible, pool,
+      [&](size_t begin, size_t end, GLuint* chunk_visible) {
+    return CullBoxes(frustum, boxes, begin, end, chunk_visible);
+  });
+}
+
+/// Writes the indices of the cones, that aren't back facing, to visible.
+/** @param visible  Must have room for cones.size() indices.
+  * @param pool     If not null, the work is split between its threads.
+  * @return The number of visible cones. */
+inline size_t CullCones(const glm::vec3& camera, const BoundingCones& cones,
+                        GLuint* visible, ThreadPool* pool = nullptr) {
+  return CullInChunks(cones.size(), visible, pool,
+      [&](size_t begin, size_t end, GLuint* chunk_visible) {
+    return CullCones(camera, cones, begin, end, chunk_visible);
+  });
+}
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_CPU_CULLING_H_
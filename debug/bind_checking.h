@@ -11,6 +11,7 @@
 #include <iostream>
 
 #include "./error_checking.h"
+#include "../context/state_cache.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
@@ -46,10 +47,10 @@ namespace OGLWRAP_NAMESPACE_NAME {
   if (!OGLWRAP_currentlyBoundTarget(bind_target))               \
     OGLWRAP_print_default_object_is_bound_error(__FILE__, OGLWRAP_FUNCTION_MACRO, __LINE__);
 
+/// Returns the object bound to a (non-texture) binding point.
+/** Uses the StateCache, if there's one current. */
 inline GLint OGLWRAP_currentlyBoundTarget(GLenum target) {
-  GLint currently_bound_target;
-  glGetIntegerv(target, &currently_bound_target);
-  return currently_bound_target;
+  return GLint(CachedBoundName(target));
 }
 
 /// A function used by OGLWRAP_CHECK_FOR_DEFAULT_BINDING() macro
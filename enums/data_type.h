@@ -39,6 +39,12 @@ enum class DataType : GLenum {
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_UNSIGNED_INT)
   kUnsignedInt = GL_UNSIGNED_INT,
 #endif
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT_2_10_10_10_REV)
+  kInt2101010Rev = GL_INT_2_10_10_10_REV,
+#endif
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_UNSIGNED_INT_2_10_10_10_REV)
+  kUnsignedInt2101010Rev = GL_UNSIGNED_INT_2_10_10_10_REV,
+#endif
 };
 
 }  // namespace enums
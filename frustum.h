@@ -0,0 +1,76 @@
+// Copyright (c) Tamas Csala
+
+/** @file frustum.h
+    @brief Implements a view frustum, that bounding volumes can be tested
+           against.
+*/
+
+#ifndef OGLWRAP_FRUSTUM_H_
+#define OGLWRAP_FRUSTUM_H_
+
+#include <cmath>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "./config.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief The six planes of a view frustum.
+ *
+ * Each plane is stored as (normal, distance), the normal points into the
+ * frustum and has unit length, so dot(normal, point) + distance is the signed
+ * distance of the point from the plane.
+ */
+struct Frustum {
+  /// The order of the planes.
+  enum Plane { kLeft, kRight, kBottom, kTop, kNear, kFar, kPlaneNum };
+
+  glm::vec4 planes[kPlaneNum];
+
+  /// Extracts the planes from a projection * view (* model) matrix.
+  /** The planes are in the space, that the matrix transforms from (world
+    * space for a projection * view matrix). Expects the OpenGL clip space
+    * conventions (-w <= z <= w). */
+  static Frustum FromMatrix(const glm::mat4& matrix) {
+    Frustum frustum;
+    for (int i = 0; i < kPlaneNum; ++i) {
+      int row = i / 2;
+      float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+      glm::vec4 plane;
+      for (int col = 0; col < 4; ++col) {
+        plane[col] = matrix[col][3] + sign * matrix[col][row];
+      }
+      float length = std::sqrt(plane.x*plane.x + plane.y*plane.y +
+                               plane.z*plane.z);
+      for (int col = 0; col < 4; ++col) {
+        plane[col] /= length;
+      }
+      frustum.planes[i] = plane;
+    }
+    return frustum;
+  }
+
+  /// Returns false if the sphere is surely outside of the frustum.
+  /** Spheres near the corners might be reported as intersecting even if
+    * they are outside, which is fine for culling. */
+  bool intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < kPlaneNum; ++i) {
+      const glm::vec4& p = planes[i];
+      if (p.x*center.x + p.y*center.y + p.z*center.z + p.w < -radius) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_FRUSTUM_H_
@@ -12,6 +12,7 @@
 
 #include "config.h"
 #include "enums/shader_type.h"
+#include "context/state_cache.h"
 
 #include "./define_internal_macros.h"
 
@@ -65,7 +66,10 @@ namespace globjects {
   class Program : public glObject {
   public:
     Program() { handle_ = gl(CreateProgram()); }
-    ~Program() { gl(DeleteProgram(handle_)); }
+    ~Program() {
+      ForgetBoundName(handle_);
+      gl(DeleteProgram(handle_));
+    }
 
     Program(Program&&) noexcept = default;
     Program& operator=(Program&&) noexcept = default;
@@ -77,7 +81,10 @@ namespace globjects {
   class Buffer : public glObject {
    public:
     Buffer() { gl(GenBuffers(1, &handle_)); }
-    ~Buffer() { gl(DeleteBuffers(1, &handle_)); }
+    ~Buffer() {
+      ForgetBoundName(handle_);
+      gl(DeleteBuffers(1, &handle_));
+    }
 
     Buffer(Buffer&&) noexcept = default;
     Buffer& operator=(Buffer&&) noexcept = default;
@@ -89,7 +96,10 @@ namespace globjects {
   class Renderbuffer : public glObject {
    public:
     Renderbuffer() { gl(GenRenderbuffers(1, &handle_)); }
-    ~Renderbuffer() { gl(DeleteRenderbuffers(1, &handle_)); }
+    ~Renderbuffer() {
+      ForgetBoundName(handle_);
+      gl(DeleteRenderbuffers(1, &handle_));
+    }
 
     Renderbuffer(Renderbuffer&&) noexcept = default;
     Renderbuffer& operator=(Renderbuffer&&) noexcept = default;
@@ -101,7 +111,10 @@ namespace globjects {
   class Framebuffer : public glObject {
    public:
     Framebuffer() { gl(GenFramebuffers(1, &handle_)); }
-    ~Framebuffer() { gl(DeleteFramebuffers(1, &handle_)); }
+    ~Framebuffer() {
+      ForgetBoundName(handle_);
+      gl(DeleteFramebuffers(1, &handle_));
+    }
 
     Framebuffer(Framebuffer&&) noexcept = default;
     Framebuffer& operator=(Framebuffer&&) noexcept = default;
@@ -113,7 +126,10 @@ namespace globjects {
   class TransformFeedback : public glObject {
    public:
     TransformFeedback() { gl(GenTransformFeedbacks(1, &handle_)); }
-    ~TransformFeedback() { gl(DeleteTransformFeedbacks(1, &handle_)); }
+    ~TransformFeedback() {
+      ForgetBoundName(handle_);
+      gl(DeleteTransformFeedbacks(1, &handle_));
+    }
 
     TransformFeedback(TransformFeedback&&) noexcept = default;
     TransformFeedback& operator=(TransformFeedback&&) noexcept = default;
@@ -125,17 +141,39 @@ namespace globjects {
   class VertexArray : public glObject {
    public:
     VertexArray() { gl(GenVertexArrays(1, &handle_)); }
-    ~VertexArray() { gl(DeleteVertexArrays(1, &handle_)); }
+    ~VertexArray() {
+      ForgetBoundName(handle_);
+      ForgetBindings(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+      gl(DeleteVertexArrays(1, &handle_));
+    }
 
     VertexArray(VertexArray&&) noexcept = default;
     VertexArray& operator=(VertexArray&&) noexcept = default;
   };
 #endif
 
+#if OGLWRAP_DEFINE_EVERYTHING || \
+    (defined(glGenSamplers) && defined(glDeleteSamplers))
+  class Sampler : public glObject {
+   public:
+    Sampler() { gl(GenSamplers(1, &handle_)); }
+    ~Sampler() {
+      ForgetBoundName(handle_);
+      gl(DeleteSamplers(1, &handle_));
+    }
+
+    Sampler(Sampler&&) noexcept = default;
+    Sampler& operator=(Sampler&&) noexcept = default;
+  };
+#endif
+
 class Texture : public glObject {
  public:
   Texture() { gl(GenTextures(1, &handle_)); }
-  ~Texture() { gl(DeleteTextures(1, &handle_)); }
+  ~Texture() {
+    ForgetBoundName(handle_);
+    gl(DeleteTextures(1, &handle_));
+  }
 
   Texture(Texture&&) noexcept = default;
   Texture& operator=(Texture&&) noexcept = default;
@@ -0,0 +1,283 @@
+// Copyright (c) Tamas Csala
+
+/** @file gpu_culling.h
+    @brief Implements frustum culling in a compute shader, that emits the
+           indirect draw commands of the visible objects.
+*/
+
+#ifndef OGLWRAP_GPU_CULLING_H_
+#define OGLWRAP_GPU_CULLING_H_
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "./frustum.h"
+#include "./program.h"
+#include "./shader.h"
+#include "context/binding.h"
+#include "context/computing.h"
+#include "context/drawing.h"
+#include "context/extensions.h"
+#include "context/synchronization.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glDispatchCompute) && defined(glMemoryBarrier) \
+        && defined(glMultiDrawElementsIndirect) \
+        && defined(glClearBufferData) && defined(glBindBufferBase) \
+        && defined(GL_SHADER_STORAGE_BUFFER) \
+        && defined(GL_ATOMIC_COUNTER_BUFFER))
+/**
+ * @brief Culls objects against the view frustum on the GPU, and draws the
+ *        visible ones with a single indirect multi-draw.
+ *
+ * Every object has a bounding sphere and the DrawElementsIndirectCommand, that
+ * draws it. A compute shader tests the spheres against the frustum, and
+ * appends the commands of the visible objects to an IndirectBuffer, counting
+ * them with an atomic counter. The CPU doesn't touch the objects per frame.
+ *
+ * With OpenGL 4.6 (or ARB_indirect_parameters) the number of draws is read
+ * from the atomic counter by MultiDrawElementsIndirectCount. Otherwise the
+ * command buffer is cleared before culling, and MultiDrawElementsIndirect
+ * draws every slot, the unused ones having zero indices.
+ * @code
+ *   gl::GpuFrustumCuller culler(objects.size());
+ *   culler.objects(objects);  // when the objects change
+ *
+ *   // every frame
+ *   culler.cull(gl::Frustum::FromMatrix(projection * view));
+ *   gl::Bind(vao);
+ *   culler.draw(gl::PrimType::kTriangles, gl::IndexType::kUnsignedInt);
+ * @endcode
+ * The base_instance of the commands can be used to look up per-object data
+ * (like transforms) in the vertex shader. The functions of the culler change
+ * the program and the buffer bindings.
+ */
+class GpuFrustumCuller {
+ public:
+  /// An object to be culled, in the layout the compute shader reads it.
+  struct Object {
+    glm::vec4 bounding_sphere;  // center (xyz) and radius (w)
+    DrawElementsIndirectCommand command;
+    GLuint padding[3];
+  };
+  static_assert(sizeof(Object) == 48, "Object must match the std430 layout");
+
+  /// The number of invocations in a compute work group.
+  static constexpr GLuint kWorkGroupSize = 64;
+
+  /// Compiles the culling shader, and allocates the buffers.
+  /** @param max_objects  The maximum number of objects. */
+  explicit GpuFrustumCuller(size_t max_objects)
+      : max_objects_(max_objects), object_count_(0), use_draw_count_(false) {
+    ShaderSource source;
+    source.set_source(ShaderSourceCode());
+    Shader shader(ShaderType::kComputeShader, source);
+    program_.attachShader(shader);
+    program_.link();
+
+    Bind(objects_);
+    objects_.data(GLsizei(max_objects_ * sizeof(Object)), nullptr,
+                  BufferUsage::kStaticDraw);
+    Bind(commands_);
+    commands_.data(
+        GLsizei(max_objects_ * sizeof(DrawElementsIndirectCommand)), nullptr,
+        BufferUsage::kDynamicCopy);
+    Bind(counter_);
+    counter_.data(sizeof(GLuint), nullptr, BufferUsage::kDynamicCopy);
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glMultiDrawElementsIndirectCount) \
+        && defined(GL_PARAMETER_BUFFER) && defined(glGetStringi))
+    use_draw_count_ = DrawCountSupported();
+#endif
+  }
+
+  /// Uploads the objects to be culled.
+  /** Only the first max_objects of them are used. */
+  void objects(const Object* objects, size_t count) {
+    object_count_ = std::min(count, max_objects_);
+    if (object_count_ != 0) {
+      Bind(objects_);
+      objects_.subData(0, GLsizei(object_count_ * sizeof(Object)), objects);
+    }
+  }
+
+  /// Uploads the objects to be culled.
+  void objects(const std::vector<Object>& objects) {
+    this->objects(objects.data(), objects.size());
+  }
+
+  /// Culls the objects, and writes the commands of the visible ones.
+  void cull(const Frustum& frustum) {
+    GLuint zero = 0;
+    Bind(counter_);
+    counter_.subData(0, sizeof(GLuint), &zero);
+    if (!use_draw_count_) {
+      Bind(commands_);
+      gl(ClearBufferData(GL_DRAW_INDIRECT_BUFFER, GL_R32UI, GL_RED_INTEGER,
+                         GL_UNSIGNED_INT, nullptr));
+    }
+    if (object_count_ == 0) {
+      return;
+    }
+
+    Use(program_);
+    gl(Uniform4fv(kPlanesLocation, Frustum::kPlaneNum, &frustum.planes[0].x));
+    gl(Uniform1ui(kObjectCountLocation, GLuint(object_count_)));
+    BindBase(objects_, kObjectsBinding);
+    // The command buffer is an IndirectBuffer, it's written as a storage
+    // buffer only here.
+    gl(BindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandsBinding,
+                      commands_.expose()));
+    ForgetBindings(GL_SHADER_STORAGE_BUFFER_BINDING);
+    BindBase(counter_, kCounterBinding);
+
+    GLuint group_count = GLuint(
+        (object_count_ + kWorkGroupSize - 1) / kWorkGroupSize);
+    DispatchCompute(group_count, 1, 1);
+    MemoryBarrier({MemoryBarrierBit::kCommandBarrierBit,
+                   MemoryBarrierBit::kBufferUpdateBarrierBit});
+  }
+
+  /// Draws the objects, that were found visible by the last cull().
+  /** The VAO (with the index buffer) used by the commands has to be bound. */
+  void draw(PrimType type, IndexType index_type) const {
+    Bind(commands_);
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glMultiDrawElementsIndirectCount) \
+        && defined(GL_PARAMETER_BUFFER))
+    if (use_draw_count_) {
+      if (CacheBinding(GL_PARAMETER_BUFFER_BINDING, StateCache::kNoIndex,
+                       counter_.expose())) {
+        gl(BindBuffer(GL_PARAMETER_BUFFER, counter_.expose()));
+      }
+      MultiDrawElementsIndirectCount(type, index_type, 0,
+                                     GLsizei(object_count_));
+      return;
+    }
+#endif
+    MultiDrawElementsIndirect(type, index_type, GLsizei(object_count_));
+  }
+
+  /// Reads back the number of visible objects.
+  /** Waits for the GPU to finish the culling, use it only for debugging. */
+  GLuint readDrawCount() const {
+    Bind(counter_);
+    AtomicCounterBuffer::TypedMap<GLuint> map(
+        0, sizeof(GLuint), {BufferMapAccessFlags::kMapReadBit});
+    return *map.data();
+  }
+
+  /// Reads back the commands of the visible objects.
+  /** Waits for the GPU to finish the culling, use it only for debugging. */
+  std::vector<DrawElementsIndirectCommand> readCommands() const {
+    GLuint count = readDrawCount();
+    std::vector<DrawElementsIndirectCommand> commands(count);
+    if (count != 0) {
+      Bind(commands_);
+      IndirectBuffer::TypedMap<DrawElementsIndirectCommand> map(
+          0, count * sizeof(DrawElementsIndirectCommand),
+          {BufferMapAccessFlags::kMapReadBit});
+      std::copy(map.data(), map.data() + count, commands.begin());
+    }
+    return commands;
+  }
+
+  /// Returns if the draw count is read by the GPU from the atomic counter.
+  bool usesDrawCount() const { return use_draw_count_; }
+
+  /// Disables reading the draw count on the GPU, even if it is supported.
+  /** Can be used to compare the two draw paths. */
+  void disableDrawCount() { use_draw_count_ = false; }
+
+  /// Returns the number of objects to be culled.
+  size_t objectCount() const { return object_count_; }
+
+  /// Returns the buffer, that holds the commands of the visible objects.
+  const IndirectBuffer& commands() const { return commands_; }
+
+  /// Returns the buffer, that holds the number of visible objects.
+  const AtomicCounterBuffer& drawCount() const { return counter_; }
+
+ private:
+  static constexpr GLint kPlanesLocation = 0;
+  static constexpr GLint kObjectCountLocation = 6;
+  static constexpr GLuint kObjectsBinding = 0;
+  static constexpr GLuint kCommandsBinding = 1;
+  static constexpr GLuint kCounterBinding = 0;
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glMultiDrawElementsIndirectCount) \
+        && defined(GL_PARAMETER_BUFFER) && defined(glGetStringi))
+  // OpenGL 4.6 or ARB_indirect_parameters (which uses the same enums, and
+  // the entry points are aliases of each other).
+  static bool DrawCountSupported() {
+    return IsFeatureSupported(4, 6, "GL_ARB_indirect_parameters");
+  }
+#endif
+
+  static const char* ShaderSourceCode() {
+    return R"(
+    #version 430
+    layout(local_size_x = 64) in;
+
+    struct Object {
+      vec4 sphere;
+      uint count, instance_count, first_index;
+      int base_vertex;
+      uint base_instance, pad0, pad1, pad2;
+    };
+
+    layout(std430, binding = 0) readonly buffer Objects { Object objects[]; };
+    layout(std430, binding = 1) writeonly buffer Commands { uint commands[]; };
+    layout(binding = 0, offset = 0) uniform atomic_uint draw_count;
+    layout(location = 0) uniform vec4 planes[6];
+    layout(location = 6) uniform uint object_count;
+
+    void main() {
+      uint id = gl_GlobalInvocationID.x;
+      if (id >= object_count) {
+        return;
+      }
+      Object object = objects[id];
+      for (int i = 0; i < 6; ++i) {
+        if (dot(planes[i].xyz, object.sphere.xyz) + planes[i].w
+            < -object.sphere.w) {
+          return;
+        }
+      }
+      uint slot = 5 * atomicCounterIncrement(draw_count);
+      commands[slot + 0] = object.count;
+      commands[slot + 1] = object.instance_count;
+      commands[slot + 2] = object.first_index;
+      commands[slot + 3] = uint(object.base_vertex);
+      commands[slot + 4] = object.base_instance;
+    }
+    )";
+  }
+
+  Program program_;
+  ShaderStorageBuffer objects_;
+  IndirectBuffer commands_;
+  AtomicCounterBuffer counter_;
+  size_t max_objects_;
+  size_t object_count_;
+  bool use_draw_count_;
+};
+#endif  // glDispatchCompute && glMultiDrawElementsIndirect
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_GPU_CULLING_H_
@@ -0,0 +1,187 @@
+// Copyright (c) Tamas Csala
+
+/** @file indirect_batcher.h
+    @brief Implements merging of compatible draws into indirect multi-draws.
+*/
+
+#ifndef OGLWRAP_INDIRECT_BATCHER_H_
+#define OGLWRAP_INDIRECT_BATCHER_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "./command_buffer.h"
+#include "context/binding.h"
+#include "context/drawing.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glMultiDrawArraysIndirect) \
+        && defined(glMultiDrawElementsIndirect) \
+        && defined(GL_DRAW_INDIRECT_BUFFER))
+/**
+ * @brief Turns the (sorted) commands of a CommandBuffer into a few indirect
+ *        multi-draw calls.
+ *
+ * Consecutive commands, that use the same program, VAO, material, primitive
+ * type and index type are merged into a single MultiDrawElementsIndirect (or
+ * MultiDrawArraysIndirect) call. The draw parameters are uploaded into an
+ * IndirectBuffer owned by the batcher. Sorting the commands by state first
+ * makes the batches as long as possible, and submeshes sharing a VAO (and the
+ * vertex and index buffers in it) can go out in a handful of API calls.
+ * @code
+ *   commands.sort();
+ *   batcher.build(commands);  // once, or whenever the commands change
+ *   batcher.submit();         // every frame
+ * @endcode
+ * Requires OpenGL 4.3 (or ARB_multi_draw_indirect).
+ */
+class IndirectDrawBatcher {
+ public:
+  /// A merged range of draws, submitted with a single API call.
+  struct Batch {
+    const Program* program;
+    const VertexArray* vao;
+    MaterialBinder material_binder;
+    const void* material;
+    DrawCommand::Kind kind;
+    PrimType primitive;
+    IndexType index_type;   // only for DrawCommand::kElements
+    GLintptr offset;        // into the indirect buffer, in bytes
+    GLsizei draw_count;
+  };
+
+  /// The counters of the last submit().
+  struct Statistics {
+    size_t draws;             ///< The draws in all the batches.
+    size_t api_calls;         ///< The multi-draw calls issued.
+    size_t program_changes;   ///< The programs bound.
+    size_t material_changes;  ///< The material binder calls.
+    size_t vao_changes;       ///< The VAOs bound.
+  };
+
+  IndirectDrawBatcher() : statistics_{0, 0, 0, 0, 0} {}
+
+  /// Builds the batches from the commands (in their submission order), and
+  /// uploads the draw parameters to the indirect buffer.
+  /** This changes the IndirectBuffer binding. */
+  void build(const CommandBuffer& commands) {
+    batches_.clear();
+    parameters_.clear();
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+      const DrawCommand& command = commands.command(i);
+      if (batches_.empty() || !compatible(batches_.back(), command)) {
+        batches_.push_back(Batch{command.program, command.vao,
+                                 command.material_binder, command.material,
+                                 command.kind, command.primitive,
+                                 command.index_type,
+                                 GLintptr(parameters_.size()), 0});
+      }
+      batches_.back().draw_count++;
+
+      if (command.kind == DrawCommand::kElements) {
+        DrawElementsIndirectCommand params = {
+          GLuint(command.count), GLuint(command.inst_count),
+          GLuint(command.first), command.base_vertex, command.base_instance
+        };
+        append(params);
+      } else {
+        DrawArraysIndirectCommand params = {
+          GLuint(command.count), GLuint(command.inst_count),
+          GLuint(command.first), command.base_instance
+        };
+        append(params);
+      }
+    }
+
+    Bind(indirect_buffer_);
+    if (!parameters_.empty()) {
+      indirect_buffer_.data(parameters_);
+    }
+  }
+
+  /// Issues the batches, binding the state only when it changes.
+  /** The last used program and VAO, and the indirect buffer stay bound after
+    * this call. */
+  void submit() {
+    statistics_ = Statistics{0, 0, 0, 0, 0};
+    Bind(indirect_buffer_);
+
+    const Batch* previous = nullptr;
+    for (const Batch& batch : batches_) {
+      if (!previous || previous->program->expose() != batch.program->expose()) {
+        Bind(*batch.program);
+        statistics_.program_changes++;
+      }
+      if (!previous || previous->vao->expose() != batch.vao->expose()) {
+        Bind(*batch.vao);
+        statistics_.vao_changes++;
+      }
+      if (batch.material_binder && (!previous ||
+          previous->material_binder != batch.material_binder ||
+          previous->material != batch.material)) {
+        batch.material_binder(batch.material);
+        statistics_.material_changes++;
+      }
+      previous = &batch;
+
+      const void* indirect = reinterpret_cast<const void*>(batch.offset);
+      if (batch.kind == DrawCommand::kElements) {
+        MultiDrawElementsIndirect(batch.primitive, batch.index_type,
+                                  batch.draw_count, 0, indirect);
+      } else {
+        MultiDrawArraysIndirect(batch.primitive, indirect,
+                                batch.draw_count, 0);
+      }
+      statistics_.api_calls++;
+      statistics_.draws += batch.draw_count;
+    }
+  }
+
+  /// Returns the batches created by the last build().
+  const std::vector<Batch>& batches() const { return batches_; }
+
+  /// Returns the buffer, that holds the draw parameters.
+  const IndirectBuffer& indirectBuffer() const { return indirect_buffer_; }
+
+  /// Returns the counters of the last submit().
+  const Statistics& statistics() const { return statistics_; }
+
+ private:
+  std::vector<Batch> batches_;
+  std::vector<GLubyte> parameters_;
+  IndirectBuffer indirect_buffer_;
+  Statistics statistics_;
+
+  static bool compatible(const Batch& batch, const DrawCommand& command) {
+    return batch.kind == command.kind &&
+           batch.primitive == command.primitive &&
+           (batch.kind == DrawCommand::kArrays ||
+            batch.index_type == command.index_type) &&
+           batch.program->expose() == command.program->expose() &&
+           batch.vao->expose() == command.vao->expose() &&
+           batch.material_binder == command.material_binder &&
+           batch.material == command.material;
+  }
+
+  template <typename T>
+  void append(const T& params) {
+    size_t offset = parameters_.size();
+    parameters_.resize(offset + sizeof(T));
+    std::memcpy(&parameters_[offset], &params, sizeof(T));
+  }
+};
+#endif  // glMultiDrawArraysIndirect && glMultiDrawElementsIndirect
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_INDIRECT_BATCHER_H_
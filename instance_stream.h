@@ -0,0 +1,242 @@
+// Copyright (c) Tamas Csala
+
+/** @file instance_stream.h
+    @brief Implements streaming of per-instance attributes for instanced draws.
+*/
+
+#ifndef OGLWRAP_INSTANCE_STREAM_H_
+#define OGLWRAP_INSTANCE_STREAM_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "./vertex_attrib.h"
+#include "./vertex_format.h"
+#include "context/binding.h"
+#include "context/drawing.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glMapBufferRange) && defined(glUnmapBuffer) \
+        && defined(glFenceSync) && defined(glClientWaitSync) \
+        && defined(glVertexAttribDivisor) \
+        && defined(glDrawArraysInstancedBaseInstance) \
+        && defined(glDrawElementsInstancedBaseInstance))
+template <typename Instance>
+/**
+ * @brief Streams per-instance records (transforms, colors, etc.) from the CPU
+ *        to instanced draws.
+ *
+ * The stream owns a single ArrayBuffer, that is split into frame_count
+ * regions, each holding max_instances records. Every frame writes into the
+ * next region, so the CPU never waits for the GPU to finish reading the
+ * records of the previous frames (a fence guards the reuse of a region).
+ *
+ * The attributes are set up only once, pointing to the start of the buffer,
+ * and the draws select their records with the base instance, so no attribute
+ * pointer has to be changed per draw. The records can be written straight
+ * into the mapped buffer, without any intermediate copy.
+ * @code
+ *   struct Instance { glm::vec4 position_and_scale; glm::vec4 rotation; };
+ *   gl::InstanceStream<Instance> stream(200000);
+ *   gl::Bind(vao);
+ *   stream.setup(gl::VertexFormat{}.add(3, &Instance::position_and_scale)
+ *                                  .add(4, &Instance::rotation));
+ *
+ *   // every frame
+ *   Instance* instances = stream.map(visible_count);
+ *   for (...) { instances[i] = ...; }
+ *   auto range = stream.unmap();
+ *   stream.drawElements(gl::PrimType::kTriangles, ibo, range);
+ *   stream.endFrame();
+ * @endcode
+ * Requires OpenGL 4.2 (for the base instance). The functions of the stream
+ * change the ArrayBuffer binding.
+ */
+class InstanceStream {
+ public:
+  /// A range of records in the stream, that can be drawn.
+  struct Range {
+    GLuint base_instance;
+    GLsizei count;
+  };
+
+  /// Allocates the buffer of the stream.
+  /** @param max_instances  The maximum number of records per frame.
+    * @param frame_count    The number of frames the GPU can lag behind the
+    *                       CPU without making it wait (at least 1). */
+  explicit InstanceStream(size_t max_instances, size_t frame_count = 3)
+      : capacity_(max_instances), region_(0), used_(0), mapped_count_(0),
+        fences_(std::max<size_t>(frame_count, 1), nullptr) {
+    Bind(buffer_);
+    buffer_.data(GLsizei(capacity_ * fences_.size() * sizeof(Instance)),
+                 nullptr, BufferUsage::kStreamDraw);
+  }
+
+  ~InstanceStream() {
+    for (GLsync fence : fences_) {
+      if (fence) {
+        gl(DeleteSync(fence));
+      }
+    }
+  }
+
+  InstanceStream(const InstanceStream&) = delete;
+  InstanceStream& operator=(const InstanceStream&) = delete;
+
+  /// Sets up the attributes of the format as instanced ones, reading from the
+  /// buffer of the stream.
+  /** Has to be called once for every VAO that draws from the stream, while
+    * the VAO is bound.
+    * @param format   The layout of the Instance struct, with the attribute
+    *                 locations used by the shader.
+    * @param divisor  The number of instances that use the same record. */
+  void setup(const VertexFormat& format, GLuint divisor = 1) {
+    Bind(buffer_);
+    format.setup();
+    for (const VertexAttribDescription& attrib : format.attribs()) {
+      VertexAttribObject(attrib.location).divisor(divisor);
+    }
+  }
+
+  /// Maps space for count records in the current frame's region.
+  /** The records have to be written before unmap() is called. The memory is
+    * write only, and its previous content is undefined.
+    * @return Where the records should be written, or nullptr if the region
+    *         of the frame doesn't have enough space left. */
+  Instance* map(size_t count) {
+    if (used_ + count > capacity_) {
+      OGLWRAP_PRINT_ERROR("InstanceStream overflow",
+        "The records of the frame don't fit into the stream, increase its "
+        "max_instances.");
+      return nullptr;
+    }
+    mapped_count_ = count;
+    if (count == 0) {
+      return nullptr;
+    }
+
+    Bind(buffer_);
+    GLintptr offset = GLintptr((region_ * capacity_ + used_) * sizeof(Instance));
+    // The fences make sure that the GPU doesn't read this range anymore,
+    // so the driver doesn't have to synchronize.
+    void* data = gl(MapBufferRange(GL_ARRAY_BUFFER, offset,
+                                   count * sizeof(Instance),
+                                   GL_MAP_WRITE_BIT |
+                                   GL_MAP_INVALIDATE_RANGE_BIT |
+                                   GL_MAP_UNSYNCHRONIZED_BIT));
+    return static_cast<Instance*>(data);
+  }
+
+  /// Finishes the writing of the records returned by the last map().
+  /** @return The range of the written records. */
+  Range unmap() {
+    Range range{GLuint(region_ * capacity_ + used_), GLsizei(mapped_count_)};
+    if (mapped_count_ != 0) {
+      Bind(buffer_);
+      gl(UnmapBuffer(GL_ARRAY_BUFFER));
+      used_ += mapped_count_;
+      mapped_count_ = 0;
+    }
+    return range;
+  }
+
+  /// Copies count records into the stream.
+  /** @return The range of the records, or an empty one on overflow. */
+  Range push(const Instance* instances, size_t count) {
+    Instance* data = map(count);
+    if (!data) {
+      mapped_count_ = 0;
+      return Range{0, 0};
+    }
+    std::memcpy(data, instances, count * sizeof(Instance));
+    return unmap();
+  }
+
+  /// Copies the records into the stream.
+  Range push(const std::vector<Instance>& instances) {
+    return push(instances.data(), instances.size());
+  }
+
+  /// Draws an instance of the indices for every record in the range.
+  /** The VAO that was set up with setup() and the index buffer has to be
+    * bound. */
+  void drawElements(PrimType type, const IndexBuffer& indices,
+                    const Range& range) const {
+    if (range.count != 0) {
+      DrawElementsInstancedBaseInstance(type, indices, range.count,
+                                        range.base_instance);
+    }
+  }
+
+  /// Draws an instance of the vertices for every record in the range.
+  /** The VAO that was set up with setup() has to be bound. */
+  void drawArrays(PrimType type, GLint first, GLsizei count,
+                  const Range& range) const {
+    if (range.count != 0) {
+      DrawArraysInstancedBaseInstance(type, first, count, range.count,
+                                      range.base_instance);
+    }
+  }
+
+  /// Marks the end of the frame, and moves to the next region.
+  /** Call this after the draws of the frame were issued. It might wait for
+    * the GPU if it is more than frame_count frames behind. */
+  void endFrame() {
+    GLsync& current = fences_[region_];
+    if (current) {
+      gl(DeleteSync(current));
+    }
+    current = gl(FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    region_ = (region_ + 1) % fences_.size();
+    used_ = 0;
+
+    GLsync& next = fences_[region_];
+    if (next) {
+      GLenum result;
+      do {
+        result = gl(ClientWaitSync(next, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   kWaitTimeout));
+      } while (result == GL_TIMEOUT_EXPIRED);
+      gl(DeleteSync(next));
+      next = nullptr;
+    }
+  }
+
+  /// Returns the maximum number of records per frame.
+  size_t capacity() const { return capacity_; }
+
+  /// Returns the number of records written in the current frame.
+  size_t size() const { return used_; }
+
+  /// Returns the buffer, that holds the records.
+  const ArrayBuffer& buffer() const { return buffer_; }
+
+ private:
+  static constexpr GLuint64 kWaitTimeout = 1000000;  // 1 ms, in ns.
+
+  ArrayBuffer buffer_;
+  size_t capacity_;
+  size_t region_;
+  size_t used_;
+  size_t mapped_count_;
+  std::vector<GLsync> fences_;
+};
+
+template <typename Instance>
+constexpr GLuint64 InstanceStream<Instance>::kWaitTimeout;
+#endif  // glMapBufferRange && glFenceSync && glDrawElementsInstancedBaseInstance
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_INSTANCE_STREAM_H_
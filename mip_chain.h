@@ -0,0 +1,622 @@
+// Copyright (c) Tamas Csala
+
+/** @file mip_chain.h
+    @brief Implements generating mipmap chains on the CPU, with SIMD filters,
+           gamma-correct downsampling and alpha coverage preservation.
+*/
+
+#ifndef OGLWRAP_MIP_CHAIN_H_
+#define OGLWRAP_MIP_CHAIN_H_
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "./config.h"
+#include "./simd_ops.h"
+#include "./thread_pool.h"
+#include "textures/texture_2D.h"
+#include "context/binding.h"
+#include "context/pixel_ops.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/// Writes the weighted sum of the rows to out, from *index, while a full
+/// SIMD batch fits before count.
+template <typename Ops>
+inline void SumRowsWith(const float* const* rows, const float* weights,
+                        size_t row_count, size_t* index, size_t count,
+                        float* out) {
+  typedef typename Ops::Float Float;
+  size_t i = *index;
+  for (; i + Ops::kWidth <= count; i += Ops::kWidth) {
+    Float sum = Ops::Mul(Ops::Splat(weights[0]), Ops::Load(rows[0] + i));
+    for (size_t row = 1; row < row_count; ++row) {
+      sum = Ops::Add(sum, Ops::Mul(Ops::Splat(weights[row]),
+                                   Ops::Load(rows[row] + i)));
+    }
+    Ops::Store(out + i, sum);
+  }
+  *index = i;
+}
+
+/// Writes the weighted sum of count floats of the rows to out.
+inline void SumRows(const float* const* rows, const float* weights,
+                    size_t row_count, size_t count, float* out) {
+  size_t index = 0;
+#if OGLWRAP_USE_AVX2 || OGLWRAP_USE_SSE2 || OGLWRAP_USE_NEON
+  SumRowsWith<SimdFloatOps>(rows, weights, row_count, &index, count, out);
+#endif
+  SumRowsWith<ScalarFloatOps>(rows, weights, row_count, &index, count, out);
+}
+
+/**
+ * @brief A mipmap chain of an 8 bit per component image, generated on the
+ *        CPU, with every level in one contiguous allocation.
+ *
+ * The levels are downsampled from each other through linear space (if the
+ * image is sRGB) with a separable filter. The vertical pass of the filters
+ * processes whole rows with SIMD, and the rows of a level can be split between
+ * the threads of a ThreadPool. The levels depend on each other, so they are
+ * generated one after the other.
+ * @code
+ *   gl::MipChain::Options options;
+ *   options.filter = gl::MipChain::Filter::kKaiser;
+ *   options.preserve_alpha_coverage = true;  // for alpha tested foliage
+ *   gl::MipChain mips = gl::MipChain::Generate(pixels, width, height, 4,
+ *                                              options, &pool);
+ *   ...
+ *   gl::Bind(texture);  // on the thread of the context
+ *   mips.upload(texture, gl::PixelDataInternalFormat::kSrgb8Alpha8);
+ * @endcode
+ * The rows of every level are padded to 4 bytes, so the levels can be
+ * uploaded with the default unpack alignment.
+ */
+class MipChain {
+ public:
+  /// The filters, that can be used for the downsampling.
+  enum class Filter {
+    kBox,      ///< Averages the texels, cheap, but a bit blurry.
+    kKaiser,   ///< Kaiser windowed sinc, sharp with little ringing.
+    kLanczos,  ///< Lanczos3, the sharpest, but can ring at hard edges.
+  };
+
+  /// The parameters of the generation.
+  struct Options {
+    Filter filter;
+    /// The color channels are sRGB encoded, and are filtered in linear space.
+    /// The alpha channel (of 2 or 4 channel images) is always linear.
+    bool srgb;
+    /// Scales the alpha of every level, so the same fraction of texels pass
+    /// the alpha test with alpha_cutoff as in the first level.
+    bool preserve_alpha_coverage;
+    float alpha_cutoff;
+    /// The filters wrap around the edges (for tiling textures), instead of
+    /// clamping.
+    bool wrap;
+    /// The maximum number of levels, 0 means every level down to 1x1.
+    GLsizei max_levels;
+
+    Options()
+        : filter(Filter::kBox), srgb(false), preserve_alpha_coverage(false),
+          alpha_cutoff(0.5f), wrap(false), max_levels(0) {}
+  };
+
+  /// The size and location of a level in data().
+  struct Level {
+    GLsizei width;
+    GLsizei height;
+    size_t offset;      ///< The offset of the first row in bytes.
+    size_t row_stride;  ///< The size of a row with padding in bytes.
+  };
+
+  /// Creates an empty chain.
+  MipChain() : channels_(0) {}
+
+  /**
+   * @brief Generates the mipmap chain of an image.
+   *
+   * @param pixels    The tightly packed components of the image.
+   * @param width     The width of the image.
+   * @param height    The height of the image.
+   * @param channels  The number of components per texel (1 - 4).
+   * @param options   The parameters of the generation.
+   * @param pool      The threads to split the rows between, or nullptr to
+   *                  generate on the calling thread.
+   * @return The chain, or an empty chain if the image has no texels.
+   */
+  static MipChain Generate(const unsigned char* pixels, GLsizei width,
+                           GLsizei height, unsigned channels,
+                           const Options& options = Options(),
+                           ThreadPool* pool = nullptr) {
+    MipChain chain;
+    if (width <= 0 || height <= 0) {
+      return chain;
+    }
+    chain.channels_ = channels;
+    chain.layout(width, height, options.max_levels);
+    chain.generate(pixels, options, pool);
+    return chain;
+  }
+
+  /// Returns the levels.
+  const std::vector<Level>& levels() const { return levels_; }
+
+  /// Returns the number of levels.
+  GLsizei levelCount() const { return GLsizei(levels_.size()); }
+
+  /// Returns the number of components per texel.
+  unsigned channels() const { return channels_; }
+
+  /// Returns the staging memory, that holds every level.
+  const std::vector<unsigned char>& data() const { return data_; }
+
+  /// Returns the first row of a level.
+  const unsigned char* data(GLsizei level) const {
+    return data_.data() + levels_[level].offset;
+  }
+
+  /// Returns the pixel data format matching the number of components.
+  PixelDataFormat format() const {
+    switch (channels_) {
+      case 1: return PixelDataFormat::kRed;
+      case 2: return PixelDataFormat::kRg;
+      case 3: return PixelDataFormat::kRgb;
+      default: return PixelDataFormat::kRgba;
+    }
+  }
+
+  /// Uploads every level to the texture, that has to be bound.
+  /** Uses immutable storage if glTexStorage2D is available.
+    * @see Texture2DBase::storage, Texture2DBase::uploadMipmap */
+  template <Texture2DType texture_t>
+  void upload(Texture2DBase<texture_t>& texture,
+              PixelDataInternalFormat internal_format) const {
+    if (levels_.empty()) {
+      return;
+    }
+    TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                         4);
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glTexStorage2D)
+    texture.storage(levelCount(), GLenum(internal_format), levels_[0].width,
+                    levels_[0].height);
+    for (GLsizei i = 0; i < levelCount(); ++i) {
+      texture.subUploadMipmap(i, 0, 0, levels_[i].width, levels_[i].height,
+                              format(), PixelDataType::kUnsignedByte, data(i));
+    }
+#else
+    for (GLsizei i = 0; i < levelCount(); ++i) {
+      texture.uploadMipmap(i, internal_format, levels_[i].width,
+                           levels_[i].height, format(),
+                           PixelDataType::kUnsignedByte, data(i));
+    }
+#endif
+  }
+
+ private:
+  std::vector<unsigned char> data_;
+  std::vector<Level> levels_;
+  unsigned channels_;
+
+  // The source texels and weights of the output texels along an axis.
+  struct Contributions {
+    size_t taps;  // per output texel, padded with zero weights
+    std::vector<GLsizei> index;
+    std::vector<float> weight;
+  };
+
+  // A level while it is generated, with linear float components.
+  struct FloatLevel {
+    GLsizei width;
+    GLsizei height;
+    std::vector<float> texels;
+  };
+
+  void layout(GLsizei width, GLsizei height, GLsizei max_levels) {
+    size_t offset = 0;
+    while (true) {
+      size_t row_stride = (size_t(width) * channels_ + 3) & ~size_t(3);
+      levels_.push_back(Level{width, height, offset, row_stride});
+      offset += row_stride * height;
+      if ((width == 1 && height == 1) ||
+          (max_levels != 0 && GLsizei(levels_.size()) == max_levels)) {
+        break;
+      }
+      width = std::max(width / 2, 1);
+      height = std::max(height / 2, 1);
+    }
+    data_.resize(offset);
+  }
+
+  static const float* SrgbToLinearTable() {
+    static const std::vector<float> table = [] {
+      std::vector<float> result(256);
+      for (int i = 0; i < 256; ++i) {
+        result[i] = SrgbToLinear(i / 255.0f);
+      }
+      return result;
+    }();
+    return table.data();
+  }
+
+  // The linear values halfway between the consecutive sRGB codes, so the
+  // encoding rounds to the nearest code in sRGB space.
+  static const float* LinearToSrgbThresholds() {
+    static const std::vector<float> table = [] {
+      std::vector<float> result(256);
+      for (int i = 0; i < 255; ++i) {
+        result[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+      }
+      result[255] = 2.0f;  // never reached
+      return result;
+    }();
+    return table.data();
+  }
+
+  static float SrgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f
+                             : std::pow((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  // The sRGB codes of the linear values quantized to 16 bits. The code of a
+  // value is either the code of its quantized value, or the next one.
+  static const unsigned char* LinearToSrgbTable() {
+    static const std::vector<unsigned char> table = [] {
+      const float* thresholds = LinearToSrgbThresholds();
+      std::vector<unsigned char> result(65536);
+      unsigned code = 0;
+      for (size_t i = 0; i < result.size(); ++i) {
+        while (code < 255 && thresholds[code] <= i / 65535.0f) {
+          code++;
+        }
+        result[i] = (unsigned char)code;
+      }
+      return result;
+    }();
+    return table.data();
+  }
+
+  static unsigned char EncodeSrgb(float value, const unsigned char* table,
+                                  const float* thresholds) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    unsigned code = table[size_t(value * 65535.0f)];
+    return (unsigned char)(code + (code < 255 && thresholds[code] <= value));
+  }
+
+  static unsigned char EncodeLinear(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return (unsigned char)(value * 255.0f + 0.5f);
+  }
+
+  static float Sinc(float x) {
+    if (std::abs(x) < 1e-6f) {
+      return 1.0f;
+    }
+    x *= 3.14159265358979f;
+    return std::sin(x) / x;
+  }
+
+  // The modified Bessel function of the first kind of order zero.
+  static float BesselI0(float x) {
+    float sum = 1.0f, term = 1.0f, half_x = x / 2;
+    for (int k = 1; k < 20; ++k) {
+      term *= (half_x / k) * (half_x / k);
+      sum += term;
+    }
+    return sum;
+  }
+
+  static float Support(Filter filter) {
+    return filter == Filter::kBox ? 0.5f : 3.0f;
+  }
+
+  static float Kernel(Filter filter, float t) {
+    t = std::abs(t);
+    switch (filter) {
+      case Filter::kBox:
+        return t < 0.5f ? 1.0f : (t == 0.5f ? 0.5f : 0.0f);
+      case Filter::kKaiser: {
+        if (t >= 3.0f) {
+          return 0.0f;
+        }
+        const float alpha = 4.0f;
+        float ratio = t / 3.0f;
+        return Sinc(t) * BesselI0(alpha * std::sqrt(1.0f - ratio * ratio))
+               / BesselI0(alpha);
+      }
+      case Filter::kLanczos:
+        return t < 3.0f ? Sinc(t) * Sinc(t / 3.0f) : 0.0f;
+    }
+    return 0.0f;
+  }
+
+  // Computes the source texels, that contribute to the output texels, when
+  // resampling source_size texels to output_size.
+  static Contributions Contribute(GLsizei source_size, GLsizei output_size,
+                                  Filter filter, bool wrap) {
+    float scale = float(source_size) / output_size;
+    float radius = Support(filter) * scale;
+    Contributions result;
+    result.taps = size_t(std::floor(2 * radius)) + 2;
+    result.index.resize(result.taps * output_size);
+    result.weight.resize(result.taps * output_size);
+    for (GLsizei x = 0; x < output_size; ++x) {
+      float center = (x + 0.5f) * scale;
+      GLsizei first = GLsizei(std::floor(center - radius - 0.5f));
+      float sum = 0.0f;
+      for (size_t tap = 0; tap < result.taps; ++tap) {
+        GLsizei source = first + GLsizei(tap);
+        float weight = Kernel(filter, (source + 0.5f - center) / scale);
+        if (wrap) {
+          source = ((source % source_size) + source_size) % source_size;
+        } else {
+          source = std::min(std::max(source, 0), source_size - 1);
+        }
+        result.index[x * result.taps + tap] = source;
+        result.weight[x * result.taps + tap] = weight;
+        sum += weight;
+      }
+      for (size_t tap = 0; tap < result.taps; ++tap) {
+        result.weight[x * result.taps + tap] /= sum;
+      }
+    }
+    return Compact(result, output_size);
+  }
+
+  // Removes the taps, that have zero weight for every output texel (at the
+  // edges of the support), so the filters don't multiply by zero.
+  static Contributions Compact(const Contributions& padded,
+                               GLsizei output_size) {
+    size_t first = padded.taps, last = 0;
+    for (GLsizei x = 0; x < output_size; ++x) {
+      for (size_t tap = 0; tap < padded.taps; ++tap) {
+        if (padded.weight[x * padded.taps + tap] != 0.0f) {
+          first = std::min(first, tap);
+          last = std::max(last, tap);
+        }
+      }
+    }
+    Contributions result;
+    result.taps = last - first + 1;
+    for (GLsizei x = 0; x < output_size; ++x) {
+      for (size_t tap = first; tap <= last; ++tap) {
+        result.index.push_back(padded.index[x * padded.taps + tap]);
+        result.weight.push_back(padded.weight[x * padded.taps + tap]);
+      }
+    }
+    return result;
+  }
+
+  // Calls task(begin, end) for bands of [0, rows), on the pool if there is
+  // one, and the rows are worth splitting.
+  template <typename Task>
+  static void ForRows(GLsizei rows, size_t floats_per_row, ThreadPool* pool,
+                      const Task& task) {
+    const size_t kMinFloatsPerBand = 16384;
+    size_t band_count = 1;
+    if (pool && pool->size() > 1) {
+      band_count = std::min(
+          std::min(size_t(rows), pool->size() * 4),
+          std::max<size_t>(1, rows * floats_per_row / kMinFloatsPerBand));
+    }
+    if (band_count == 1) {
+      task(GLsizei(0), rows);
+      return;
+    }
+    pool->run(band_count, [&](size_t band) {
+      task(GLsizei(band * rows / band_count),
+           GLsizei((band + 1) * rows / band_count));
+    });
+  }
+
+  bool isColor(unsigned channel) const {
+    return !((channels_ == 2 && channel == 1) ||
+             (channels_ == 4 && channel == 3));
+  }
+
+  bool hasAlpha() const { return channels_ == 2 || channels_ == 4; }
+
+  template <unsigned kChannels>
+  static void FilterHorizontally(const float* row, const Contributions& h,
+                                 GLsizei width, float* out) {
+    for (GLsizei x = 0; x < width; ++x) {
+      const GLsizei* index = &h.index[x * h.taps];
+      const float* weight = &h.weight[x * h.taps];
+      float sum[kChannels] = {};
+      for (size_t tap = 0; tap < h.taps; ++tap) {
+        const float* texel = row + size_t(index[tap]) * kChannels;
+        for (unsigned c = 0; c < kChannels; ++c) {
+          sum[c] += weight[tap] * texel[c];
+        }
+      }
+      for (unsigned c = 0; c < kChannels; ++c) {
+        out[size_t(x) * kChannels + c] = sum[c];
+      }
+    }
+  }
+
+  void filterHorizontally(const float* row, const Contributions& h,
+                          GLsizei width, float* out) const {
+    switch (channels_) {
+      case 1: FilterHorizontally<1>(row, h, width, out); break;
+      case 2: FilterHorizontally<2>(row, h, width, out); break;
+      case 3: FilterHorizontally<3>(row, h, width, out); break;
+      default: FilterHorizontally<4>(row, h, width, out); break;
+    }
+  }
+
+  // Converts a row of the image to linear floats.
+  void convertRow(const unsigned char* in, const Options& options,
+                  float* out) const {
+    const float* to_linear = SrgbToLinearTable();
+    size_t row = size_t(levels_[0].width) * channels_;
+    for (unsigned c = 0; c < channels_; ++c) {
+      if (options.srgb && isColor(c)) {
+        for (size_t i = c; i < row; i += channels_) {
+          out[i] = to_linear[in[i]];
+        }
+      } else {
+        for (size_t i = c; i < row; i += channels_) {
+          out[i] = in[i] / 255.0f;
+        }
+      }
+    }
+  }
+
+  // Downsamples the previous level, or the image itself (if pixels isn't
+  // nullptr) to the level. The rows of the image are converted on demand, so
+  // it never has to be converted to floats as a whole.
+  FloatLevel downsample(const FloatLevel& source, const unsigned char* pixels,
+                        const Level& level, const Options& options,
+                        ThreadPool* pool) const {
+    FloatLevel result{level.width, level.height,
+                      std::vector<float>(size_t(level.width) * level.height *
+                                         channels_)};
+    Contributions v = Contribute(source.height, level.height,
+                                 options.filter, options.wrap);
+    Contributions h = Contribute(source.width, level.width,
+                                 options.filter, options.wrap);
+    size_t source_row = size_t(source.width) * channels_;
+    size_t output_row = size_t(level.width) * channels_;
+    ForRows(level.height, source_row * v.taps, pool,
+            [&](GLsizei begin, GLsizei end) {
+      std::vector<float> column_filtered(source_row);
+      std::vector<const float*> rows(v.taps);
+      // The converted image rows. An output row needs at most taps distinct
+      // rows, so a slot not used by the current output row is always free.
+      std::vector<float> converted(pixels ? source_row * v.taps : 0);
+      std::vector<GLsizei> converted_row(v.taps, -1);
+      std::vector<GLsizei> used_by(v.taps, -1);
+      for (GLsizei y = begin; y < end; ++y) {
+        for (size_t tap = 0; tap < v.taps; ++tap) {
+          GLsizei index = v.index[y * v.taps + tap];
+          if (!pixels) {
+            rows[tap] = source.texels.data() + size_t(index) * source_row;
+            continue;
+          }
+          size_t slot = std::find(converted_row.begin(), converted_row.end(),
+                                  index) - converted_row.begin();
+          if (slot == v.taps) {
+            slot = std::find_if(used_by.begin(), used_by.end(),
+                                [y](GLsizei user) { return user != y; })
+                   - used_by.begin();
+            convertRow(pixels + size_t(index) * source_row, options,
+                       &converted[slot * source_row]);
+            converted_row[slot] = index;
+          }
+          used_by[slot] = y;
+          rows[tap] = &converted[slot * source_row];
+        }
+        SumRows(rows.data(), &v.weight[y * v.taps], v.taps, source_row,
+                column_filtered.data());
+        filterHorizontally(column_filtered.data(), h, level.width,
+                           result.texels.data() + y * output_row);
+      }
+    });
+    return result;
+  }
+
+  // Returns the alpha scale, that makes the coverage of the level closest
+  // to the target coverage.
+  float alphaScale(const FloatLevel& level, float cutoff,
+                   float target) const {
+    // Finds the alpha value, that target of the texels are above, by a
+    // histogram of the alpha values.
+    const size_t kBins = 1024;
+    std::vector<size_t> histogram(kBins + 1);
+    size_t count = size_t(level.width) * level.height;
+    for (size_t i = 0; i < count; ++i) {
+      float alpha = level.texels[i * channels_ + channels_ - 1];
+      alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+      histogram[size_t(alpha * kBins)]++;
+    }
+    size_t wanted = size_t(target * count + 0.5f), above = 0;
+    size_t bin = kBins + 1;
+    while (bin > 1 && above + histogram[bin - 1] <= wanted) {
+      above += histogram[--bin];
+    }
+    // The texels of the next bin would overshoot the target, but might still
+    // be closer to it.
+    if (bin > 1 && (above + histogram[bin - 1]) - wanted < wanted - above) {
+      above += histogram[--bin];
+    }
+    if (bin > kBins) {
+      return 1.0f;  // even the most opaque texels would be too many
+    }
+    float threshold = float(bin) / kBins;
+    return threshold > 0.0f ? cutoff / threshold : 1.0f;
+  }
+
+  void quantize(const FloatLevel& source, const Level& level,
+                const Options& options, float alpha_scale,
+                ThreadPool* pool) {
+    const unsigned char* table = LinearToSrgbTable();
+    const float* thresholds = LinearToSrgbThresholds();
+    size_t source_row = size_t(level.width) * channels_;
+    ForRows(level.height, source_row, pool, [&](GLsizei begin, GLsizei end) {
+      for (GLsizei y = begin; y < end; ++y) {
+        const float* in = source.texels.data() + y * source_row;
+        unsigned char* out = data_.data() + level.offset + y * level.row_stride;
+        for (unsigned c = 0; c < channels_; ++c) {
+          if (!isColor(c)) {
+            for (size_t i = c; i < source_row; i += channels_) {
+              out[i] = EncodeLinear(in[i] * alpha_scale);
+            }
+          } else if (options.srgb) {
+            for (size_t i = c; i < source_row; i += channels_) {
+              out[i] = EncodeSrgb(in[i], table, thresholds);
+            }
+          } else {
+            for (size_t i = c; i < source_row; i += channels_) {
+              out[i] = EncodeLinear(in[i]);
+            }
+          }
+        }
+      }
+    });
+  }
+
+  void generate(const unsigned char* pixels, const Options& options,
+                ThreadPool* pool) {
+    const Level& first = levels_[0];
+    size_t row = size_t(first.width) * channels_;
+
+    // The first level is the image itself, only the rows are padded.
+    ForRows(first.height, row, pool, [&](GLsizei begin, GLsizei end) {
+      for (GLsizei y = begin; y < end; ++y) {
+        std::memcpy(data_.data() + first.offset + y * first.row_stride,
+                    pixels + y * row, row);
+      }
+    });
+
+    bool preserve_coverage = options.preserve_alpha_coverage && hasAlpha();
+    float target_coverage = 0.0f;
+    if (preserve_coverage) {
+      size_t passed = 0, count = size_t(first.width) * first.height;
+      for (size_t i = 0; i < count; ++i) {
+        passed += pixels[i * channels_ + channels_ - 1] / 255.0f
+                  >= options.alpha_cutoff;
+      }
+      target_coverage = float(passed) / count;
+    }
+
+    FloatLevel current{first.width, first.height, std::vector<float>()};
+    for (size_t i = 1; i < levels_.size(); ++i) {
+      current = downsample(current, i == 1 ? pixels : nullptr, levels_[i],
+                           options, pool);
+      float alpha_scale = preserve_coverage
+          ? alphaScale(current, options.alpha_cutoff, target_coverage) : 1.0f;
+      quantize(current, levels_[i], options, alpha_scale, pool);
+    }
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_MIP_CHAIN_H_
@@ -26,6 +26,7 @@
 #include "./smart_enums.h"
 #include "./vertex_array.h"
 #include "./vertex_attrib.h"
+#include "./vertex_format.h"
 #include "textures/texture_2D.h"
 #include "textures/texture_cube.h"
 
@@ -33,8 +34,28 @@
 // Optional headers
 #if OGLWRAP_INCLUDE_EVERYTHING
   #include "./texture.h"
+  #include "./texture_units.h"
+  #include "./sampler_cache.h"
+  #include "./texture_upload_queue.h"
+  #include "./texture_loader.h"
+  #include "./mip_chain.h"
+  #include "./texture_container.h"
+  #include "./block_compressor.h"
+  #include "./texture_atlas.h"
   #include "./framebuffer.h"
   #include "./transform_feedback.h"
+  #include "./vertex_array_cache.h"
+  #include "./vertex_compression.h"
+  #include "./mesh_optimizer.h"
+  #include "./command_buffer.h"
+  #include "./command_list.h"
+  #include "./pipeline_state.h"
+  #include "./indirect_batcher.h"
+  #include "./instance_stream.h"
+  #include "./frustum.h"
+  #include "./gpu_culling.h"
+  #include "./thread_pool.h"
+  #include "./cpu_culling.h"
   #include "shapes/cube_shape.h"
   #include "shapes/sphere_shape.h"
   #include "shapes/rectangle_shape.h"
@@ -0,0 +1,423 @@
+// Copyright (c) Tamas Csala
+
+/** @file pipeline_state.h
+    @brief Implements immutable objects, that describe the rasterization,
+           blending, depth, stencil and color mask state of a draw.
+*/
+
+#ifndef OGLWRAP_PIPELINE_STATE_H_
+#define OGLWRAP_PIPELINE_STATE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "./config.h"
+#include "./word_key.h"
+#include "./enums/blend_equation.h"
+#include "./enums/blend_function.h"
+#include "./enums/capability.h"
+#include "./enums/compare_func.h"
+#include "./enums/face.h"
+#include "./enums/face_orientation.h"
+#include "./enums/poly_mode.h"
+#include "./enums/stencil_operation.h"
+#include "context/blending.h"
+#include "context/buffer_masking.h"
+#include "context/capabilities.h"
+#include "context/depth_test.h"
+#include "context/rasterization.h"
+#include "context/state_cache.h"
+#include "context/stencil_test.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glBlendEquationSeparate) && defined(glBlendFuncSeparate) \
+        && defined(glStencilFuncSeparate) && defined(glStencilOpSeparate) \
+        && defined(glStencilMaskSeparate))
+/**
+ * @brief The fixed function state of a draw (culling, polygon mode and
+ *        offset, blending, depth and stencil test, and the write masks), as
+ *        one immutable value.
+ *
+ * The states are meant to be built once at load time, and applied before the
+ * draws. Every built state gets a unique id, and the current StateCache
+ * remembers the id of the last applied one, so applying the same state again
+ * is a single integer compare. Switching to another state only makes the GL
+ * calls of the values that differ, as every value goes through the cache.
+ * Any other change of these values (through oglwrap) invalidates the fast
+ * path. Without a current StateCache, apply() makes every call.
+ * @code
+ *   gl::PipelineState transparent = gl::PipelineState::Builder()
+ *       .blend(true)
+ *       .blendFunc(gl::BlendFunction::kSrcAlpha,
+ *                  gl::BlendFunction::kOneMinusSrcAlpha)
+ *       .depthMask(false)
+ *       .build();
+ *   ...
+ *   transparent.apply();
+ *   gl::DrawArrays(...);
+ * @endcode
+ */
+class PipelineState {
+ public:
+  /// The state of one face for the stencil test.
+  struct StencilFace {
+    GLenum func;
+    GLint ref;
+    GLuint value_mask;
+    GLenum sfail, dpfail, dppass;
+    GLuint write_mask;
+  };
+
+  /// The values of the state. The members are 32 bits wide, so they can be
+  /// hashed and compared with HashWords and EqualWords.
+  struct Values {
+    // Rasterization
+    GLuint cull_face_enabled;
+    GLenum cull_face;
+    GLenum front_face;
+    GLenum polygon_mode;
+    GLuint polygon_offset_enabled;
+    GLfloat polygon_offset_factor;
+    GLfloat polygon_offset_units;
+
+    // Blending
+    GLuint blend_enabled;
+    GLenum blend_equation_rgb, blend_equation_alpha;
+    GLenum blend_src_rgb, blend_dst_rgb, blend_src_alpha, blend_dst_alpha;
+    GLfloat blend_color[4];
+
+    // Depth test
+    GLuint depth_test_enabled;
+    GLenum depth_func;
+    GLuint depth_mask;
+
+    // Stencil test
+    GLuint stencil_test_enabled;
+    StencilFace stencil_front, stencil_back;
+
+    // Color mask
+    GLuint color_mask[4];
+  };
+  static_assert(sizeof(Values) % sizeof(GLuint) == 0,
+                "PipelineState::Values must not have padding");
+
+  /// Builds a PipelineState. Everything not set has the initial value of the
+  /// OpenGL context.
+  class Builder {
+   public:
+    Builder() : values_(DefaultValues()) {}
+
+    /// @see Enable(Capability::kCullFace), CullFace
+    Builder& cullFace(bool enabled, Face face = Face::kBack) {
+      values_.cull_face_enabled = enabled;
+      values_.cull_face = GLenum(face);
+      return *this;
+    }
+
+    /// @see FrontFace
+    Builder& frontFace(FaceOrientation orientation) {
+      values_.front_face = GLenum(orientation);
+      return *this;
+    }
+
+    /// @see PolygonMode
+    Builder& polygonMode(PolyMode mode) {
+      values_.polygon_mode = GLenum(mode);
+      return *this;
+    }
+
+    /// @see Enable(Capability::kPolygonOffsetFill), PolygonOffset
+    Builder& polygonOffset(bool enabled, GLfloat factor = 0.0f,
+                           GLfloat units = 0.0f) {
+      values_.polygon_offset_enabled = enabled;
+      values_.polygon_offset_factor = factor;
+      values_.polygon_offset_units = units;
+      return *this;
+    }
+
+    /// @see Enable(Capability::kBlend)
+    Builder& blend(bool enabled) {
+      values_.blend_enabled = enabled;
+      return *this;
+    }
+
+    /// @see BlendEquation
+    Builder& blendEquation(enums::BlendEquation eq) {
+      return blendEquation(eq, eq);
+    }
+
+    /// @see BlendEquationSeparate
+    Builder& blendEquation(enums::BlendEquation rgb,
+                           enums::BlendEquation alpha) {
+      values_.blend_equation_rgb = GLenum(rgb);
+      values_.blend_equation_alpha = GLenum(alpha);
+      return *this;
+    }
+
+    /// @see BlendFunc
+    Builder& blendFunc(enums::BlendFunction src, enums::BlendFunction dst) {
+      return blendFunc(src, dst, src, dst);
+    }
+
+    /// @see BlendFuncSeparate
+    Builder& blendFunc(enums::BlendFunction src_rgb,
+                       enums::BlendFunction dst_rgb,
+                       enums::BlendFunction src_alpha,
+                       enums::BlendFunction dst_alpha) {
+      values_.blend_src_rgb = GLenum(src_rgb);
+      values_.blend_dst_rgb = GLenum(dst_rgb);
+      values_.blend_src_alpha = GLenum(src_alpha);
+      values_.blend_dst_alpha = GLenum(dst_alpha);
+      return *this;
+    }
+
+    /// @see BlendColor
+    Builder& blendColor(glm::vec4 color) {
+      for (int i = 0; i < 4; ++i) {
+        values_.blend_color[i] = color[i];
+      }
+      return *this;
+    }
+
+    /// @see Enable(Capability::kDepthTest), DepthFunc
+    Builder& depthTest(bool enabled, CompareFunc func = CompareFunc::kLess) {
+      values_.depth_test_enabled = enabled;
+      values_.depth_func = GLenum(func);
+      return *this;
+    }
+
+    /// @see DepthMask
+    Builder& depthMask(bool mask) {
+      values_.depth_mask = mask;
+      return *this;
+    }
+
+    /// @see Enable(Capability::kStencilTest)
+    Builder& stencilTest(bool enabled) {
+      values_.stencil_test_enabled = enabled;
+      return *this;
+    }
+
+    /// @see StencilFunc
+    Builder& stencilFunc(CompareFunc func, GLint ref = 0,
+                         GLuint mask = ~GLuint(0)) {
+      return stencilFunc(Face::kFrontAndBack, func, ref, mask);
+    }
+
+    /// @see StencilFuncSeparate
+    Builder& stencilFunc(Face face, CompareFunc func, GLint ref = 0,
+                         GLuint mask = ~GLuint(0)) {
+      forFaces(face, [=](StencilFace& stencil) {
+        stencil.func = GLenum(func);
+        stencil.ref = ref;
+        stencil.value_mask = mask;
+      });
+      return *this;
+    }
+
+    /// @see StencilOp
+    Builder& stencilOp(StencilOperation sfail, StencilOperation dpfail,
+                       StencilOperation dppass) {
+      return stencilOp(Face::kFrontAndBack, sfail, dpfail, dppass);
+    }
+
+    /// @see StencilOpSeparate
+    Builder& stencilOp(Face face, StencilOperation sfail,
+                       StencilOperation dpfail, StencilOperation dppass) {
+      forFaces(face, [=](StencilFace& stencil) {
+        stencil.sfail = GLenum(sfail);
+        stencil.dpfail = GLenum(dpfail);
+        stencil.dppass = GLenum(dppass);
+      });
+      return *this;
+    }
+
+    /// @see StencilMask
+    Builder& stencilMask(GLuint mask) {
+      return stencilMask(Face::kFrontAndBack, mask);
+    }
+
+    /// @see StencilMask(Face, GLuint)
+    Builder& stencilMask(Face face, GLuint mask) {
+      forFaces(face, [=](StencilFace& stencil) { stencil.write_mask = mask; });
+      return *this;
+    }
+
+    /// @see ColorMask
+    Builder& colorMask(bool r, bool g, bool b, bool a) {
+      values_.color_mask[0] = r;
+      values_.color_mask[1] = g;
+      values_.color_mask[2] = b;
+      values_.color_mask[3] = a;
+      return *this;
+    }
+
+    /// Creates the state. Every call creates a state with a new id.
+    PipelineState build() const { return PipelineState(values_); }
+
+   private:
+    Values values_;
+
+    template <typename Function>
+    void forFaces(Face face, Function function) {
+      if (face != Face::kBack) {
+        function(values_.stencil_front);
+      }
+      if (face != Face::kFront) {
+        function(values_.stencil_back);
+      }
+    }
+  };
+
+  /// Returns the values of the state.
+  const Values& values() const { return values_; }
+
+  /// Returns the id of the state, that is unique for every built state (but
+  /// is shared by the copies).
+  uint64_t id() const { return id_; }
+
+  /// Returns the hash of the values.
+  size_t hash() const { return hash_; }
+
+  /// Returns if the two states have the same values.
+  bool operator==(const PipelineState& other) const {
+    if (id_ == other.id_) {
+      return true;
+    }
+    if (hash_ != other.hash_) {
+      return false;
+    }
+    return EqualWords(values_, other.values_);
+  }
+
+  bool operator!=(const PipelineState& other) const {
+    return !(*this == other);
+  }
+
+  /// Makes the state current.
+  /** If this state is the last one applied, and nothing changed since then,
+    * no GL call is made. Otherwise only the values, that differ from the
+    * current StateCache are set. */
+  void apply() const {
+    StateCache* cache = StateCache::Current();
+    if (cache && cache->pipelineState() == id_) {
+      cache->countSkippedCall();
+      return;
+    }
+
+    const Values& v = values_;
+    SetCapability(Capability::kCullFace, v.cull_face_enabled != 0);
+    CullFace(Face(v.cull_face));
+    FrontFace(FaceOrientation(v.front_face));
+    PolygonMode(PolyMode(v.polygon_mode));
+    SetCapability(Capability::kPolygonOffsetFill,
+                  v.polygon_offset_enabled != 0);
+    PolygonOffset(v.polygon_offset_factor, v.polygon_offset_units);
+
+    SetCapability(Capability::kBlend, v.blend_enabled != 0);
+    BlendEquationSeparate(enums::BlendEquation(v.blend_equation_rgb),
+                          enums::BlendEquation(v.blend_equation_alpha));
+    BlendFuncSeparate(enums::BlendFunction(v.blend_src_rgb),
+                      enums::BlendFunction(v.blend_dst_rgb),
+                      enums::BlendFunction(v.blend_src_alpha),
+                      enums::BlendFunction(v.blend_dst_alpha));
+    BlendColor(glm::vec4(v.blend_color[0], v.blend_color[1],
+                         v.blend_color[2], v.blend_color[3]));
+
+    SetCapability(Capability::kDepthTest, v.depth_test_enabled != 0);
+    DepthFunc(CompareFunc(v.depth_func));
+    DepthMask(v.depth_mask != 0);
+
+    SetCapability(Capability::kStencilTest, v.stencil_test_enabled != 0);
+    ApplyStencil(v.stencil_front, v.stencil_back);
+
+    ColorMask(v.color_mask[0] != 0, v.color_mask[1] != 0,
+              v.color_mask[2] != 0, v.color_mask[3] != 0);
+
+    // The setters above reset the applied state, so this must be the last.
+    if (cache) {
+      cache->pipelineStateApplied(id_);
+    }
+  }
+
+ private:
+  Values values_;
+  uint64_t id_;
+  size_t hash_;
+
+  explicit PipelineState(const Values& values)
+      : values_(values), id_(NextId()), hash_(HashWords(values)) {}
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id(1);
+    return next_id++;
+  }
+
+  static Values DefaultValues() {
+    StencilFace stencil = {GL_ALWAYS, 0, ~GLuint(0),
+                           GL_KEEP, GL_KEEP, GL_KEEP, ~GLuint(0)};
+    Values values = {
+      false, GL_BACK, GL_CCW, GL_FILL, false, 0.0f, 0.0f,
+      false, GL_FUNC_ADD, GL_FUNC_ADD, GL_ONE, GL_ZERO, GL_ONE, GL_ZERO,
+      {0.0f, 0.0f, 0.0f, 0.0f},
+      false, GL_LESS, true,
+      false, stencil, stencil,
+      {true, true, true, true}
+    };
+    return values;
+  }
+
+  static bool SameStencilFunc(const StencilFace& a, const StencilFace& b) {
+    return a.func == b.func && a.ref == b.ref && a.value_mask == b.value_mask;
+  }
+
+  static bool SameStencilOp(const StencilFace& a, const StencilFace& b) {
+    return a.sfail == b.sfail && a.dpfail == b.dpfail && a.dppass == b.dppass;
+  }
+
+  static void ApplyStencilFace(Face face, const StencilFace& stencil) {
+    StencilFuncSeparate(face, CompareFunc(stencil.func), stencil.ref,
+                        stencil.value_mask);
+    StencilOpSeparate(face, StencilOperation(stencil.sfail),
+                      StencilOperation(stencil.dpfail),
+                      StencilOperation(stencil.dppass));
+    StencilMask(face, stencil.write_mask);
+  }
+
+  static void ApplyStencil(const StencilFace& front, const StencilFace& back) {
+    if (SameStencilFunc(front, back) && SameStencilOp(front, back)
+        && front.write_mask == back.write_mask) {
+      ApplyStencilFace(Face::kFrontAndBack, front);
+    } else {
+      ApplyStencilFace(Face::kFront, front);
+      ApplyStencilFace(Face::kBack, back);
+    }
+  }
+};
+#endif  // glBlendFuncSeparate && glStencilFuncSeparate
+
+}  // namespace oglwrap
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glBlendEquationSeparate) && defined(glBlendFuncSeparate) \
+        && defined(glStencilFuncSeparate) && defined(glStencilOpSeparate) \
+        && defined(glStencilMaskSeparate))
+namespace std {
+template <>
+struct hash<OGLWRAP_NAMESPACE_NAME::PipelineState> {
+  size_t operator()(const OGLWRAP_NAMESPACE_NAME::PipelineState& state) const {
+    return state.hash();
+  }
+};
+}  // namespace std
+#endif
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_PIPELINE_STATE_H_
@@ -0,0 +1,335 @@
+// Copyright (c) Tamas Csala
+
+/** @file sampler.h
+    @brief Implements a wrapper for sampler objects, and a descriptor of their
+           parameters.
+*/
+
+#ifndef OGLWRAP_SAMPLER_H_
+#define OGLWRAP_SAMPLER_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "./config.h"
+#include "./globjects.h"
+#include "./word_key.h"
+#include "enums/wrap_mode.h"
+#include "enums/min_filter.h"
+#include "enums/mag_filter.h"
+#include "enums/compare_mode.h"
+#include "enums/compare_func.h"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING || \
+    (defined(glGenSamplers) && defined(glDeleteSamplers) && \
+     defined(glSamplerParameteri))
+/**
+ * @brief The sampling parameters of a texture, that can be set with a single
+ *        call on a Sampler, and used as the key of a SamplerCache.
+ *
+ * The default values are the defaults of OpenGL. The fields are 32 bits, so
+ * the descriptor is hashed and compared with HashWords and EqualWords.
+ * @code
+ *   gl::SamplerDescriptor trilinear = gl::SamplerDescriptor()
+ *       .minFilter(gl::kLinearMipmapLinear)
+ *       .magFilter(gl::kLinear)
+ *       .wrap(gl::kClampToEdge)
+ *       .anisotropy(8.0f);
+ * @endcode
+ */
+struct SamplerDescriptor {
+  GLenum min_filter;
+  GLenum mag_filter;
+  GLenum wrap_s;
+  GLenum wrap_t;
+  GLenum wrap_r;
+  GLenum compare_mode;
+  GLenum compare_func;
+  GLfloat max_anisotropy;
+  GLfloat min_lod;
+  GLfloat max_lod;
+  GLfloat lod_bias;
+  GLfloat border_color[4];
+
+  SamplerDescriptor()
+      : min_filter(GL_NEAREST_MIPMAP_LINEAR), mag_filter(GL_LINEAR)
+      , wrap_s(GL_REPEAT), wrap_t(GL_REPEAT), wrap_r(GL_REPEAT)
+      , compare_mode(GL_NONE), compare_func(GL_LEQUAL), max_anisotropy(1.0f)
+      , min_lod(-1000.0f), max_lod(1000.0f), lod_bias(0.0f)
+      , border_color{0.0f, 0.0f, 0.0f, 0.0f} {}
+
+  /// Sets the minification filter.
+  SamplerDescriptor& minFilter(enums::MinFilter filtermode) {
+    min_filter = GLenum(filtermode);
+    return *this;
+  }
+
+  /// Sets the magnification filter.
+  SamplerDescriptor& magFilter(enums::MagFilter filtermode) {
+    mag_filter = GLenum(filtermode);
+    return *this;
+  }
+
+  /// Sets the wrapping mode of the 's' (first) texture coordinate.
+  SamplerDescriptor& wrapS(WrapMode wrap_mode) {
+    wrap_s = GLenum(wrap_mode);
+    return *this;
+  }
+
+  /// Sets the wrapping mode of the 't' (second) texture coordinate.
+  SamplerDescriptor& wrapT(WrapMode wrap_mode) {
+    wrap_t = GLenum(wrap_mode);
+    return *this;
+  }
+
+  /// Sets the wrapping mode of the 'p' (third) texture coordinate.
+  SamplerDescriptor& wrapP(WrapMode wrap_mode) {
+    wrap_r = GLenum(wrap_mode);
+    return *this;
+  }
+
+  /// Sets the wrapping mode of every texture coordinate.
+  SamplerDescriptor& wrap(WrapMode wrap_mode) {
+    return wrapS(wrap_mode).wrapT(wrap_mode).wrapP(wrap_mode);
+  }
+
+  /// Sets the compare mode.
+  SamplerDescriptor& compareMode(enums::CompareMode mode) {
+    compare_mode = GLenum(mode);
+    return *this;
+  }
+
+  /// Sets the compare function.
+  SamplerDescriptor& compareFunc(enums::CompareFunc func) {
+    compare_func = GLenum(func);
+    return *this;
+  }
+
+  /// Sets the maximum anisotropy (1.0 disables anisotropic filtering).
+  SamplerDescriptor& anisotropy(GLfloat value) {
+    max_anisotropy = value;
+    return *this;
+  }
+
+  /// Sets the range of the level of detail.
+  SamplerDescriptor& lodRange(GLfloat min, GLfloat max) {
+    min_lod = min;
+    max_lod = max;
+    return *this;
+  }
+
+  /// Sets the bias added to the level of detail.
+  SamplerDescriptor& lodBias(GLfloat bias) {
+    lod_bias = bias;
+    return *this;
+  }
+
+  /// Sets the border color.
+  SamplerDescriptor& borderColor(glm::vec4 color) {
+    for (int i = 0; i < 4; ++i) {
+      border_color[i] = color[i];
+    }
+    return *this;
+  }
+
+  /// Returns the hash of the parameters.
+  size_t hash() const { return HashWords(*this); }
+
+  /// Returns if the two descriptors have the same parameters.
+  bool operator==(const SamplerDescriptor& other) const {
+    return EqualWords(*this, other);
+  }
+
+  bool operator!=(const SamplerDescriptor& other) const {
+    return !(*this == other);
+  }
+};
+static_assert(sizeof(SamplerDescriptor) == 15 * sizeof(GLuint),
+              "SamplerDescriptor must not have padding");
+
+/// An object, that stores the sampling parameters of a texture unit.
+/** The parameters of a sampler bound to a unit override the parameters of the
+  * texture bound to the same unit. Unlike the texture parameters, they can be
+  * set without binding the sampler.
+  * @see glGenSamplers, glDeleteSamplers, glBindSampler
+  * @version OpenGL 3.3 */
+class Sampler {
+ public:
+  /// Creates a sampler with the default parameters.
+  Sampler() = default;
+
+  /// Creates a sampler with the given parameters.
+  explicit Sampler(const SamplerDescriptor& descriptor) {
+    parameters(descriptor);
+  }
+
+  /// Sets the minification filter.
+  /** @see glSamplerParameteri, GL_TEXTURE_MIN_FILTER */
+  void minFilter(enums::MinFilter filtermode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_MIN_FILTER, GLenum(filtermode)));
+  }
+
+  /// Sets the magnification filter.
+  /** @see glSamplerParameteri, GL_TEXTURE_MAG_FILTER */
+  void magFilter(enums::MagFilter filtermode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_MAG_FILTER, GLenum(filtermode)));
+  }
+
+  /// Sets the wrapping mode of the 's' (first) texture coordinate.
+  /** @see glSamplerParameteri, GL_TEXTURE_WRAP_S */
+  void wrapS(WrapMode wrap_mode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_WRAP_S, GLenum(wrap_mode)));
+  }
+
+  /// Sets the wrapping mode of the 't' (second) texture coordinate.
+  /** @see glSamplerParameteri, GL_TEXTURE_WRAP_T */
+  void wrapT(WrapMode wrap_mode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_WRAP_T, GLenum(wrap_mode)));
+  }
+
+  /// Sets the wrapping mode of the 'p' (third) texture coordinate.
+  /** @see glSamplerParameteri, GL_TEXTURE_WRAP_R */
+  void wrapP(WrapMode wrap_mode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_WRAP_R, GLenum(wrap_mode)));
+  }
+
+  /// Sets the compare mode.
+  /** @see glSamplerParameteri, GL_TEXTURE_COMPARE_MODE */
+  void compareMode(enums::CompareMode mode) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_COMPARE_MODE, GLenum(mode)));
+  }
+
+  /// Sets the compare function.
+  /** @see glSamplerParameteri, GL_TEXTURE_COMPARE_FUNC */
+  void compareFunc(enums::CompareFunc func) {
+    gl(SamplerParameteri(sampler_, GL_TEXTURE_COMPARE_FUNC, GLenum(func)));
+  }
+
+  /// Sets the anisotropy extension to a desired value.
+  /** It doesn't do anything if anisotropy is not supported.
+    * @see glSamplerParameterf, GL_TEXTURE_MAX_ANISOTROPY_EXT */
+  void anisotropy(GLfloat value) {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_TEXTURE_MAX_ANISOTROPY_EXT)
+    gl(SamplerParameterf(sampler_, GL_TEXTURE_MAX_ANISOTROPY_EXT, value));
+#endif
+  }
+
+  /// Sets the anisotropy extension to the maximum value possible on this hardware.
+  /** It doesn't do anything if anisotropy is not supported.
+    * @see glGetFloatv, glSamplerParameterf, GL_TEXTURE_MAX_ANISOTROPY_EXT */
+  void maxAnisotropy() {
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_TEXTURE_MAX_ANISOTROPY_EXT)
+    GLfloat max_aniso = 0.0f;
+    gl(GetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso));
+    anisotropy(max_aniso);
+#endif
+  }
+
+  /// Sets the minimum level of detail.
+  /** @see glSamplerParameterf, GL_TEXTURE_MIN_LOD */
+  void minLod(GLfloat value) {
+    gl(SamplerParameterf(sampler_, GL_TEXTURE_MIN_LOD, value));
+  }
+
+  /// Sets the maximum level of detail.
+  /** @see glSamplerParameterf, GL_TEXTURE_MAX_LOD */
+  void maxLod(GLfloat value) {
+    gl(SamplerParameterf(sampler_, GL_TEXTURE_MAX_LOD, value));
+  }
+
+  /// Sets the bias added to the level of detail.
+  /** @see glSamplerParameterf, GL_TEXTURE_LOD_BIAS */
+  void lodBias(GLfloat value) {
+    gl(SamplerParameterf(sampler_, GL_TEXTURE_LOD_BIAS, value));
+  }
+
+  /// Sets the border color.
+  /** @see glSamplerParameterfv, GL_TEXTURE_BORDER_COLOR */
+  void borderColor(glm::vec4 color) {
+    gl(SamplerParameterfv(sampler_, GL_TEXTURE_BORDER_COLOR,
+                          glm::value_ptr(color)));
+  }
+
+  /// Sets every parameter of a newly created sampler.
+  /** Only the parameters, that differ from the OpenGL defaults are set, so
+    * a sampler, that already had its parameters changed should be set with
+    * the individual setters. */
+  void parameters(const SamplerDescriptor& descriptor) {
+    const SamplerDescriptor defaults;
+    if (descriptor.min_filter != defaults.min_filter) {
+      minFilter(enums::MinFilter(descriptor.min_filter));
+    }
+    if (descriptor.mag_filter != defaults.mag_filter) {
+      magFilter(enums::MagFilter(descriptor.mag_filter));
+    }
+    if (descriptor.wrap_s != defaults.wrap_s) {
+      wrapS(WrapMode(descriptor.wrap_s));
+    }
+    if (descriptor.wrap_t != defaults.wrap_t) {
+      wrapT(WrapMode(descriptor.wrap_t));
+    }
+    if (descriptor.wrap_r != defaults.wrap_r) {
+      wrapP(WrapMode(descriptor.wrap_r));
+    }
+    if (descriptor.compare_mode != defaults.compare_mode) {
+      compareMode(enums::CompareMode(descriptor.compare_mode));
+    }
+    if (descriptor.compare_func != defaults.compare_func) {
+      compareFunc(enums::CompareFunc(descriptor.compare_func));
+    }
+    if (descriptor.max_anisotropy != defaults.max_anisotropy) {
+      anisotropy(descriptor.max_anisotropy);
+    }
+    if (descriptor.min_lod != defaults.min_lod) {
+      minLod(descriptor.min_lod);
+    }
+    if (descriptor.max_lod != defaults.max_lod) {
+      maxLod(descriptor.max_lod);
+    }
+    if (descriptor.lod_bias != defaults.lod_bias) {
+      lodBias(descriptor.lod_bias);
+    }
+    for (int i = 0; i < 4; ++i) {
+      if (descriptor.border_color[i] != defaults.border_color[i]) {
+        gl(SamplerParameterfv(sampler_, GL_TEXTURE_BORDER_COLOR,
+                              descriptor.border_color));
+        break;
+      }
+    }
+  }
+
+  /// Returns the handle for this object.
+  const glObject& expose() const { return sampler_; }
+
+ private:
+  globjects::Sampler sampler_;
+};
+#endif  // glGenSamplers && glDeleteSamplers && glSamplerParameteri
+
+}  // namespace oglwrap
+
+#if OGLWRAP_DEFINE_EVERYTHING || \
+    (defined(glGenSamplers) && defined(glDeleteSamplers) && \
+     defined(glSamplerParameteri))
+namespace std {
+template<>
+struct hash<OGLWRAP_NAMESPACE_NAME::SamplerDescriptor> {
+  size_t operator()(
+      const OGLWRAP_NAMESPACE_NAME::SamplerDescriptor& descriptor) const {
+    return descriptor.hash();
+  }
+};
+}  // namespace std
+#endif
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_SAMPLER_H_
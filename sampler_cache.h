@@ -0,0 +1,97 @@
+// Copyright (c) Tamas Csala
+
+/** @file sampler_cache.h
+    @brief Implements a cache, that shares one sampler object between every
+           texture with the same sampling parameters.
+*/
+
+#ifndef OGLWRAP_SAMPLER_CACHE_H_
+#define OGLWRAP_SAMPLER_CACHE_H_
+
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+
+#include "./config.h"
+#include "./sampler.h"
+#include "context/binding.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING || \
+    (defined(glGenSamplers) && defined(glDeleteSamplers) && \
+     defined(glSamplerParameteri) && defined(glBindSampler))
+/**
+ * @brief Returns a shared Sampler for every distinct SamplerDescriptor.
+ *
+ * Scenes usually use only a few filtering configurations for thousands of
+ * textures. Instead of setting the parameters on every texture, the textures
+ * can be left with their default parameters, and the sampler of their
+ * configuration is bound next to them. The sampler of a descriptor is created
+ * at the first get(), later calls only look it up.
+ * @code
+ *   gl::SamplerCache samplers;
+ *   gl::SamplerDescriptor trilinear = gl::SamplerDescriptor()
+ *       .minFilter(gl::kLinearMipmapLinear).anisotropy(8.0f);
+ *   ...
+ *   gl::BindToTexUnit(material.diffuse, 0);
+ *   samplers.bind(material.sampling, 0);
+ * @endcode
+ * The samplers are owned by the cache, and live until clear() or the
+ * destruction of the cache.
+ */
+class SamplerCache {
+ public:
+  SamplerCache() : statistics_{0, 0} {}
+
+  /// Returns the sampler with the given parameters, creating it if needed.
+  const Sampler& get(const SamplerDescriptor& descriptor) {
+    auto sampler = samplers_.find(descriptor);
+    if (sampler != samplers_.end()) {
+      statistics_.hits++;
+      return sampler->second;
+    }
+    statistics_.creations++;
+    return samplers_.emplace(std::piecewise_construct,
+                             std::forward_as_tuple(descriptor),
+                             std::forward_as_tuple(descriptor)).first->second;
+  }
+
+  /// Binds the sampler with the given parameters to a texture unit.
+  /** The bind is skipped if the current StateCache knows, that the sampler
+    * is already bound there. */
+  const Sampler& bind(const SamplerDescriptor& descriptor, GLuint unit) {
+    const Sampler& sampler = get(descriptor);
+    Bind(sampler, unit);
+    return sampler;
+  }
+
+  /// Returns the number of distinct samplers.
+  size_t size() const { return samplers_.size(); }
+
+  /// Deletes every sampler.
+  /** The references returned by get() become invalid. */
+  void clear() { samplers_.clear(); }
+
+  /// Counters of the get() calls.
+  struct Statistics {
+    size_t hits;       ///< The descriptors, that already had a sampler.
+    size_t creations;  ///< The samplers, that had to be created.
+  };
+
+  /// Returns the counters since the creation of the cache.
+  const Statistics& statistics() const { return statistics_; }
+
+ private:
+  std::unordered_map<SamplerDescriptor, Sampler> samplers_;
+  Statistics statistics_;
+};
+#endif  // glGenSamplers && glSamplerParameteri && glBindSampler
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_SAMPLER_CACHE_H_
@@ -4,25 +4,36 @@
 #define OGLWRAP_SHAPES_CUBE_SHAPE_INL_H_
 
 #include "./cube_shape.h"
+#include "../vertex_format.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
 inline CubeShape::CubeShape(const std::set<AttributeType>& attribs) {
-  std::vector<glm::vec3> data;
-  data.reserve(attribs.size()*36);
-  void* offset{nullptr};
-
-  Bind(vao_);
-  Bind(buffer_);
+  // Every attribute is a vec3, and is created into its own stream first, and
+  // then they are interleaved, so that a vertex is fetched from a single
+  // cache line.
+  std::vector<std::vector<glm::vec3>> streams;
+  VertexFormat format;
   for (int i = 0; i < kAttribTypeNum; ++i) {
     AttributeType type = static_cast<AttributeType>(i);
     if (attribs.find(type) != attribs.end()) {
-      createAttrib(&data, type);
-      VertexAttrib(i).pointer(
-          3, DataType::kFloat, false, 0, offset).enable();
-      offset = (void*)(data.size() * sizeof(glm::vec3));
+      streams.emplace_back();
+      createAttrib(&streams.back(), type);
+      format.add<glm::vec3>(i);
     }
   }
+
+  std::vector<glm::vec3> data;
+  data.reserve(streams.size()*36);
+  for (int vertex = 0; vertex < 36; ++vertex) {
+    for (const auto& stream : streams) {
+      data.push_back(stream[vertex]);
+    }
+  }
+
+  Bind(vao_);
+  Bind(buffer_);
+  format.setup();
   buffer_.data(data);
   Unbind(buffer_);
   Unbind(vao_);
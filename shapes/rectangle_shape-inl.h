@@ -4,25 +4,34 @@
 #define OGLWRAP_SHAPES_RECTANGLE_SHAPE_INL_H_
 
 #include "./rectangle_shape.h"
+#include "../vertex_format.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
 inline RectangleShape::RectangleShape(const std::set<AttributeType>& attribs) {
-  std::vector<glm::vec2> data;
-  data.reserve(attribs.size()*4);
-  void* offset{nullptr};
-
-  Bind(vao_);
-  Bind(buffer_);
+  // The attributes are created into separate streams, and then interleaved.
+  std::vector<std::vector<glm::vec2>> streams;
+  VertexFormat format;
   for (int i = 0; i < kAttribTypeNum; ++i) {
     AttributeType type = static_cast<AttributeType>(i);
     if (attribs.find(type) != attribs.end()) {
-      createAttrib(&data, type);
-      VertexAttrib(i).pointer(
-          2, DataType::kFloat, false, 0, offset).enable();
-      offset = (void*)(data.size() * sizeof(glm::vec2));
+      streams.emplace_back();
+      createAttrib(&streams.back(), type);
+      format.add<glm::vec2>(i);
     }
   }
+
+  std::vector<glm::vec2> data;
+  data.reserve(streams.size()*4);
+  for (int vertex = 0; vertex < 4; ++vertex) {
+    for (const auto& stream : streams) {
+      data.push_back(stream[vertex]);
+    }
+  }
+
+  Bind(vao_);
+  Bind(buffer_);
+  format.setup();
   buffer_.data(data);
   Unbind(buffer_);
   Unbind(vao_);
@@ -7,6 +7,7 @@
 #include <vector>
 #include <algorithm>
 #include "./sphere_shape.h"
+#include "../vertex_format.h"
 
 namespace OGLWRAP_NAMESPACE_NAME {
 
@@ -17,21 +18,38 @@ inline SphereShape::SphereShape(const std::set<AttributeType>& attribs,
   assert(segments_);
   assert(attribs.size());
 
-  std::vector<float> data;
-  void* offset{nullptr};
-
-  Bind(vao_);
-  Bind(buffer_);
+  // Every attribute is created into its own stream first, and then they are
+  // interleaved, so that a vertex is fetched from a single cache line.
+  std::vector<std::vector<float>> streams;
+  std::vector<GLuint> components;
+  VertexFormat format;
   for (int i = 0; i < kAttribTypeNum; ++i) {
     AttributeType type = static_cast<AttributeType>(i);
     if (attribs.find(type) != attribs.end()) {
-      GLuint vertex_per_attrib = createAttrib(&data, type);
-      VertexAttrib(i).pointer(
-          vertex_per_attrib, DataType::kFloat, false, 0, offset).enable();
-      offset = (void*)(data.size() * sizeof(float));
-      if (vertex_num_ == 0) { vertex_num_ = data.size() / vertex_per_attrib; }
+      streams.emplace_back();
+      GLuint vertex_per_attrib = createAttrib(&streams.back(), type);
+      components.push_back(vertex_per_attrib);
+      format.add(i, vertex_per_attrib, DataType::kFloat, false,
+                 VertexAttribKind::kFloat, format.stride(),
+                 vertex_per_attrib * sizeof(float));
+      if (vertex_num_ == 0) {
+        vertex_num_ = streams.back().size() / vertex_per_attrib;
+      }
     }
   }
+
+  std::vector<float> data;
+  data.reserve(vertex_num_ * format.stride() / sizeof(float));
+  for (unsigned vertex = 0; vertex < vertex_num_; ++vertex) {
+    for (size_t attrib = 0; attrib < streams.size(); ++attrib) {
+      auto begin = streams[attrib].begin() + vertex * components[attrib];
+      data.insert(data.end(), begin, begin + components[attrib]);
+    }
+  }
+
+  Bind(vao_);
+  Bind(buffer_);
+  format.setup();
   buffer_.data(data);
   Unbind(buffer_);
   Unbind(vao_);
@@ -0,0 +1,93 @@
+// Copyright (c) Tamas Csala
+
+/** @file simd_ops.h
+    @brief Implements the float operations shared by the SIMD kernels, for
+           the instruction set selected in config.h.
+*/
+
+#ifndef OGLWRAP_SIMD_OPS_H_
+#define OGLWRAP_SIMD_OPS_H_
+
+#include <cstddef>
+
+#include "./config.h"
+
+#if OGLWRAP_USE_AVX2
+  #include <immintrin.h>
+#elif OGLWRAP_USE_SSE2
+  #include <emmintrin.h>
+#endif
+#if OGLWRAP_USE_NEON
+  #include <arm_neon.h>
+#endif
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief The scalar float operations, used for the elements, that don't fill
+ *        a whole SIMD register.
+ *
+ * A kernel written as a template of the operations, like
+ * FooWith<SimdFloatOps>, runs on full registers, and the same kernel with
+ * ScalarFloatOps finishes the rest.
+ */
+struct ScalarFloatOps {
+  static constexpr size_t kWidth = 1;
+  typedef float Float;
+
+  static Float Load(const float* p) { return *p; }
+  static void Store(float* p, Float a) { *p = a; }
+  static Float Splat(float value) { return value; }
+  static Float Add(Float a, Float b) { return a + b; }
+  static Float Sub(Float a, Float b) { return a - b; }
+  static Float Mul(Float a, Float b) { return a * b; }
+};
+
+#if OGLWRAP_USE_AVX2
+/// The SIMD float operations, processing 8 floats at once.
+struct SimdFloatOps {
+  static constexpr size_t kWidth = 8;
+  typedef __m256 Float;
+
+  static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+  static void Store(float* p, Float a) { _mm256_storeu_ps(p, a); }
+  static Float Splat(float value) { return _mm256_set1_ps(value); }
+  static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+};
+#elif OGLWRAP_USE_SSE2
+/// The SIMD float operations, processing 4 floats at once.
+struct SimdFloatOps {
+  static constexpr size_t kWidth = 4;
+  typedef __m128 Float;
+
+  static Float Load(const float* p) { return _mm_loadu_ps(p); }
+  static void Store(float* p, Float a) { _mm_storeu_ps(p, a); }
+  static Float Splat(float value) { return _mm_set1_ps(value); }
+  static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+};
+#elif OGLWRAP_USE_NEON
+/// The SIMD float operations, processing 4 floats at once.
+struct SimdFloatOps {
+  static constexpr size_t kWidth = 4;
+  typedef float32x4_t Float;
+
+  static Float Load(const float* p) { return vld1q_f32(p); }
+  static void Store(float* p, Float a) { vst1q_f32(p, a); }
+  static Float Splat(float value) { return vdupq_n_f32(value); }
+  static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+  static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+  static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+};
+#endif
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_SIMD_OPS_H_
@@ -856,6 +856,12 @@ struct IntEnum {
 };
 #endif
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT_2_10_10_10_REV)
+struct Int2101010RevEnum {
+  operator DataType() const { return DataType(GL_INT_2_10_10_10_REV); }
+};
+#endif
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INVALID_ENUM)
 struct InvalidEnumEnum {
   operator ErrorType() const { return ErrorType(GL_INVALID_ENUM); }
@@ -2342,6 +2348,7 @@ struct UnsignedInt248Enum {
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_UNSIGNED_INT_2_10_10_10_REV)
 struct UnsignedInt2101010RevEnum {
+  operator DataType() const { return DataType(GL_UNSIGNED_INT_2_10_10_10_REV); }
   operator PixelDataType() const { return PixelDataType(GL_UNSIGNED_INT_2_10_10_10_REV); }
 };
 #endif
@@ -2830,6 +2837,9 @@ struct ZeroEnum {
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT)
   static smart_enums::IntEnum kInt;
 #endif
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT_2_10_10_10_REV)
+  static smart_enums::Int2101010RevEnum kInt2101010Rev;
+#endif
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INVALID_ENUM)
   static smart_enums::InvalidEnumEnum kInvalidEnum;
 #endif
@@ -3991,6 +4001,9 @@ template<typename T> static void _OGLWRAP_SUPPRESS_UNUSED() {
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT)
   (void) kInt;
 #endif
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT_2_10_10_10_REV)
+  (void) kInt2101010Rev;
+#endif
 #if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INVALID_ENUM)
   (void) kInvalidEnum;
 #endif
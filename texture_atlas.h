@@ -0,0 +1,362 @@
+// Copyright (c) Tamas Csala
+
+/** @file texture_atlas.h
+    @brief Implements packing many small images into the layers of an array
+           texture, so they can be drawn with one texture binding.
+*/
+
+#ifndef OGLWRAP_TEXTURE_ATLAS_H_
+#define OGLWRAP_TEXTURE_ATLAS_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "./config.h"
+#include "textures/texture_3D.h"
+#include "context/binding.h"
+#include "context/pixel_ops.h"
+
+#include <glm/glm.hpp>
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief Packs rectangles into a fixed size area, with the MaxRects
+ *        algorithm.
+ *
+ * The free space is kept as a list of maximal free rectangles, that might
+ * overlap. A new rectangle goes to the free rectangle, that it fits the most
+ * tightly along its shorter side. Removed rectangles are given back to the
+ * free list, so the space can be reused by later insertions.
+ */
+class RectPacker {
+ public:
+  /// A rectangle of the area.
+  struct Rect {
+    GLint x, y;
+    GLsizei width, height;
+  };
+
+  /// Creates an empty area.
+  RectPacker(GLsizei width, GLsizei height)
+      : width_(width), height_(height) {
+    free_.push_back(Rect{0, 0, width, height});
+  }
+
+  /// Finds a place for a rectangle, and marks it used.
+  /** @return If the rectangle fit. */
+  bool insert(GLsizei width, GLsizei height, Rect* rect) {
+    if (width <= 0 || height <= 0) {
+      return false;
+    }
+    const Rect* best = nullptr;
+    GLsizei best_short = 0, best_long = 0;
+    for (const Rect& free : free_) {
+      if (free.width < width || free.height < height) {
+        continue;
+      }
+      GLsizei leftover_x = free.width - width;
+      GLsizei leftover_y = free.height - height;
+      GLsizei short_side = std::min(leftover_x, leftover_y);
+      GLsizei long_side = std::max(leftover_x, leftover_y);
+      if (!best || short_side < best_short ||
+          (short_side == best_short && long_side < best_long)) {
+        best = &free;
+        best_short = short_side;
+        best_long = long_side;
+      }
+    }
+    if (!best) {
+      return false;
+    }
+    *rect = Rect{best->x, best->y, width, height};
+    used_.push_back(*rect);
+    split(*rect);
+    return true;
+  }
+
+  /// Gives back a rectangle returned by insert().
+  /** The free rectangles are rebuilt from the remaining used ones, so the
+      freed space joins its free neighbours into maximal rectangles again. */
+  void remove(const Rect& rect) {
+    for (size_t i = 0; i < used_.size(); ++i) {
+      if (used_[i].x == rect.x && used_[i].y == rect.y) {
+        used_[i] = used_.back();
+        used_.pop_back();
+        break;
+      }
+    }
+    free_.assign(1, Rect{0, 0, width_, height_});
+    for (const Rect& used : used_) {
+      split(used);
+    }
+  }
+
+  /// Frees the whole area.
+  void clear() {
+    free_.assign(1, Rect{0, 0, width_, height_});
+    used_.clear();
+  }
+
+  /// Returns the fraction of the area, that is used.
+  float occupancy() const {
+    size_t used_area = 0;
+    for (const Rect& used : used_) {
+      used_area += size_t(used.width) * used.height;
+    }
+    return float(used_area) / (float(width_) * float(height_));
+  }
+
+  /// Returns the number of the free rectangles.
+  size_t freeCount() const { return free_.size(); }
+
+ private:
+  GLsizei width_, height_;
+  std::vector<Rect> used_;
+  std::vector<Rect> free_;
+  std::vector<Rect> split_;  // reused by split()
+
+  static bool Overlaps(const Rect& a, const Rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+  }
+
+  static bool Contains(const Rect& a, const Rect& b) {
+    return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width &&
+           b.y + b.height <= a.y + a.height;
+  }
+
+  // Splits the free rectangles, that overlap the used one, to the maximal
+  // rectangles around it. The untouched free rectangles are already maximal,
+  // so only the new pieces have to be checked for containment.
+  void split(const Rect& used) {
+    split_.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < free_.size(); ++i) {
+      const Rect free = free_[i];
+      if (!Overlaps(free, used)) {
+        free_[kept++] = free;
+        continue;
+      }
+      if (used.x > free.x) {
+        split_.push_back(Rect{free.x, free.y, used.x - free.x, free.height});
+      }
+      if (used.x + used.width < free.x + free.width) {
+        GLint x = used.x + used.width;
+        split_.push_back(Rect{x, free.y, free.x + free.width - x,
+                              free.height});
+      }
+      if (used.y > free.y) {
+        split_.push_back(Rect{free.x, free.y, free.width, used.y - free.y});
+      }
+      if (used.y + used.height < free.y + free.height) {
+        GLint y = used.y + used.height;
+        split_.push_back(Rect{free.x, y, free.width,
+                              free.y + free.height - y});
+      }
+    }
+    free_.resize(kept);
+
+    for (size_t i = 0; i < split_.size(); ++i) {
+      bool redundant = false;
+      for (size_t j = 0; j < split_.size() && !redundant; ++j) {
+        // Of two equal pieces, only the first one is kept.
+        redundant = j != i && Contains(split_[j], split_[i]) &&
+                    (j < i || !Contains(split_[i], split_[j]));
+      }
+      for (size_t j = 0; j < kept && !redundant; ++j) {
+        redundant = Contains(free_[j], split_[i]);
+      }
+      if (!redundant) {
+        free_.push_back(split_[i]);
+      }
+    }
+  }
+};
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glTexStorage3D) && defined(glTexSubImage3D) \
+        && defined(GL_TEXTURE_2D_ARRAY))
+/**
+ * @brief Packs 8 bit per component images into the layers (pages) of a
+ *        Texture2DArray.
+ *
+ * Sprites and glyphs, that would be separate textures, become regions of the
+ * pages, so every draw using them can share one texture binding, and can be
+ * batched. The images are added incrementally, with a subUpload each, and
+ * can be removed to reuse their space.
+ * @code
+ *   gl::TextureAtlas atlas(2048, 4, 4);
+ *   gl::TextureAtlas::Region region;
+ *   if (atlas.add(pixels, width, height, &region)) {
+ *     sprite.uv = region.uv;       // the (u0, v0, u1, v1) rectangle
+ *     sprite.layer = region.page;  // the layer of the sampler2DArray
+ *   }
+ *   ...
+ *   gl::Bind(atlas.texture());
+ * @endcode
+ * Every image is surrounded by a gutter of padding texels, that repeats its
+ * edge texels, so linear filtering at the edges of the uv rectangle doesn't
+ * bleed the neighbouring images in. Mipmaps would mix the neighbours anyway,
+ * so the pages have a single level.
+ *
+ * The pages are allocated at construction with immutable storage, add()
+ * fails when none of them has room. add() and remove() have to be called on
+ * the thread of the context.
+ */
+class TextureAtlas {
+ public:
+  /// The place of an image in the atlas.
+  struct Region {
+    GLsizei page;           ///< The layer of the texture.
+    RectPacker::Rect rect;  ///< The texels of the image, without the gutter.
+    glm::vec4 uv;           ///< The texture coordinates, as (u0, v0, u1, v1).
+  };
+
+  /// Allocates the pages.
+  /** @param page_size  The width and height of the pages.
+    * @param page_count The number of pages.
+    * @param channels   The number of components per texel (1 - 4).
+    * @param padding    The width of the gutter around the images.
+    * @param srgb       If the colors of 3 and 4 channel images are sRGB. */
+  TextureAtlas(GLsizei page_size, GLsizei page_count, unsigned channels,
+               GLsizei padding = 1, bool srgb = false)
+      : page_size_(page_size), channels_(channels), padding_(padding),
+        pages_(page_count, RectPacker(page_size, page_size)) {
+    TemporaryBind bind(texture_);
+    texture_.storage(1, InternalFormat(channels, srgb), page_size, page_size,
+                     page_count);
+  }
+
+  /// Packs an image into a page, and uploads it with its gutter.
+  /** @param pixels  The tightly packed rows of the image, first row first.
+    * @param width   The width of the image.
+    * @param height  The height of the image.
+    * @param region  Where the image was put.
+    * @return If the image fit into a page (false for an empty image). */
+  bool add(const void* pixels, GLsizei width, GLsizei height,
+           Region* region) {
+    if (width <= 0 || height <= 0) {
+      return false;
+    }
+    RectPacker::Rect rect;
+    for (size_t page = 0; page < pages_.size(); ++page) {
+      if (pages_[page].insert(width + 2 * padding_, height + 2 * padding_,
+                              &rect)) {
+        region->page = GLsizei(page);
+        region->rect = RectPacker::Rect{rect.x + padding_, rect.y + padding_,
+                                        width, height};
+        float scale = 1.0f / page_size_;
+        region->uv = glm::vec4(region->rect.x, region->rect.y,
+                               region->rect.x + width,
+                               region->rect.y + height) * scale;
+        upload(static_cast<const unsigned char*>(pixels), rect, *region);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Frees the space of an image, so later images can reuse it.
+  /** The texels aren't cleared. */
+  void remove(const Region& region) {
+    pages_[region.page].remove(
+        RectPacker::Rect{region.rect.x - padding_, region.rect.y - padding_,
+                         region.rect.width + 2 * padding_,
+                         region.rect.height + 2 * padding_});
+  }
+
+  /// Frees every image.
+  void clear() {
+    for (RectPacker& page : pages_) {
+      page.clear();
+    }
+  }
+
+  /// Returns the array texture, that holds the pages.
+  Texture2DArray& texture() { return texture_; }
+
+  /// Returns the array texture, that holds the pages.
+  const Texture2DArray& texture() const { return texture_; }
+
+  /// Returns the number of pages.
+  GLsizei pageCount() const { return GLsizei(pages_.size()); }
+
+  /// Returns the fraction of the area of a page, that is used (including the
+  /// gutters).
+  float occupancy(GLsizei page) const { return pages_[page].occupancy(); }
+
+ private:
+  Texture2DArray texture_;
+  GLsizei page_size_;
+  unsigned channels_;
+  GLsizei padding_;
+  std::vector<RectPacker> pages_;
+  std::vector<unsigned char> staging_;
+
+  static PixelDataInternalFormat InternalFormat(unsigned channels,
+                                                bool srgb) {
+    switch (channels) {
+      case 1: return PixelDataInternalFormat::kR8;
+      case 2: return PixelDataInternalFormat::kRg8;
+      case 3: return srgb ? PixelDataInternalFormat::kSrgb8
+                          : PixelDataInternalFormat::kRgb8;
+      default: return srgb ? PixelDataInternalFormat::kSrgb8Alpha8
+                           : PixelDataInternalFormat::kRgba8;
+    }
+  }
+
+  PixelDataFormat format() const {
+    switch (channels_) {
+      case 1: return PixelDataFormat::kRed;
+      case 2: return PixelDataFormat::kRg;
+      case 3: return PixelDataFormat::kRgb;
+      default: return PixelDataFormat::kRgba;
+    }
+  }
+
+  // Uploads the image and its gutter (the edge texels repeated) to the rect
+  // of the region's page, with one subUpload.
+  void upload(const unsigned char* pixels, const RectPacker::Rect& rect,
+              const Region& region) {
+    const unsigned char* source = pixels;
+    if (padding_ > 0) {
+      size_t texel = channels_;
+      size_t row = size_t(rect.width) * texel;
+      staging_.resize(row * rect.height);
+      for (GLsizei y = 0; y < rect.height; ++y) {
+        GLsizei source_y = std::min(std::max(y - padding_, 0),
+                                    region.rect.height - 1);
+        const unsigned char* source_row =
+            pixels + size_t(source_y) * region.rect.width * texel;
+        unsigned char* out = staging_.data() + y * row;
+        for (GLsizei x = 0; x < padding_; ++x) {
+          std::memcpy(out + x * texel, source_row, texel);
+          std::memcpy(out + (padding_ + region.rect.width + x) * texel,
+                      source_row + (region.rect.width - 1) * texel, texel);
+        }
+        std::memcpy(out + padding_ * texel, source_row,
+                    region.rect.width * texel);
+      }
+      source = staging_.data();
+    }
+
+    TemporaryBind bind(texture_);
+    TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                         1);
+    texture_.subUploadMipmap(0, rect.x, rect.y, region.page, rect.width,
+                             rect.height, 1, format(),
+                             PixelDataType::kUnsignedByte, source);
+  }
+};
+#endif  // glTexStorage3D && glTexSubImage3D && GL_TEXTURE_2D_ARRAY
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_TEXTURE_ATLAS_H_
@@ -0,0 +1,540 @@
+// Copyright (c) Tamas Csala
+
+/** @file texture_container.h
+    @brief Implements reading KTX, KTX2 and DDS files, and uploading their
+           precompressed images without decoding them.
+*/
+
+#ifndef OGLWRAP_TEXTURE_CONTAINER_H_
+#define OGLWRAP_TEXTURE_CONTAINER_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include "./config.h"
+#include "textures/texture_2D.h"
+#include "textures/texture_3D.h"
+#include "textures/texture_cube.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glTexStorage2D) && defined(glCompressedTexSubImage2D))
+/**
+ * @brief A memory mapped KTX, KTX2 or DDS file with block compressed images.
+ *
+ * The file is only mapped and its headers are parsed, the images aren't read
+ * or decoded. upload() allocates the immutable storage of the texture, and
+ * passes the mapped images of every level straight to
+ * glCompressedTexSubImage, so the only copy is the one the driver makes.
+ * @code
+ *   gl::TextureContainer file("rock_albedo.ktx2");
+ *   gl::Bind(texture);
+ *   file.upload(texture);
+ * @endcode
+ * Supports the BC1-BC7, ETC2/EAC and ASTC (LDR) formats, in 2D, cube map and
+ * 2D array textures. KTX2 files have to be without supercompression, and DDS
+ * files either have a DX10 header, or one of the DXT1-5, ATI1/2 or BC4/5
+ * FourCCs. The constructor throws std::runtime_error if the file can't be
+ * read, or isn't one of those.
+ *
+ * The texture has to be bound, and no PixelUnpackBuffer should be bound while
+ * uploading.
+ */
+class TextureContainer {
+ public:
+  /// A compressed image (a face of a layer) of a mipmap level.
+  struct Image {
+    const void* data;  ///< Points into the mapped file.
+    GLsizei size;      ///< The size of the image in bytes.
+    GLsizei width;     ///< The width of the image in texels.
+    GLsizei height;    ///< The height of the image in texels.
+  };
+
+  /// Maps the file, and parses its header.
+  explicit TextureContainer(const std::string& file)
+      : mapping_(file), format_(0), width_(0), height_(0), layers_(0),
+        faces_(1), levels_(1) {
+    static const unsigned char kKtx[] = {
+      0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    static const unsigned char kKtx2[] = {
+      0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    if (startsWith(kKtx, sizeof(kKtx))) {
+      parseKtx(file);
+    } else if (startsWith(kKtx2, sizeof(kKtx2))) {
+      parseKtx2(file);
+    } else if (startsWith(reinterpret_cast<const unsigned char*>("DDS "), 4)) {
+      parseDds(file);
+    } else {
+      throw std::runtime_error("Unknown texture container: " + file);
+    }
+  }
+
+  TextureContainer(const TextureContainer&) = delete;
+  TextureContainer& operator=(const TextureContainer&) = delete;
+
+  /// Returns the compressed internal format of the images.
+  GLenum format() const { return format_; }
+
+  /// Returns the width of the base level.
+  GLsizei width() const { return width_; }
+
+  /// Returns the height of the base level.
+  GLsizei height() const { return height_; }
+
+  /// Returns the number of array layers, or 0 if it isn't an array texture.
+  GLsizei layers() const { return layers_; }
+
+  /// Returns the number of faces, 6 for cube maps and 1 for everything else.
+  GLsizei faces() const { return faces_; }
+
+  /// Returns the number of mipmap levels in the file.
+  GLsizei levels() const { return levels_; }
+
+  /// Returns if the file holds an array texture.
+  bool isArray() const { return layers_ != 0; }
+
+  /// Returns if the file holds a cube map.
+  bool isCube() const { return faces_ == 6; }
+
+  /// Returns an image of the file.
+  /** @param level  The mipmap level.
+    * @param layer  The array layer, must be 0 for non-array textures.
+    * @param face   The face of the cube map, in the order of the
+    *               TextureCubeTargets, must be 0 for non-cube textures. */
+  const Image& image(GLsizei level, GLsizei layer = 0, GLsizei face = 0) const {
+    return images_[(size_t(level) * std::max(layers_, 1) + layer) * faces_
+                   + face];
+  }
+
+  /// Allocates the storage of the texture, and uploads every level.
+  /** The file has to hold a non-array, non-cube texture. */
+  template <Texture2DType texture_t>
+  void upload(Texture2DBase<texture_t>& texture) const {
+    if (isArray() || isCube()) {
+      throw std::invalid_argument("TextureContainer: the file doesn't hold a "
+                                  "2D texture");
+    }
+    texture.storage(levels_, format_, width_, height_);
+    for (GLsizei level = 0; level < levels_; ++level) {
+      const Image& mip = image(level);
+      texture.compressedSubUploadMipmap(level, 0, 0, mip.width, mip.height,
+                                        format_, mip.size, mip.data);
+    }
+  }
+
+  /// Allocates the storage of the cube map, and uploads every level of every
+  /// face.
+  /** The file has to hold a non-array cube map. */
+  void upload(TextureCube& texture) const {
+    if (isArray() || !isCube()) {
+      throw std::invalid_argument("TextureContainer: the file doesn't hold a "
+                                  "cube map");
+    }
+    texture.storage(levels_, format_, width_, height_);
+    for (GLsizei level = 0; level < levels_; ++level) {
+      for (GLsizei face = 0; face < 6; ++face) {
+        const Image& mip = image(level, 0, face);
+        texture.compressedSubUploadMipmap(
+            TextureCubeTarget(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face), level,
+            0, 0, mip.width, mip.height, format_, mip.size, mip.data);
+      }
+    }
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glTexStorage3D) && defined(glCompressedTexSubImage3D) \
+        && defined(GL_TEXTURE_2D_ARRAY))
+  /// Allocates the storage of the array texture, and uploads every level of
+  /// every layer.
+  /** The file has to hold a non-cube array texture. */
+  void upload(Texture2DArray& texture) const {
+    if (!isArray() || isCube()) {
+      throw std::invalid_argument("TextureContainer: the file doesn't hold a "
+                                  "2D array texture");
+    }
+    texture.storage(levels_, PixelDataInternalFormat(format_), width_, height_,
+                    layers_);
+    for (GLsizei level = 0; level < levels_; ++level) {
+      for (GLsizei layer = 0; layer < layers_; ++layer) {
+        const Image& mip = image(level, layer);
+        texture.compressedSubUploadMipmap(level, 0, 0, layer, mip.width,
+                                          mip.height, 1, format_, mip.size,
+                                          mip.data);
+      }
+    }
+  }
+#endif  // glTexStorage3D && glCompressedTexSubImage3D
+
+ private:
+  // A read-only memory mapping of a whole file.
+  class Mapping {
+   public:
+    explicit Mapping(const std::string& file) : data_(nullptr), size_(0) {
+#ifdef _WIN32
+      HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+          HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY,
+                                              0, 0, nullptr);
+          if (mapping) {
+            data_ = static_cast<const unsigned char*>(
+                MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            size_ = data_ ? size_t(size.QuadPart) : 0;
+            CloseHandle(mapping);
+          }
+        }
+        CloseHandle(handle);
+      }
+#else
+      int handle = open(file.c_str(), O_RDONLY);
+      if (handle != -1) {
+        struct stat status;
+        if (fstat(handle, &status) == 0 && status.st_size > 0) {
+          void* data = mmap(nullptr, size_t(status.st_size), PROT_READ,
+                            MAP_PRIVATE, handle, 0);
+          if (data != MAP_FAILED) {
+            data_ = static_cast<const unsigned char*>(data);
+            size_ = size_t(status.st_size);
+          }
+        }
+        close(handle);
+      }
+#endif
+      if (!data_) {
+        throw std::runtime_error("Can't map texture file: " + file);
+      }
+    }
+
+    ~Mapping() {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+   private:
+    const unsigned char* data_;
+    size_t size_;
+  };
+
+  // The block size of a compressed format, and its codes in the containers.
+  struct FormatInfo {
+    GLenum format;
+    uint32_t vk_format;    // VkFormat in KTX2, 0 if there isn't one
+    uint32_t dxgi_format;  // DXGI_FORMAT in DDS, 0 if there isn't one
+    GLsizei block_width;
+    GLsizei block_height;
+    GLsizei block_bytes;
+  };
+
+  Mapping mapping_;
+  std::vector<Image> images_;
+  GLenum format_;
+  GLsizei width_, height_, layers_, faces_, levels_;
+  FormatInfo info_;
+
+  static const FormatInfo* Formats(size_t* count) {
+    // The GL enums of the compression extensions, so they don't have to be
+    // in the loaded GL header.
+    static const FormatInfo kFormats[] = {
+      {0x83F0, 131, 0,  4, 4, 8},   // RGB_S3TC_DXT1 (BC1)
+      {0x8C4C, 132, 0,  4, 4, 8},   // SRGB_S3TC_DXT1
+      {0x83F1, 133, 71, 4, 4, 8},   // RGBA_S3TC_DXT1
+      {0x8C4D, 134, 72, 4, 4, 8},   // SRGB_ALPHA_S3TC_DXT1
+      {0x83F2, 135, 74, 4, 4, 16},  // RGBA_S3TC_DXT3 (BC2)
+      {0x8C4E, 136, 75, 4, 4, 16},  // SRGB_ALPHA_S3TC_DXT3
+      {0x83F3, 137, 77, 4, 4, 16},  // RGBA_S3TC_DXT5 (BC3)
+      {0x8C4F, 138, 78, 4, 4, 16},  // SRGB_ALPHA_S3TC_DXT5
+      {0x8DBB, 139, 80, 4, 4, 8},   // RED_RGTC1 (BC4)
+      {0x8DBC, 140, 81, 4, 4, 8},   // SIGNED_RED_RGTC1
+      {0x8DBD, 141, 83, 4, 4, 16},  // RG_RGTC2 (BC5)
+      {0x8DBE, 142, 84, 4, 4, 16},  // SIGNED_RG_RGTC2
+      {0x8E8F, 143, 95, 4, 4, 16},  // RGB_BPTC_UNSIGNED_FLOAT (BC6H)
+      {0x8E8E, 144, 96, 4, 4, 16},  // RGB_BPTC_SIGNED_FLOAT
+      {0x8E8C, 145, 98, 4, 4, 16},  // RGBA_BPTC_UNORM (BC7)
+      {0x8E8D, 146, 99, 4, 4, 16},  // SRGB_ALPHA_BPTC_UNORM
+      {0x9274, 147, 0,  4, 4, 8},   // RGB8_ETC2
+      {0x9275, 148, 0,  4, 4, 8},   // SRGB8_ETC2
+      {0x9276, 149, 0,  4, 4, 8},   // RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+      {0x9277, 150, 0,  4, 4, 8},   // SRGB8_PUNCHTHROUGH_ALPHA1_ETC2
+      {0x9278, 151, 0,  4, 4, 16},  // RGBA8_ETC2_EAC
+      {0x9279, 152, 0,  4, 4, 16},  // SRGB8_ALPHA8_ETC2_EAC
+      {0x9270, 153, 0,  4, 4, 8},   // R11_EAC
+      {0x9271, 154, 0,  4, 4, 8},   // SIGNED_R11_EAC
+      {0x9272, 155, 0,  4, 4, 16},  // RG11_EAC
+      {0x9273, 156, 0,  4, 4, 16},  // SIGNED_RG11_EAC
+      {0x93B0, 157, 0,  4, 4, 16},  // RGBA_ASTC_4x4
+      {0x93D0, 158, 0,  4, 4, 16},  // SRGB8_ALPHA8_ASTC_4x4
+      {0x93B1, 159, 0,  5, 4, 16},  // RGBA_ASTC_5x4
+      {0x93D1, 160, 0,  5, 4, 16},
+      {0x93B2, 161, 0,  5, 5, 16},  // RGBA_ASTC_5x5
+      {0x93D2, 162, 0,  5, 5, 16},
+      {0x93B3, 163, 0,  6, 5, 16},  // RGBA_ASTC_6x5
+      {0x93D3, 164, 0,  6, 5, 16},
+      {0x93B4, 165, 0,  6, 6, 16},  // RGBA_ASTC_6x6
+      {0x93D4, 166, 0,  6, 6, 16},
+      {0x93B5, 167, 0,  8, 5, 16},  // RGBA_ASTC_8x5
+      {0x93D5, 168, 0,  8, 5, 16},
+      {0x93B6, 169, 0,  8, 6, 16},  // RGBA_ASTC_8x6
+      {0x93D6, 170, 0,  8, 6, 16},
+      {0x93B7, 171, 0,  8, 8, 16},  // RGBA_ASTC_8x8
+      {0x93D7, 172, 0,  8, 8, 16},
+      {0x93B8, 173, 0, 10, 5, 16},  // RGBA_ASTC_10x5
+      {0x93D8, 174, 0, 10, 5, 16},
+      {0x93B9, 175, 0, 10, 6, 16},  // RGBA_ASTC_10x6
+      {0x93D9, 176, 0, 10, 6, 16},
+      {0x93BA, 177, 0, 10, 8, 16},  // RGBA_ASTC_10x8
+      {0x93DA, 178, 0, 10, 8, 16},
+      {0x93BB, 179, 0, 10, 10, 16},  // RGBA_ASTC_10x10
+      {0x93DB, 180, 0, 10, 10, 16},
+      {0x93BC, 181, 0, 12, 10, 16},  // RGBA_ASTC_12x10
+      {0x93DC, 182, 0, 12, 10, 16},
+      {0x93BD, 183, 0, 12, 12, 16},  // RGBA_ASTC_12x12
+      {0x93DD, 184, 0, 12, 12, 16},
+    };
+    *count = sizeof(kFormats) / sizeof(kFormats[0]);
+    return kFormats;
+  }
+
+  // Finds the format, whose field matches the code.
+  static const FormatInfo* FindFormat(uint32_t FormatInfo::*field,
+                                      uint32_t code) {
+    size_t count;
+    const FormatInfo* formats = Formats(&count);
+    for (size_t i = 0; i < count; ++i) {
+      if (code != 0 && formats[i].*field == code) {
+        return &formats[i];
+      }
+    }
+    return nullptr;
+  }
+
+  bool startsWith(const unsigned char* prefix, size_t size) const {
+    return mapping_.size() >= size &&
+           std::memcmp(mapping_.data(), prefix, size) == 0;
+  }
+
+  // Reads a little endian integer of the file.
+  template <typename T>
+  T read(size_t offset, const std::string& file) const {
+    if (offset + sizeof(T) > mapping_.size()) {
+      throw std::runtime_error("Truncated texture file: " + file);
+    }
+    T value;
+    std::memcpy(&value, mapping_.data() + offset, sizeof(T));
+    return value;
+  }
+
+  // Sets the format, and validates the dimensions.
+  void setFormat(const FormatInfo* info, const std::string& file) {
+    if (!info) {
+      throw std::runtime_error("Unsupported texture format in: " + file);
+    }
+    if (width_ <= 0 || height_ <= 0 || levels_ <= 0 || levels_ > 32 ||
+        layers_ < 0 || layers_ > 65536 || (faces_ != 1 && faces_ != 6)) {
+      throw std::runtime_error("Invalid texture dimensions in: " + file);
+    }
+    // Every image has at least one block, so a header can't make the
+    // image table larger than the file allows.
+    size_t image_count = size_t(levels_) * std::max(layers_, 1) * faces_;
+    if (image_count > mapping_.size() / info->block_bytes) {
+      throw std::runtime_error("Truncated texture file: " + file);
+    }
+    info_ = *info;
+    format_ = info->format;
+    images_.resize(image_count);
+  }
+
+  // Returns the size of an image of the level in bytes.
+  size_t imageSize(GLsizei level) const {
+    size_t blocks_x = (std::max(width_ >> level, 1) + info_.block_width - 1)
+                      / info_.block_width;
+    size_t blocks_y = (std::max(height_ >> level, 1) + info_.block_height - 1)
+                      / info_.block_height;
+    return blocks_x * blocks_y * info_.block_bytes;
+  }
+
+  // Sets an image, that starts at the offset of the file.
+  void setImage(GLsizei level, GLsizei layer, GLsizei face, size_t offset,
+                const std::string& file) {
+    size_t size = imageSize(level);
+    if (offset > mapping_.size() || size > mapping_.size() - offset) {
+      throw std::runtime_error("Truncated texture file: " + file);
+    }
+    images_[(size_t(level) * std::max(layers_, 1) + layer) * faces_ + face] =
+        Image{mapping_.data() + offset, GLsizei(size),
+              std::max(width_ >> level, 1), std::max(height_ >> level, 1)};
+  }
+
+  void parseKtx(const std::string& file) {
+    if (read<uint32_t>(12, file) != 0x04030201) {
+      throw std::runtime_error("Big endian KTX files aren't supported: " +
+                               file);
+    }
+    if (read<uint32_t>(16, file) != 0) {
+      throw std::runtime_error("Uncompressed KTX files aren't supported: " +
+                               file);
+    }
+    if (read<uint32_t>(44, file) > 1) {
+      throw std::runtime_error("3D textures aren't supported: " + file);
+    }
+    width_ = read<uint32_t>(36, file);
+    height_ = std::max<GLsizei>(read<uint32_t>(40, file), 1);
+    layers_ = read<uint32_t>(48, file);
+    faces_ = read<uint32_t>(52, file);
+    levels_ = std::max<GLsizei>(read<uint32_t>(56, file), 1);
+    setFormat(FindFormat(&FormatInfo::format, read<uint32_t>(28, file)), file);
+
+    // Every level starts with its size, then has every face of every layer,
+    // padded to 4 bytes.
+    size_t offset = 64 + size_t(read<uint32_t>(60, file));
+    for (GLsizei level = 0; level < levels_; ++level) {
+      offset += sizeof(uint32_t);  // imageSize
+      for (GLsizei layer = 0; layer < std::max(layers_, 1); ++layer) {
+        for (GLsizei face = 0; face < faces_; ++face) {
+          setImage(level, layer, face, offset, file);
+          offset += (imageSize(level) + 3) & ~size_t(3);
+        }
+      }
+    }
+  }
+
+  void parseKtx2(const std::string& file) {
+    if (read<uint32_t>(44, file) != 0) {
+      throw std::runtime_error("Supercompressed KTX2 files aren't supported: "
+                               + file);
+    }
+    if (read<uint32_t>(28, file) > 1) {
+      throw std::runtime_error("3D textures aren't supported: " + file);
+    }
+    width_ = read<uint32_t>(20, file);
+    height_ = std::max<GLsizei>(read<uint32_t>(24, file), 1);
+    layers_ = read<uint32_t>(32, file);
+    faces_ = read<uint32_t>(36, file);
+    levels_ = std::max<GLsizei>(read<uint32_t>(40, file), 1);
+    setFormat(FindFormat(&FormatInfo::vk_format, read<uint32_t>(12, file)),
+              file);
+
+    // The level index follows the header, every level has the faces of its
+    // layers packed tightly.
+    for (GLsizei level = 0; level < levels_; ++level) {
+      size_t offset = size_t(read<uint64_t>(80 + level * 24, file));
+      for (GLsizei layer = 0; layer < std::max(layers_, 1); ++layer) {
+        for (GLsizei face = 0; face < faces_; ++face) {
+          setImage(level, layer, face, offset, file);
+          offset += imageSize(level);
+        }
+      }
+    }
+  }
+
+  void parseDds(const std::string& file) {
+    static const uint32_t kDx10 = FourCC("DX10");
+    static const uint32_t kCubeMap = 0x200;        // DDSCAPS2_CUBEMAP
+    static const uint32_t kVolume = 0x200000;      // DDSCAPS2_VOLUME
+    static const uint32_t kAlphaPixels = 0x1;      // DDPF_ALPHAPIXELS
+    static const uint32_t kTextureCube = 0x4;      // RESOURCE_MISC_TEXTURECUBE
+    static const uint32_t kTexture3D = 4;          // DIMENSION_TEXTURE3D
+
+    if (read<uint32_t>(4, file) != 124) {
+      throw std::runtime_error("Invalid DDS header in: " + file);
+    }
+    if (read<uint32_t>(112, file) & kVolume) {
+      throw std::runtime_error("3D textures aren't supported: " + file);
+    }
+    height_ = read<uint32_t>(12, file);
+    width_ = read<uint32_t>(16, file);
+    levels_ = std::max<GLsizei>(read<uint32_t>(28, file), 1);
+    faces_ = (read<uint32_t>(112, file) & kCubeMap) ? 6 : 1;
+
+    const FormatInfo* info;
+    size_t offset;
+    uint32_t four_cc = read<uint32_t>(84, file);
+    if (four_cc == kDx10) {
+      if (read<uint32_t>(132, file) == kTexture3D) {
+        throw std::runtime_error("3D textures aren't supported: " + file);
+      }
+      info = FindFormat(&FormatInfo::dxgi_format, read<uint32_t>(128, file));
+      if (read<uint32_t>(136, file) & kTextureCube) {
+        faces_ = 6;
+      }
+      GLsizei array_size = read<uint32_t>(140, file);
+      layers_ = array_size > 1 ? array_size : 0;
+      offset = 148;
+    } else {
+      GLenum format = 0;
+      if (four_cc == FourCC("DXT1")) {
+        format = (read<uint32_t>(80, file) & kAlphaPixels) ? 0x83F1 : 0x83F0;
+      } else if (four_cc == FourCC("DXT2") || four_cc == FourCC("DXT3")) {
+        format = 0x83F2;
+      } else if (four_cc == FourCC("DXT4") || four_cc == FourCC("DXT5")) {
+        format = 0x83F3;
+      } else if (four_cc == FourCC("ATI1") || four_cc == FourCC("BC4U")) {
+        format = 0x8DBB;
+      } else if (four_cc == FourCC("BC4S")) {
+        format = 0x8DBC;
+      } else if (four_cc == FourCC("ATI2") || four_cc == FourCC("BC5U")) {
+        format = 0x8DBD;
+      } else if (four_cc == FourCC("BC5S")) {
+        format = 0x8DBE;
+      }
+      info = FindFormat(&FormatInfo::format, format);
+      offset = 128;
+    }
+    setFormat(info, file);
+
+    // Every face of every layer has its whole mipmap chain packed tightly.
+    for (GLsizei layer = 0; layer < std::max(layers_, 1); ++layer) {
+      for (GLsizei face = 0; face < faces_; ++face) {
+        for (GLsizei level = 0; level < levels_; ++level) {
+          setImage(level, layer, face, offset, file);
+          offset += imageSize(level);
+        }
+      }
+    }
+  }
+
+  static uint32_t FourCC(const char* code) {
+    return uint32_t(code[0]) | uint32_t(code[1]) << 8 |
+           uint32_t(code[2]) << 16 | uint32_t(code[3]) << 24;
+  }
+};
+#endif  // glTexStorage2D && glCompressedTexSubImage2D
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_TEXTURE_CONTAINER_H_
@@ -0,0 +1,664 @@
+// Copyright (c) Tamas Csala
+
+/** @file texture_loader.h
+    @brief Implements loading textures from files, decoding them on worker
+           threads, and only uploading them on the thread of the context.
+*/
+
+#ifndef OGLWRAP_TEXTURE_LOADER_H_
+#define OGLWRAP_TEXTURE_LOADER_H_
+
+#include <mutex>
+#include <queue>
+#include <deque>
+#include <thread>
+#include <string>
+#include <vector>
+#include <limits>
+#include <memory>
+#include <cstdint>
+#include <fstream>
+#include <utility>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+#include <condition_variable>
+
+#include "./config.h"
+#include "./mip_chain.h"
+#include "./block_compressor.h"
+#include "./texture_container.h"
+#include "textures/texture_2D.h"
+#include "textures/texture_cube.h"
+#include "context/binding.h"
+#include "context/pixel_ops.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief Loads textures from files in the background.
+ *
+ * The file reading and decoding happens on the worker threads of the loader,
+ * in the order of the priorities of the requests. The thread of the context
+ * only creates the storage of the textures, and uploads the decoded images
+ * in update(), with a budget in bytes, so a level load doesn't freeze the
+ * rendering.
+ * @code
+ *   gl::TextureLoader loader;
+ *   for (Material& material : materials) {
+ *     loader.load(material.diffuse, material.diffuse_file);
+ *   }
+ *   loader.load(sky_box, gl::TextureCubeTarget::kTextureCubeMapPositiveX,
+ *               "sky_px.png", "SRGB", 10);  // needed sooner
+ *
+ *   // every frame
+ *   loader.update(8 * 1024 * 1024);
+ *
+ *   // or during a loading screen
+ *   loader.finish();
+ * @endcode
+ * The format strings are the same as the ones of Texture2D::loadTexture.
+ * Images are decoded with Magick++ if OGLWRAP_USE_IMAGEMAGICK is set,
+ * otherwise only TGA files are supported, unless a Decoder is given.
+ *
+ * Instead of leaving the compression to the driver, the images requested
+ * with 'C' are encoded to BC1 (or BC3 with alpha) with a full mipmap chain on
+ * the worker threads, and the result is cached next to the image file (see
+ * CompressedMipChain::CacheFile). Later loads of the same image with the same
+ * format string read the cache file, and skip the decoding and encoding.
+ *
+ * The functions, except update() and finish(), can be called from any
+ * thread. The textures have to outlive the update(), that uploads to them
+ * (or the cancellation of their requests).
+ */
+class TextureLoader {
+ public:
+  /// A decoded image, with 8 bit components, and the first row at the top.
+  struct Image {
+    GLsizei width;
+    GLsizei height;
+    bool alpha;  // RGBA if true, RGB otherwise
+    std::vector<unsigned char> pixels;
+  };
+
+  /// Decodes an image from a file.
+  /** @param file   The path of the file.
+    * @param alpha  If the image has to be decoded to RGBA (instead of RGB).
+    * @param image  Where the image should be written.
+    * @return If the decoding succeeded. */
+  using Decoder =
+      std::function<bool(const std::string& file, bool alpha, Image* image)>;
+
+  /// Called on the thread of the context, after the texture was uploaded,
+  /// or the image couldn't be decoded.
+  using Callback = std::function<void(bool success)>;
+
+  /// Identifies a load request.
+  using Request = uint64_t;
+
+  /// Starts the worker threads.
+  /** @param thread_count  The number of decoding threads. 0 means one per
+    *                      hardware thread.
+    * @param decoder       The function, that decodes the files. */
+  explicit TextureLoader(size_t thread_count = 0,
+                         Decoder decoder = DefaultDecoder)
+      : decoder_(std::move(decoder)), next_id_(1), decoding_(0),
+        stop_(false), statistics_{0, 0, 0, 0, 0} {
+    if (thread_count == 0) {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+      workers_.emplace_back(&TextureLoader::workerLoop, this);
+    }
+  }
+
+  /// Stops and joins the worker threads. The unfinished requests are
+  /// dropped, without calling their callbacks.
+  ~TextureLoader() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  TextureLoader(const TextureLoader&) = delete;
+  TextureLoader& operator=(const TextureLoader&) = delete;
+
+  /// Requests loading a 2D texture from a file.
+  /** @param texture        The texture to upload the image to.
+    * @param file           The path of the image file.
+    * @param format_string  The components to load ('S' for sRGB, 'C' for a
+    *                       compressed internal format).
+    * @param priority       The requests with higher priority are decoded
+    *                       first.
+    * @param done           Called after the upload. */
+  template <Texture2DType texture_t>
+  Request load(Texture2DBase<texture_t>& texture, const std::string& file,
+               const std::string& format_string = "CSRGBA", int priority = 0,
+               Callback done = nullptr) {
+    Job job = MakeJob(file, format_string, priority, std::move(done));
+    job.upload = [&texture](const Image& image,
+                            PixelDataInternalFormat internal_format) {
+      TemporaryBind bind(texture);
+      texture.upload(internal_format, image.width, image.height,
+                     image.alpha ? PixelDataFormat::kRgba
+                                 : PixelDataFormat::kRgb,
+                     PixelDataType::kUnsignedByte, image.pixels.data());
+    };
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+    job.upload_compressed = [&texture](GLenum format,
+                                       const CompressedLevels& levels) {
+      TemporaryBind bind(texture);
+      for (size_t level = 0; level < levels.size(); ++level) {
+        texture.compressedUploadMipmap(GLint(level), format,
+                                       levels[level].width,
+                                       levels[level].height,
+                                       levels[level].size,
+                                       levels[level].data);
+      }
+    };
+#endif
+    return enqueue(std::move(job));
+  }
+
+  /// Requests loading a face of a cube map from a file.
+  /** @see load(Texture2DBase<texture_t>&, const std::string&,
+    *           const std::string&, int, Callback) */
+  Request load(TextureCube& texture, TextureCubeTarget target,
+               const std::string& file,
+               const std::string& format_string = "CSRGBA", int priority = 0,
+               Callback done = nullptr) {
+    Job job = MakeJob(file, format_string, priority, std::move(done));
+    job.upload = [&texture, target](const Image& image,
+                                    PixelDataInternalFormat internal_format) {
+      TemporaryBind bind(texture);
+      texture.upload(target, internal_format, image.width, image.height,
+                     image.alpha ? PixelDataFormat::kRgba
+                                 : PixelDataFormat::kRgb,
+                     PixelDataType::kUnsignedByte, image.pixels.data());
+    };
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+    job.upload_compressed = [&texture, target](GLenum format,
+                                               const CompressedLevels& levels) {
+      TemporaryBind bind(texture);
+      for (size_t level = 0; level < levels.size(); ++level) {
+        texture.compressedUploadMipmap(target, GLint(level), format,
+                                       levels[level].width,
+                                       levels[level].height,
+                                       levels[level].size,
+                                       levels[level].data);
+      }
+    };
+#endif
+    return enqueue(std::move(job));
+  }
+
+  /// Cancels a request. Its texture won't be changed, and its callback won't
+  /// be called.
+  /** Does nothing if the request was already uploaded. */
+  void cancel(Request request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.count(request)) {
+      cancelled_.insert(request);
+    }
+  }
+
+  /// Uploads the decoded images, until max_bytes is reached.
+  /** At least one image is uploaded (if there is one), even if it is larger
+    * than max_bytes. Must be called on the thread of the context.
+    * @return The number of the finished requests. */
+  size_t update(size_t max_bytes = std::numeric_limits<size_t>::max()) {
+    size_t finished = 0, bytes = 0;
+    while (true) {
+      Job job;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (decoded_.empty()) {
+          break;
+        }
+        job = std::move(decoded_.front());
+        decoded_.pop_front();
+        pending_.erase(job.id);
+        if (cancelled_.erase(job.id)) {
+          statistics_.cancelled++;
+          continue;
+        }
+      }
+      bytes += Bytes(job);
+      upload(&job);
+      finished++;
+      if (bytes >= max_bytes) {
+        break;
+      }
+    }
+    return finished;
+  }
+
+  /// Waits for every request, and uploads them.
+  /** Must be called on the thread of the context. */
+  void finish() {
+    while (true) {
+      update();
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_done_.wait(lock, [this] {
+        return !decoded_.empty() || (queue_.empty() && decoding_ == 0);
+      });
+      if (decoded_.empty()) {
+        return;
+      }
+    }
+  }
+
+  /// Returns the number of the requests, that aren't uploaded yet.
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + decoding_ + decoded_.size();
+  }
+
+  /// Counters since the creation of the loader.
+  struct Statistics {
+    size_t uploaded;    ///< The textures uploaded.
+    size_t failed;      ///< The files, that couldn't be decoded.
+    size_t cancelled;   ///< The requests dropped by cancel().
+    size_t bytes;       ///< The bytes of the uploaded images.
+    size_t cache_hits;  ///< The compressed images read from cache files.
+  };
+
+  /// Returns the counters.
+  Statistics statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+  }
+
+  /// Decodes the file with Magick++ if it is enabled, or a TGA file with
+  /// DecodeTga otherwise.
+  static bool DefaultDecoder(const std::string& file, bool alpha,
+                             Image* image) {
+#if OGLWRAP_USE_IMAGEMAGICK
+    try {
+      Magick::Image magick_image(file);
+      Magick::Blob blob;
+      magick_image.write(&blob, alpha ? "RGBA" : "RGB");
+      image->width = GLsizei(magick_image.columns());
+      image->height = GLsizei(magick_image.rows());
+      image->alpha = alpha;
+      const unsigned char* data =
+          static_cast<const unsigned char*>(blob.data());
+      image->pixels.assign(data, data + blob.length());
+      return true;
+    } catch (const Magick::Error& error) {
+      std::cerr << "Error loading texture: " << error.what() << std::endl;
+      return false;
+    }
+#else
+    return DecodeTga(file, alpha, image);
+#endif
+  }
+
+  /// Decodes an uncompressed or RLE compressed, true-color or grayscale
+  /// TGA file.
+  static bool DecodeTga(const std::string& file, bool alpha, Image* image) {
+    std::ifstream stream(file, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(stream)),
+                                    std::istreambuf_iterator<char>());
+    if (data.size() < 18 || data[1] != 0) {
+      std::cerr << "Error loading texture: " << file
+                << " is not a supported TGA file" << std::endl;
+      return false;
+    }
+    unsigned type = data[2];
+    unsigned bits = data[16];
+    bool rle = type == 10 || type == 11;
+    bool gray = type == 3 || type == 11;
+    unsigned src_channels = bits / 8;
+    if ((type != 2 && type != 3 && type != 10 && type != 11) ||
+        (gray ? bits != 8 : (bits != 24 && bits != 32)) ||
+        (data[12] | data[13]) == 0 || (data[14] | data[15]) == 0) {
+      std::cerr << "Error loading texture: " << file
+                << " is not a supported TGA file" << std::endl;
+      return false;
+    }
+
+    size_t width = data[12] | (data[13] << 8);
+    size_t height = data[14] | (data[15] << 8);
+    bool top_first = (data[17] & 0x20) != 0;
+    size_t pos = 18 + data[0];
+    // Checks the size against the file before allocating, as the header can
+    // claim up to 65535 x 65535 texels. An RLE packet is at least a header
+    // byte and a texel, and holds at most 128 texels.
+    size_t available = data.size() - std::min(pos, data.size());
+    size_t max_pixels = rle ? 128 * (available / (1 + src_channels))
+                            : available / src_channels;
+    if (width * height > max_pixels) {
+      std::cerr << "Error loading texture: " << file << " is truncated"
+                << std::endl;
+      return false;
+    }
+    unsigned channels = alpha ? 4 : 3;
+    image->width = GLsizei(width);
+    image->height = GLsizei(height);
+    image->alpha = alpha;
+    image->pixels.resize(width * height * channels);
+
+    // Reads the pixels in file order, and writes them with the first row at
+    // the top, converting BGR(A) or gray to RGB(A).
+    size_t pixel_count = width * height, pixel = 0;
+    while (pixel < pixel_count) {
+      size_t run = 1;
+      bool repeat = false;
+      if (rle) {
+        if (pos >= data.size()) {
+          break;
+        }
+        repeat = (data[pos] & 0x80) != 0;
+        run = (data[pos] & 0x7f) + 1u;
+        pos++;
+      }
+      for (size_t i = 0; i < run && pixel < pixel_count; ++i, ++pixel) {
+        if (pos + src_channels > data.size()) {
+          pixel = pixel_count + 1;
+          break;
+        }
+        const unsigned char* src = &data[pos];
+        if (!repeat || i == run - 1) {
+          pos += src_channels;
+        }
+        size_t row = pixel / width, column = pixel % width;
+        if (!top_first) {
+          row = height - 1 - row;
+        }
+        unsigned char* dst = &image->pixels[(row * width + column) * channels];
+        if (gray) {
+          dst[0] = dst[1] = dst[2] = src[0];
+        } else {
+          dst[0] = src[2];
+          dst[1] = src[1];
+          dst[2] = src[0];
+        }
+        if (alpha) {
+          dst[3] = src_channels == 4 ? src[3] : 255;
+        }
+      }
+    }
+    if (pixel != pixel_count) {
+      std::cerr << "Error loading texture: " << file << " is truncated"
+                << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  using Upload = std::function<void(const Image&, PixelDataInternalFormat)>;
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+  using CompressedLevels = std::vector<TextureContainer::Image>;
+  using CompressedUpload =
+      std::function<void(GLenum format, const CompressedLevels&)>;
+#endif
+
+  struct Job {
+    Request id;
+    int priority;
+    std::string file;
+    std::string format_string;
+    Upload upload;
+    Callback done;
+    bool success;
+    Image image;
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+    CompressedUpload upload_compressed;
+    std::unique_ptr<TextureContainer> cached;  // the cache file, if it had one
+    CompressedMipChain encoded;                // the image, if it was encoded
+#endif
+  };
+
+  // Higher priority first, then in the order of the requests.
+  struct JobOrder {
+    bool operator()(const Job& a, const Job& b) const {
+      return a.priority != b.priority ? a.priority < b.priority : a.id > b.id;
+    }
+  };
+
+  Decoder decoder_;
+  std::vector<std::thread> workers_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  std::priority_queue<Job, std::vector<Job>, JobOrder> queue_;
+  std::deque<Job> decoded_;
+  std::unordered_set<Request> pending_;  // queued, decoding or decoded
+  std::unordered_set<Request> cancelled_;
+  Request next_id_;
+  size_t decoding_;
+  bool stop_;
+  Statistics statistics_;
+
+  static Job MakeJob(const std::string& file,
+                     const std::string& format_string, int priority,
+                     Callback done) {
+    Job job;
+    job.priority = priority;
+    job.file = file;
+    job.format_string = format_string;
+    job.done = std::move(done);
+    job.success = false;
+    return job;
+  }
+
+  Request enqueue(Job job) {
+    Request id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      id = job.id = next_id_++;
+      pending_.insert(id);
+      queue_.push(std::move(job));
+    }
+    work_available_.notify_one();
+    return id;
+  }
+
+  void workerLoop() {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [this] {
+          return stop_ || !queue_.empty();
+        });
+        if (stop_) {
+          return;
+        }
+        // The priority_queue only gives const access to the top.
+        job = std::move(const_cast<Job&>(queue_.top()));
+        queue_.pop();
+        if (cancelled_.erase(job.id)) {
+          pending_.erase(job.id);
+          statistics_.cancelled++;
+          if (queue_.empty() && decoding_ == 0) {
+            work_done_.notify_all();
+          }
+          continue;
+        }
+        decoding_++;
+      }
+
+      bool alpha = job.format_string.find('A') != std::string::npos;
+      // An exception must not escape the thread, and the job must still be
+      // counted as finished, or finish() would wait for it forever.
+      try {
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+        if (job.format_string.find('C') != std::string::npos) {
+          job.success = compress(&job, alpha);
+        } else {
+          job.success = decoder_(job.file, alpha, &job.image);
+        }
+#else
+        job.success = decoder_(job.file, alpha, &job.image);
+#endif
+      } catch (const std::exception& error) {
+        std::cerr << "Error loading texture: " << job.file << ": "
+                  << error.what() << std::endl;
+        job.success = false;
+      } catch (...) {
+        std::cerr << "Error loading texture: " << job.file << std::endl;
+        job.success = false;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decoding_--;
+        decoded_.push_back(std::move(job));
+      }
+      work_done_.notify_all();
+    }
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+  // Reads the cache file of the image, or decodes, encodes and caches it, on
+  // a worker thread.
+  bool compress(Job* job, bool alpha) {
+    bool srgb = job->format_string.find('S') != std::string::npos;
+    CompressedMipChain::Format format = alpha ? CompressedMipChain::Format::kBc3
+                                              : CompressedMipChain::Format::kBc1;
+    MipChain::Options options;
+    options.srgb = srgb;
+    std::string cache_file = CompressedMipChain::CacheFile(job->file, format,
+                                                           srgb, options);
+    if (!cache_file.empty() && std::ifstream(cache_file).good()) {
+      try {
+        job->cached.reset(new TextureContainer(cache_file));
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics_.cache_hits++;
+        return true;
+      } catch (const std::runtime_error& error) {
+        std::cerr << "Ignoring texture cache: " << error.what() << std::endl;
+      }
+    }
+
+    if (!decoder_(job->file, alpha, &job->image)) {
+      return false;
+    }
+    if (job->image.width <= 0 || job->image.height <= 0) {
+      std::cerr << "Error loading texture: " << job->file << " is empty"
+                << std::endl;
+      return false;
+    }
+    MipChain mips = MipChain::Generate(job->image.pixels.data(),
+                                       job->image.width, job->image.height,
+                                       alpha ? 4 : 3, options);
+    job->encoded = CompressedMipChain::Encode(mips, format, srgb);
+    std::vector<unsigned char>().swap(job->image.pixels);
+    if (!cache_file.empty() && !job->encoded.write(cache_file)) {
+      std::cerr << "Can't write texture cache: " << cache_file << std::endl;
+    }
+    return true;
+  }
+#endif
+
+  // Returns the bytes, that the job uploads.
+  static size_t Bytes(const Job& job) {
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+    if (job.cached) {
+      size_t bytes = 0;
+      for (GLsizei level = 0; level < job.cached->levels(); ++level) {
+        bytes += job.cached->image(level).size;
+      }
+      return bytes;
+    }
+    if (job.encoded.levelCount() != 0) {
+      return job.encoded.levels().back().offset +
+             job.encoded.levels().back().size;
+    }
+#endif
+    return job.image.pixels.size();
+  }
+
+  // Uploads the compressed levels of the job, if it has them.
+  static bool UploadCompressed(const Job& job) {
+#if OGLWRAP_DEFINE_EVERYTHING || (defined(glCompressedTexImage2D) \
+    && defined(glCompressedTexSubImage2D) && defined(glTexStorage2D))
+    if (job.cached) {
+      CompressedLevels levels;
+      for (GLsizei level = 0; level < job.cached->levels(); ++level) {
+        levels.push_back(job.cached->image(level));
+      }
+      job.upload_compressed(job.cached->format(), levels);
+      return true;
+    }
+    if (job.encoded.levelCount() != 0) {
+      CompressedLevels levels;
+      for (GLsizei level = 0; level < job.encoded.levelCount(); ++level) {
+        const CompressedMipChain::Level& info = job.encoded.levels()[level];
+        levels.push_back(TextureContainer::Image{
+            job.encoded.data(level), GLsizei(info.size), info.width,
+            info.height});
+      }
+      job.upload_compressed(job.encoded.format(), levels);
+      return true;
+    }
+#endif
+    return false;
+  }
+
+  // Uploads a decoded image, on the thread of the context.
+  void upload(Job* job_pointer) {
+    Job& job = *job_pointer;
+    if (job.success && !UploadCompressed(job)) {
+      std::string format_string = job.format_string;
+      bool srgb = format_string.find('S') != std::string::npos;
+      bool compressed = format_string.find('C') != std::string::npos;
+      bool alpha = job.image.alpha;
+
+      using InternalFormat = PixelDataInternalFormat;
+      InternalFormat internal_format =
+        srgb ? (compressed ? (alpha ? InternalFormat::kCompressedSrgbAlpha
+                                    : InternalFormat::kCompressedSrgb)
+                           : (alpha ? InternalFormat::kSrgb8Alpha8
+                                    : InternalFormat::kSrgb8))
+             : (compressed ? (alpha ? InternalFormat::kCompressedRgba
+                                    : InternalFormat::kCompressedRgb)
+                           : (alpha ? InternalFormat::kRgba8
+                                    : InternalFormat::kRgb8));
+
+      bool bad_alignment = (job.image.width * (alpha ? 4 : 3)) % 4 != 0;
+      TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                           1, bad_alignment);
+      job.upload(job.image, internal_format);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (job.success) {
+        statistics_.uploaded++;
+        statistics_.bytes += Bytes(job);
+      } else {
+        statistics_.failed++;
+      }
+    }
+    if (job.done) {
+      job.done(job.success);
+    }
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_TEXTURE_LOADER_H_
@@ -0,0 +1,197 @@
+// Copyright (c) Tamas Csala
+
+/** @file texture_units.h
+    @brief Implements an allocator, that keeps textures resident on texture
+           units, and reuses the least recently used units.
+*/
+
+#ifndef OGLWRAP_TEXTURE_UNITS_H_
+#define OGLWRAP_TEXTURE_UNITS_H_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "./config.h"
+#include "./uniform.h"
+#include "./textures/texture_base.h"
+#include "context/binding.h"
+#include "context/state_cache.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief Remembers which texture is resident on which texture unit, and
+ *        assigns units to the textures by LRU.
+ *
+ * bind() returns the unit a texture is resident on, without any GL call, or
+ * binds it to the least recently used unit. bind() with a sampler uniform also
+ * sets the uniform, but only if its value changes.
+ * @code
+ *   gl::TextureUnits units(8);
+ *   ...
+ *   gl::Use(program);
+ *   units.bind(material.diffuse, diffuse_sampler);
+ *   units.bind(material.normal_map, normal_sampler);
+ *   gl::DrawElements(...);
+ * @endcode
+ * The units managed by the allocator shouldn't be changed by other code.
+ * A draw can use at most as many textures as there are units, as more would
+ * evict the ones bound earlier for the same draw.
+ *
+ * While a StateCache is current, a resident texture is checked against it,
+ * so deleting a texture (or StateCache::resync()) is noticed. Without a cache,
+ * call forget() before deleting a texture, that might be resident.
+ */
+class TextureUnits {
+ public:
+  /// Manages the units [first_unit, first_unit + count).
+  /** count has to be at least 1. */
+  explicit TextureUnits(GLuint count, GLuint first_unit = 0)
+      : units_(count), first_unit_(first_unit), clock_(0)
+      , statistics_{0, 0, 0, 0} {
+    assert(count > 0);
+  }
+
+  /// Returns the unit, that the texture is resident on, binding it to the
+  /// least recently used unit if it isn't resident yet.
+  template <TextureType texture_t>
+  GLuint bind(const TextureBase<texture_t>& tex) {
+    GLuint name = tex.expose();
+    GLuint unit = find(GLenum(texture_t), name);
+    if (unit != kNotResident) {
+      if (stillBound(unit)) {
+        units_[unit].last_use = ++clock_;
+        statistics_.hits++;
+        return first_unit_ + unit;
+      }
+      units_[unit] = Unit();
+    }
+
+    unit = leastRecentlyUsed();
+    if (units_[unit].name != 0) {
+      statistics_.evictions++;
+    }
+    BindToTexUnit(tex, first_unit_ + unit);
+    units_[unit].target = GLenum(texture_t);
+    units_[unit].binding = GLenum(GetBindingTarget(texture_t));
+    units_[unit].name = name;
+    units_[unit].last_use = ++clock_;
+    statistics_.binds++;
+    return first_unit_ + unit;
+  }
+
+  /// Binds the texture to a unit, and sets the sampler uniform to that unit
+  /// if it isn't set to it already.
+  /** The program of the uniform has to be in use. */
+  template <TextureType texture_t>
+  GLuint bind(const TextureBase<texture_t>& tex,
+              UniformObject<GLint>& sampler) {
+    GLuint unit = bind(tex);
+    auto value = samplers_.find(&sampler);
+    if (value == samplers_.end() || value->second != GLint(unit)) {
+      sampler.set(GLint(unit));
+      samplers_[&sampler] = GLint(unit);
+    } else {
+      statistics_.skipped_uniforms++;
+    }
+    return unit;
+  }
+
+  /// Returns if the texture is resident on one of the units.
+  template <TextureType texture_t>
+  bool isResident(const TextureBase<texture_t>& tex) const {
+    return find(GLenum(texture_t), tex.expose())
+        != kNotResident;
+  }
+
+  /// Forgets a texture, for ex. before it is deleted.
+  template <TextureType texture_t>
+  void forget(const TextureBase<texture_t>& tex) {
+    GLuint unit = find(GLenum(texture_t), tex.expose());
+    if (unit != kNotResident) {
+      units_[unit] = Unit();
+    }
+  }
+
+  /// Forgets every resident texture and sampler value.
+  /** Call it after other code changed the bindings of the units, after a
+    * program that had its samplers set by bind() was relinked, or after a
+    * sampler uniform was destroyed. */
+  void forgetAll() {
+    for (Unit& unit : units_) {
+      unit = Unit();
+    }
+    samplers_.clear();
+  }
+
+  /// Returns the number of managed units.
+  GLuint size() const { return GLuint(units_.size()); }
+
+  /// Counters of the bind() calls.
+  struct Statistics {
+    size_t hits;              ///< The textures, that were already resident.
+    size_t binds;             ///< The textures, that had to be bound.
+    size_t evictions;         ///< The binds, that replaced a resident texture.
+    size_t skipped_uniforms;  ///< The sampler uniforms, that were already set.
+  };
+
+  /// Returns the counters since the creation of the allocator.
+  const Statistics& statistics() const { return statistics_; }
+
+ private:
+  struct Unit {
+    GLenum target, binding;
+    GLuint name;  // 0 if the unit is free
+    uint64_t last_use;
+
+    Unit() : target(0), binding(0), name(0), last_use(0) {}
+  };
+
+  static constexpr GLuint kNotResident = ~GLuint(0);
+
+  // There are only a few units, a linear search is faster than a hash map.
+  std::vector<Unit> units_;
+  std::unordered_map<const UniformObject<GLint>*, GLint> samplers_;
+  GLuint first_unit_;
+  uint64_t clock_;
+  Statistics statistics_;
+
+  GLuint find(GLenum target, GLuint name) const {
+    for (GLuint i = 0; i < units_.size(); ++i) {
+      if (units_[i].name == name && units_[i].target == target) {
+        return i;
+      }
+    }
+    return kNotResident;
+  }
+
+  bool stillBound(GLuint unit) const {
+    StateCache* cache = StateCache::Current();
+    if (!cache) {
+      return true;
+    }
+    CachedState<StateCache::Binding>& bound =
+        cache->textureBinding(units_[unit].binding, first_unit_ + unit);
+    return bound.known() && bound.value().name == units_[unit].name;
+  }
+
+  GLuint leastRecentlyUsed() const {
+    GLuint result = 0;
+    for (GLuint i = 1; i < units_.size(); ++i) {
+      if (units_[i].last_use < units_[result].last_use) {
+        result = i;
+      }
+    }
+    return result;
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_TEXTURE_UNITS_H_
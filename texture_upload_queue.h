@@ -0,0 +1,325 @@
+// Copyright (c) Tamas Csala
+
+/** @file texture_upload_queue.h
+    @brief Implements asynchronous texture uploads through a ring of pixel
+           unpack buffers.
+*/
+
+#ifndef OGLWRAP_TEXTURE_UPLOAD_QUEUE_H_
+#define OGLWRAP_TEXTURE_UPLOAD_QUEUE_H_
+
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "textures/texture_2D.h"
+#include "textures/texture_3D.h"
+#include "textures/texture_cube.h"
+#include "context/binding.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glBufferStorage) && defined(glMapBufferRange) \
+        && defined(glFenceSync) && defined(glClientWaitSync) \
+        && defined(GL_PIXEL_UNPACK_BUFFER) && defined(GL_MAP_PERSISTENT_BIT))
+/**
+ * @brief Uploads texture data from a ring of persistently mapped
+ *        PixelUnpackBuffers, so the driver doesn't copy client memory on the
+ *        render thread.
+ *
+ * Every frame has its own buffer of budget_per_frame bytes. Any thread can
+ * allocate() a slice of the buffer of the current frame, write (memcpy or
+ * decode) the texels into it, and record a subUpload() from it. endFrame(),
+ * on the thread of the context, issues the recorded uploads from the buffer
+ * offsets, and fences the buffers for reuse.
+ * @code
+ *   gl::TextureUploadQueue uploads(16 * 1024 * 1024);
+ *
+ *   // on a worker thread
+ *   gl::TextureUploadQueue::Slice slice = uploads.allocate(size);
+ *   if (slice.data) {
+ *     decode(file, slice.data);
+ *     uploads.subUpload(slice, texture, 0, 0, 0, width, height,
+ *                       gl::PixelDataFormat::kRgba,
+ *                       gl::PixelDataType::kUnsignedByte);
+ *   } else {
+ *     // retry in a later frame
+ *   }
+ *
+ *   // on the render thread, every frame
+ *   uploads.endFrame();
+ * @endcode
+ * The budget bounds the bytes uploaded per frame, and so the hitching caused
+ * by the uploads. Allocations, that don't fit into the rest of the budget
+ * fail, and have to be retried in a later frame. An image larger than the
+ * budget never fits, and should be uploaded directly.
+ *
+ * A slice must be either recorded with a subUpload(), or discard()-ed. The
+ * buffer of a frame isn't reused while it has a slice, that is neither. The
+ * textures have to outlive the endFrame() that uploads to them, and have to
+ * have their storage allocated before the upload is recorded. The rows of the
+ * texels have to follow the unpack alignment (4 bytes by default).
+ *
+ * Requires OpenGL 4.4 (or ARB_buffer_storage). endFrame() leaves the
+ * PixelUnpackBuffer binding at 0, and restores the texture bindings.
+ */
+class TextureUploadQueue {
+ public:
+  /// A part of a buffer, that the texels of an upload are written into.
+  struct Slice {
+    void* data;     ///< The mapped memory, or nullptr if there was no room.
+    size_t size;    ///< The size of the slice in bytes.
+    size_t buffer;  ///< The index of the buffer in the ring.
+    size_t offset;  ///< The offset of the slice in its buffer.
+  };
+
+  /// Creates and maps the buffers.
+  /** @param budget_per_frame  The maximum bytes uploaded in a frame.
+    * @param frame_count       The number of frames the GPU can lag behind
+    *                          the CPU without making it wait (at least 1). */
+  explicit TextureUploadQueue(size_t budget_per_frame, size_t frame_count = 3)
+      : regions_(std::max<size_t>(frame_count, 1)), budget_(budget_per_frame), current_(0),
+        accepting_(true), statistics_{0, 0, 0, 0} {
+    for (Region& region : regions_) {
+      Bind(region.buffer);
+      gl(BufferStorage(GL_PIXEL_UNPACK_BUFFER, budget_, nullptr,
+                       GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                       GL_MAP_COHERENT_BIT));
+      void* data = gl(MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, budget_,
+                                     GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                     GL_MAP_COHERENT_BIT));
+      region.data = static_cast<unsigned char*>(data);
+    }
+    Unbind(BufferType::kPixelUnpackBuffer);
+  }
+
+  ~TextureUploadQueue() {
+    for (Region& region : regions_) {
+      if (region.fence) {
+        gl(DeleteSync(region.fence));
+      }
+      Bind(region.buffer);
+      gl(UnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+    }
+    Unbind(BufferType::kPixelUnpackBuffer);
+  }
+
+  TextureUploadQueue(const TextureUploadQueue&) = delete;
+  TextureUploadQueue& operator=(const TextureUploadQueue&) = delete;
+
+  /// Allocates a slice of the current frame's buffer. Can be called from any
+  /// thread.
+  /** @return The slice, with nullptr data if the budget of the frame doesn't
+    *         have enough space left. */
+  Slice allocate(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Region& region = regions_[current_];
+    // Keeps the offsets aligned for every pixel data type.
+    size_t offset = (region.used + kAlignment - 1) & ~(kAlignment - 1);
+    if (!accepting_ || size == 0 || offset + size > budget_) {
+      statistics_.rejected++;
+      return Slice{nullptr, 0, current_, 0};
+    }
+    region.used = offset + size;
+    region.outstanding++;
+    return Slice{region.data + offset, size, current_, offset};
+  }
+
+  /// Gives back a slice, that won't be uploaded. Can be called from any
+  /// thread.
+  void discard(const Slice& slice) {
+    if (slice.data) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      regions_[slice.buffer].outstanding--;
+    }
+  }
+
+  /// Records a subUploadMipmap() of the texture from the slice. Can be called
+  /// from any thread.
+  template <Texture2DType texture_t>
+  void subUpload(const Slice& slice, Texture2DBase<texture_t>& texture,
+                 GLint level, GLint x_offset, GLint y_offset,
+                 GLsizei width, GLsizei height, PixelDataFormat format,
+                 PixelDataType type) {
+    record(slice, [=, &texture](const void* offset) {
+      TemporaryBind bind(texture);
+      texture.subUploadMipmap(level, x_offset, y_offset, width, height,
+                              format, type, offset);
+    });
+  }
+
+  /// Records a subUploadMipmap() of the texture from the slice. Can be called
+  /// from any thread.
+  template <Texture3DType texture_t>
+  void subUpload(const Slice& slice, Texture3DBase<texture_t>& texture,
+                 GLint level, GLint x_offset, GLint y_offset, GLint z_offset,
+                 GLsizei width, GLsizei height, GLsizei depth,
+                 PixelDataFormat format, PixelDataType type) {
+    record(slice, [=, &texture](const void* offset) {
+      TemporaryBind bind(texture);
+      texture.subUploadMipmap(level, x_offset, y_offset, z_offset, width,
+                              height, depth, format, type, offset);
+    });
+  }
+
+  /// Records a subUploadMipmap() of a face of the cube map from the slice.
+  /// Can be called from any thread.
+  void subUpload(const Slice& slice, TextureCube& texture,
+                 TextureCubeTarget target, GLint level, GLint x_offset,
+                 GLint y_offset, GLsizei width, GLsizei height,
+                 PixelDataFormat format, PixelDataType type) {
+    record(slice, [=, &texture](const void* offset) {
+      TemporaryBind bind(texture);
+      texture.subUploadMipmap(target, level, x_offset, y_offset, width, height,
+                              format, type, offset);
+    });
+  }
+
+  /// Issues the recorded uploads, and moves to the buffer of the next frame.
+  /** Must be called on the thread of the context. It might wait for the GPU
+    * if it is more than frame_count frames behind. */
+  void endFrame() {
+    std::vector<Upload> uploads;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      uploads.swap(uploads_);
+    }
+
+    size_t upload_bytes = 0;
+    for (size_t i = 0; i < regions_.size(); ++i) {
+      bool used = false;
+      for (const Upload& upload : uploads) {
+        if (upload.buffer != i) {
+          continue;
+        }
+        if (!used) {
+          Bind(regions_[i].buffer);
+          used = true;
+        }
+        upload.function(reinterpret_cast<const void*>(upload.offset));
+        upload_bytes += upload.size;
+      }
+      if (used) {
+        GLsync& fence = regions_[i].fence;
+        if (fence) {
+          gl(DeleteSync(fence));
+        }
+        fence = gl(FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+      }
+    }
+    if (!uploads.empty()) {
+      Unbind(BufferType::kPixelUnpackBuffer);
+    }
+
+    // The counters are read by statistics() from any thread.
+    size_t upload_count = uploads.size();
+    // Recycles the capacity of the vector between the frames.
+    uploads.clear();
+    GLsync fence;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      statistics_.uploads += upload_count;
+      statistics_.bytes += upload_bytes;
+      if (uploads_.empty()) {
+        uploads_.swap(uploads);
+      }
+      current_ = (current_ + 1) % regions_.size();
+      // A slice, that is still being written, blocks the reuse of its buffer,
+      // so nothing can be uploaded in this frame.
+      accepting_ = false;
+      if (regions_[current_].outstanding != 0) {
+        statistics_.blocked_frames++;
+        return;
+      }
+      fence = regions_[current_].fence;
+      regions_[current_].fence = nullptr;
+    }
+
+    // The workers can't allocate from the buffer until accepting_ is set, so
+    // the lock isn't held while waiting.
+    if (fence) {
+      GLenum result;
+      do {
+        result = gl(ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   kWaitTimeout));
+      } while (result == GL_TIMEOUT_EXPIRED);
+      gl(DeleteSync(fence));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    regions_[current_].used = 0;
+    accepting_ = true;
+  }
+
+  /// Returns the maximum bytes uploaded in a frame.
+  size_t budget() const { return budget_; }
+
+  /// Counters since the creation of the queue.
+  struct Statistics {
+    size_t uploads;         ///< The uploads issued.
+    size_t bytes;           ///< The bytes of the issued uploads.
+    size_t rejected;        ///< The allocations, that didn't fit.
+    size_t blocked_frames;  ///< The frames, whose buffer had a slice in use.
+  };
+
+  /// Returns the counters.
+  Statistics statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+  }
+
+ private:
+  static constexpr GLuint64 kWaitTimeout = 1000000;  // 1 ms, in ns.
+  static constexpr size_t kAlignment = 16;
+
+  struct Region {
+    PixelUnpackBuffer buffer;
+    unsigned char* data;
+    size_t used;
+    size_t outstanding;  // slices neither recorded nor discarded
+    GLsync fence;
+
+    Region() : data(nullptr), used(0), outstanding(0), fence(nullptr) {}
+  };
+
+  struct Upload {
+    std::function<void(const void*)> function;
+    size_t buffer;
+    size_t offset;
+    size_t size;
+  };
+
+  std::vector<Region> regions_;
+  std::vector<Upload> uploads_;
+  mutable std::mutex mutex_;
+  size_t budget_;
+  size_t current_;
+  bool accepting_;
+  Statistics statistics_;
+
+  void record(const Slice& slice, std::function<void(const void*)> function) {
+    if (!slice.data) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploads_.push_back(Upload{std::move(function), slice.buffer, slice.offset,
+                              slice.size});
+    regions_[slice.buffer].outstanding--;
+  }
+};
+#endif  // glBufferStorage && glMapBufferRange && glFenceSync
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_TEXTURE_UPLOAD_QUEUE_H_
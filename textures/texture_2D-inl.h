@@ -5,6 +5,7 @@
 
 #include "./texture_2D.h"
 #include "../context/binding.h"
+#include "../context/pixel_ops.h"
 
 #include "../define_internal_macros.h"
 
@@ -47,6 +48,28 @@ void Texture2DBase<texture_t>::subUploadMipmap(
                    width, height, GLenum(format), GLenum(type), data));
 }
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexImage2D)
+template<Texture2DType texture_t>
+void Texture2DBase<texture_t>::compressedUploadMipmap(
+    GLint level, GLenum internal_format, GLsizei width, GLsizei height,
+    GLsizei image_size, const void *data) {
+  OGLWRAP_CHECK_BINDING();
+  gl(CompressedTexImage2D(GLenum(texture_t), level, internal_format, width,
+                          height, 0, image_size, data));
+}
+#endif  // glCompressedTexImage2D
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage2D)
+template<Texture2DType texture_t>
+void Texture2DBase<texture_t>::compressedSubUploadMipmap(
+    GLint level, GLint x_offset, GLint y_offset, GLsizei width, GLsizei height,
+    GLenum format, GLsizei image_size, const void *data) {
+  OGLWRAP_CHECK_BINDING();
+  gl(CompressedTexSubImage2D(GLenum(texture_t), level, x_offset, y_offset,
+                             width, height, format, image_size, data));
+}
+#endif  // glCompressedTexSubImage2D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glTexStorage2D)
 template<Texture2DType texture_t>
 void Texture2DBase<texture_t>::storage(GLsizei levels, GLenum internal_format,
@@ -152,20 +175,12 @@ void Texture2DBase<texture_t>::loadTexture(const std::string& file,
                                   : InternalFormat::kRgb8));
 
     bool bad_alignment = (image.columns() * format_string.length()) % 4 != 0;
-    GLint unpack_aligment;
-
-    if (bad_alignment) {
-      gl(GetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_aligment));
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    }
+    TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                         1, bad_alignment);
 
     upload(internal_format, image.columns(), image.rows(),
            alpha ? PixelDataFormat::kRgba : PixelDataFormat::kRgb,
            PixelDataType::kUnsignedByte, blob.data());
-
-    if (bad_alignment) {
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, unpack_aligment));
-    }
   } catch (const Magick::Error& error) {
     std::cerr << "Error loading texture: " << error.what() << std::endl;
   }
@@ -67,6 +67,33 @@ class Texture2DBase : public TextureBase<TextureType(texture_t)> {
                        GLsizei height, PixelDataFormat format,
                        PixelDataType type, const void *data);
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexImage2D)
+  /// Uploads a mipmap of the image in a compressed format.
+  /** @param level - Specifies the level-of-detail number. Level 0 is the base image level. Level n is the nth mipmap reduction image.
+    * @param internal_format - Specifies the compressed internal format of the data.
+    * @param width, height - Specifies the width/height of the texture image.
+    * @param image_size - Specifies the number of bytes of the data.
+    * @param data - Specifies a pointer to the compressed image data in memory.
+    * @see glCompressedTexImage2D */
+  void compressedUploadMipmap(GLint level, GLenum internal_format,
+                              GLsizei width, GLsizei height,
+                              GLsizei image_size, const void *data);
+#endif  // glCompressedTexImage2D
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage2D)
+  /// Updates a part of a mipmap image with compressed data.
+  /** @param level - Specifies the level-of-detail number. Level 0 is the base image level. Level n is the nth mipmap reduction image.
+    * @param x_offset, y_offset - Specifies a texel offset in the x/y direction within the texture array.
+    * @param width, height - Specifies the width/height of the texture subimage.
+    * @param format - Specifies the compressed internal format of the data.
+    * @param image_size - Specifies the number of bytes of the data.
+    * @param data - Specifies a pointer to the compressed image data in memory.
+    * @see glCompressedTexSubImage2D */
+  void compressedSubUploadMipmap(GLint level, GLint x_offset, GLint y_offset,
+                                 GLsizei width, GLsizei height, GLenum format,
+                                 GLsizei image_size, const void *data);
+#endif  // glCompressedTexSubImage2D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glTexStorage2D)
   /// Simultaneously specify storage for all levels of a two-dimensional or one-dimensional array texture
   /** @param levels - Specify the number of texture levels.
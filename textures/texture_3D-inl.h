@@ -5,6 +5,7 @@
 
 #include "./texture_3D.h"
 #include "../context/binding.h"
+#include "../context/pixel_ops.h"
 
 #include "../define_internal_macros.h"
 
@@ -57,6 +58,19 @@ void Texture3DBase<texture_t>::subUploadMipmap(
 }
 #endif  // glTexSubImage3D
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage3D)
+template<Texture3DType texture_t>
+void Texture3DBase<texture_t>::compressedSubUploadMipmap(
+    GLint level, GLint x_offset, GLint y_offset, GLint z_offset, GLsizei width,
+    GLsizei height, GLsizei depth, GLenum format, GLsizei image_size,
+    const void *data) {
+  OGLWRAP_CHECK_BINDING();
+  gl(CompressedTexSubImage3D(GLenum(texture_t), level, x_offset, y_offset,
+                             z_offset, width, height, depth, format,
+                             image_size, data));
+}
+#endif  // glCompressedTexSubImage3D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glCopyTexSubImage3D)
 template<Texture3DType texture_t>
 void Texture3DBase<texture_t>::copySub(GLint x_offset, GLint y_offset,
@@ -177,21 +191,13 @@ void Texture3DBase<texture_t>::loadTextures(IterT files_begin, IterT files_end,
 
     // check if image is badly aligned to GL_UNPACK_ALIGNMENT
     bool bad_alignment = (w * num_componenets) % 4 != 0;
-    GLint unpack_aligment;
-
-    if (bad_alignment) {
-      gl(GetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_aligment));
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    }
+    TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                         1, bad_alignment);
 
     // upload the first image
     uploadMipmap(level, internal_format, w, h, layers_num,
                  alpha ? PixelDataFormat::kRgba : PixelDataFormat::kRgb,
                  PixelDataType::kUnsignedByte, blob.get());
-
-    if (bad_alignment) {
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, unpack_aligment));
-    }
   } catch (const Magick::Error& error) {
     std::cerr << "Error loading texture: " << error.what() << std::endl;
   }
@@ -77,6 +77,21 @@ class Texture3DBase : public TextureBase<TextureType(texture_t)> {
                        const void *data);
 #endif  // glTexSubImage3D
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage3D)
+  /// Updates a part of a mipmap image with compressed data.
+  /** @param level - Specifies the level-of-detail number. Level 0 is the base image level. Level n is the nth mipmap reduction image.
+    * @param x_offset/y_offset/z_offset - Specifies a texel offset in the x/y/z direction within the texture array.
+    * @param width/height/depth - Specifies the width/height/depth of the texture subimage.
+    * @param format - Specifies the compressed internal format of the data.
+    * @param image_size - Specifies the number of bytes of the data.
+    * @param data - Specifies a pointer to the compressed image data in memory.
+    * @see glCompressedTexSubImage3D */
+  void compressedSubUploadMipmap(GLint level, GLint x_offset, GLint y_offset,
+                                 GLint z_offset, GLsizei width, GLsizei height,
+                                 GLsizei depth, GLenum format,
+                                 GLsizei image_size, const void *data);
+#endif  // glCompressedTexSubImage3D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glCopyTexSubImage3D)
   /// Copies pixels from the current GL_READ_BUFFER and updates part of the base mipmap of this texture with them.
   /** @param x_offset/y_offset/z_offset - Specifies the texel offset in the x/y/z direction within the destination texture array.
@@ -6,6 +6,7 @@
 #include <string>
 #include "./texture_cube.h"
 #include "../context/binding.h"
+#include "../context/pixel_ops.h"
 
 #include "../define_internal_macros.h"
 
@@ -53,7 +54,42 @@ inline void TextureCube::subUploadMipmap(TextureCubeTarget target, GLint level,
                    height, GLenum(format), GLenum(type), data));
 }
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexImage2D)
+inline void TextureCube::compressedUploadMipmap(TextureCubeTarget target,
+                                                GLint level,
+                                                GLenum internal_format,
+                                                GLsizei width, GLsizei height,
+                                                GLsizei image_size,
+                                                const void *data) {
+  OGLWRAP_CHECK_BINDING();
+  gl(CompressedTexImage2D(GLenum(target), level, internal_format, width,
+                          height, 0, image_size, data));
+}
+#endif  // glCompressedTexImage2D
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage2D)
+inline void TextureCube::compressedSubUploadMipmap(TextureCubeTarget target,
+                                                   GLint level, GLint x_offset,
+                                                   GLint y_offset,
+                                                   GLsizei width,
+                                                   GLsizei height,
+                                                   GLenum format,
+                                                   GLsizei image_size,
+                                                   const void *data) {
+  OGLWRAP_CHECK_BINDING();
+  gl(CompressedTexSubImage2D(GLenum(target), level, x_offset, y_offset, width,
+                             height, format, image_size, data));
+}
+#endif  // glCompressedTexSubImage2D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glTexStorage2D)
+inline void TextureCube::storage(GLsizei levels, GLenum internal_format,
+                                 GLsizei width, GLsizei height) {
+  OGLWRAP_CHECK_BINDING();
+  gl(TexStorage2D(GL_TEXTURE_CUBE_MAP, levels, internal_format, width,
+                  height));
+}
+
 inline void TextureCube::storage(TextureCubeTarget target, GLsizei levels,
                                  GLenum internal_format, GLsizei width,
                                  GLsizei height) {
@@ -166,20 +202,12 @@ inline void TextureCube::loadTexture(TextureCubeTarget target,
                                   : InternalFormat::kRgb8));
 
     bool bad_alignment = (image.columns() * format_string.length()) % 4 != 0;
-    GLint unpack_aligment;
-
-    if (bad_alignment) {
-      gl(GetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_aligment));
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    }
+    TemporaryPixelStore unpack_alignment(PixelStorageMode::kUnpackAlignment,
+                                         1, bad_alignment);
 
     upload(target, internal_format, image.columns(), image.rows(),
            alpha ? PixelDataFormat::kRgba : PixelDataFormat::kRgb,
            PixelDataType::kUnsignedByte, blob.data());
-
-    if (bad_alignment) {
-      gl(PixelStorei(GL_UNPACK_ALIGNMENT, unpack_aligment));
-    }
   } catch (const Magick::Error& error) {
     std::cerr << "Error loading texture: " << error.what() << std::endl;
   }
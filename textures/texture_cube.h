@@ -73,7 +73,46 @@ class TextureCube : public TextureBase<TextureType::kTextureCubeMap> {
                        PixelDataFormat format, PixelDataType type,
                        const void *data);
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexImage2D)
+  /// Uploads a mipmap image for one side of the cube in a compressed format.
+  /** @param target - Specifies which one of the six sides of the cube to use as target.
+    * @param level - Specifies the level-of-detail number. Level 0 is the base image level. Level n is the nth mipmap reduction image.
+    * @param internal_format - Specifies the compressed internal format of the data.
+    * @param width/height - Specifies the width/height of the texture image.
+    * @param image_size - Specifies the number of bytes of the data.
+    * @param data - Specifies a pointer to the compressed image data in memory.
+    * @see glCompressedTexImage2D */
+  void compressedUploadMipmap(TextureCubeTarget target, GLint level,
+                              GLenum internal_format, GLsizei width,
+                              GLsizei height, GLsizei image_size,
+                              const void *data);
+#endif  // glCompressedTexImage2D
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glCompressedTexSubImage2D)
+  /// Updates a part of a mipmap image for one side of the cube with compressed data.
+  /** @param target - Specifies which one of the six sides of the cube to use as target.
+    * @param level - Specifies the level-of-detail number. Level 0 is the base image level. Level n is the nth mipmap reduction image.
+    * @param x_offset/y_offset - Specifies a texel offset in the x/y direction within the texture array.
+    * @param width/height - Specifies the width/height of the texture subimage.
+    * @param format - Specifies the compressed internal format of the data.
+    * @param image_size - Specifies the number of bytes of the data.
+    * @param data - Specifies a pointer to the compressed image data in memory.
+    * @see glCompressedTexSubImage2D */
+  void compressedSubUploadMipmap(TextureCubeTarget target, GLint level,
+                                 GLint x_offset, GLint y_offset, GLsizei width,
+                                 GLsizei height, GLenum format,
+                                 GLsizei image_size, const void *data);
+#endif  // glCompressedTexSubImage2D
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glTexStorage2D)
+  /// Simultaneously specify storage for all levels of every side of the cube
+  /** @param levels - Specify the number of texture levels.
+    * @param internal_format - Specifies the sized internal format to be used to store texture image data.
+    * @param width - Specifies the width of the texture, in texels.
+    * @param height - Specifies the height of the texture, in texels. */
+  void storage(GLsizei levels, GLenum internal_format, GLsizei width,
+               GLsizei height);
+
   /// Simultaneously specify storage for all levels of a two-dimensional or one-dimensional array texture
   /** @param target - Specifies which one of the six sides of the cube to use as target.
     * @param levels - Specify the number of texture levels.
@@ -0,0 +1,155 @@
+// Copyright (c) Tamas Csala
+
+/** @file thread_pool.h
+    @brief Implements a simple thread pool for data parallel CPU side work.
+*/
+
+#ifndef OGLWRAP_THREAD_POOL_H_
+#define OGLWRAP_THREAD_POOL_H_
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "./config.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/**
+ * @brief A fixed set of worker threads, that execute the iterations of a
+ *        parallel loop.
+ *
+ * The calling thread takes part in the work too, so a pool of size N uses
+ * N - 1 worker threads. The iterations are handed out dynamically, so uneven
+ * work is balanced between the threads.
+ * @code
+ *   gl::ThreadPool pool;
+ *   pool.run(chunk_count, [&](size_t chunk) { process(chunk); });
+ * @endcode
+ * The worker threads never make OpenGL calls, the tasks must not either,
+ * unless they have a context of their own. run() must not be called from
+ * multiple threads at the same time, nor from inside a task. The tasks must
+ * not throw.
+ */
+class ThreadPool {
+ public:
+  /// Starts the worker threads.
+  /** @param thread_count  The number of threads, including the calling one.
+    *                      0 means one per hardware thread. */
+  explicit ThreadPool(size_t thread_count = 0)
+      : task_(nullptr), task_count_(0), next_(0), busy_(0), generation_(0),
+        stop_(false) {
+    if (thread_count == 0) {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 1; i < thread_count; ++i) {
+      workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+  }
+
+  /// Stops and joins the worker threads.
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Returns the number of threads, that execute the tasks.
+  size_t size() const { return workers_.size() + 1; }
+
+  /// Calls task(i) for every i in [0, count), and waits for all of them.
+  void run(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+      return;
+    }
+    if (workers_.empty() || count == 1) {
+      for (size_t i = 0; i < count; ++i) {
+        task(i);
+      }
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      task_count_ = count;
+      next_ = 0;
+      busy_ = workers_.size();
+      ++generation_;
+    }
+    work_available_.notify_all();
+
+    execute(task, count);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return busy_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+
+  const std::function<void(size_t)>* task_;
+  size_t task_count_;
+  std::atomic<size_t> next_;
+  size_t busy_;
+  size_t generation_;
+  bool stop_;
+
+  void execute(const std::function<void(size_t)>& task, size_t count) {
+    for (size_t i = next_++; i < count; i = next_++) {
+      task(i);
+    }
+  }
+
+  void workerLoop() {
+    size_t seen_generation = 0;
+    while (true) {
+      const std::function<void(size_t)>* task;
+      size_t count;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [&] {
+          return stop_ || generation_ != seen_generation;
+        });
+        if (stop_) {
+          return;
+        }
+        seen_generation = generation_;
+        task = task_;
+        count = task_count_;
+      }
+
+      execute(*task, count);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_ == 0) {
+        work_done_.notify_one();
+      }
+    }
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_THREAD_POOL_H_
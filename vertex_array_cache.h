@@ -0,0 +1,198 @@
+// Copyright (c) Tamas Csala
+
+/** @file vertex_array_cache.h
+    @brief Implements a cache of pre-configured vertex arrays.
+*/
+
+#ifndef OGLWRAP_VERTEX_ARRAY_CACHE_H_
+#define OGLWRAP_VERTEX_ARRAY_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "./config.h"
+#include "./buffer.h"
+#include "./vertex_array.h"
+#include "./vertex_format.h"
+#include "context/binding.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glGenVertexArrays) && defined(glBindVertexArray) \
+        && defined(glBindBuffer))
+/**
+ * @brief Shares vertex arrays between the meshes (and programs) that would
+ *        set them up the same way.
+ *
+ * A VAO is identified by the vertex format (including the attribute
+ * locations), the array buffer and its offset, and the index buffer. The first
+ * request for a combination creates and sets up the VAO, the later ones just
+ * return the same object. When the cache is full, the least recently used
+ * entry is dropped. The returned VAOs are reference counted, so dropping an
+ * entry never deletes a VAO that is still in use.
+ *
+ * Buffer handles are reused by OpenGL after a buffer is deleted, so call
+ * invalidate() for a buffer before deleting it.
+ * @code
+ *   gl::VertexArrayCache cache;
+ *   std::shared_ptr<gl::VertexArray> vao = cache.get(format, vbo, &ibo);
+ *   gl::Bind(*vao);
+ * @endcode
+ */
+class VertexArrayCache {
+ public:
+  /// The counters of the cache.
+  struct Statistics {
+    size_t hits;       ///< Requests served by an existing VAO.
+    size_t misses;     ///< Requests that had to set up a new VAO.
+    size_t evictions;  ///< Entries dropped because the cache was full.
+  };
+
+  /// Creates a cache that holds at most capacity VAOs.
+  explicit VertexArrayCache(size_t capacity = 1024)
+      : capacity_(capacity), statistics_{0, 0, 0} {}
+
+  /**
+   * @brief Returns a VAO set up with the given format and buffers.
+   *
+   * Creating a new VAO changes the VertexArray and ArrayBuffer bindings.
+   * @param format       The format of the vertices in the array buffer.
+   * @param vertices     The buffer that holds the vertices.
+   * @param indices      The index buffer, or nullptr if it's not used.
+   * @param base_offset  The offset of the first vertex in the buffer in bytes.
+   */
+  std::shared_ptr<VertexArray> get(const VertexFormat& format,
+                                   const ArrayBuffer& vertices,
+                                   const IndexBuffer* indices = nullptr,
+                                   GLintptr base_offset = 0) {
+    Key key{format, vertices.expose(), base_offset,
+            indices ? GLuint(indices->expose()) : 0};
+
+    auto iter = entries_.find(key);
+    if (iter != entries_.end()) {
+      statistics_.hits++;
+      // Move the entry to the front of the LRU list.
+      lru_.splice(lru_.begin(), lru_, iter->second.lru_position);
+      return iter->second.vao;
+    }
+
+    statistics_.misses++;
+    std::shared_ptr<VertexArray> vao = std::make_shared<VertexArray>();
+    Bind(*vao);
+    Bind(vertices);
+    format.setup(base_offset);
+    if (indices) {
+      Bind(*indices);
+    }
+    Unbind(*vao);
+    Unbind(vertices);
+
+    if (capacity_ == 0) {
+      return vao;
+    }
+    if (entries_.size() >= capacity_) {
+      evict();
+    }
+
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{vao, lru_.begin()});
+    return vao;
+  }
+
+  /// Drops every entry, that uses the buffer.
+  /** Must be called before deleting a buffer, that was given to get(). */
+  template <BufferType BUFFER_TYPE>
+  void invalidate(const BufferObject<BUFFER_TYPE>& buffer) {
+    GLuint handle = buffer.expose();
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+      if (iter->first.vertex_buffer == handle ||
+          iter->first.index_buffer == handle) {
+        lru_.erase(iter->second.lru_position);
+        iter = entries_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  /// Drops every entry.
+  void clear() {
+    entries_.clear();
+    lru_.clear();
+  }
+
+  /// Returns the number of cached VAOs.
+  size_t size() const { return entries_.size(); }
+
+  /// Returns the maximum number of cached VAOs.
+  size_t capacity() const { return capacity_; }
+
+  /// Changes the maximum number of cached VAOs, evicting if needed.
+  void setCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+      evict();
+    }
+  }
+
+  /// Returns the hit/miss/eviction counters.
+  const Statistics& statistics() const { return statistics_; }
+
+  /// Sets every counter to zero.
+  void resetStatistics() { statistics_ = Statistics{0, 0, 0}; }
+
+ private:
+  struct Key {
+    VertexFormat format;
+    GLuint vertex_buffer;
+    GLintptr base_offset;
+    GLuint index_buffer;
+
+    bool operator==(const Key& other) const {
+      return vertex_buffer == other.vertex_buffer &&
+             base_offset == other.base_offset &&
+             index_buffer == other.index_buffer &&
+             format == other.format;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t seed = key.format.hash();
+      seed ^= std::hash<GLuint>()(key.vertex_buffer) + 0x9e3779b9 +
+              (seed << 6) + (seed >> 2);
+      seed ^= std::hash<GLintptr>()(key.base_offset) + 0x9e3779b9 +
+              (seed << 6) + (seed >> 2);
+      seed ^= std::hash<GLuint>()(key.index_buffer) + 0x9e3779b9 +
+              (seed << 6) + (seed >> 2);
+      return seed;
+    }
+  };
+
+  struct Entry {
+    std::shared_ptr<VertexArray> vao;
+    std::list<Key>::iterator lru_position;
+  };
+
+  size_t capacity_;
+  Statistics statistics_;
+  std::list<Key> lru_;  // Most recently used first.
+  std::unordered_map<Key, Entry, KeyHash> entries_;
+
+  void evict() {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+    statistics_.evictions++;
+  }
+};
+#endif  // glGenVertexArrays && glBindVertexArray && glBindBuffer
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_VERTEX_ARRAY_CACHE_H_
@@ -242,6 +242,10 @@ class VertexAttribObject {
   /**
    * @brief Specify the organization of vertex arrays.
    *
+   * Unlike pointer(), this doesn't capture the currently bound ArrayBuffer,
+   * the buffer is specified separately for the binding point, that the
+   * attribute is associated with. See binding() and BindVertexBuffer().
+   *
    * @param values_per_vertex   The number of values per vertex that are stored
    *                            in the array.
    * @param type                The type of the data stored in the array.
@@ -249,28 +253,25 @@ class VertexAttribObject {
    *                            be normalized (GL_TRUE) or converted directly as
    *                            fixed-point values (GL_FALSE) when they are
    *                            accessed.
-   * @param stride              Specifies the byte offset between consecutive
-   *                            generic vertex attributes. If stride is 0, the
-   *                            generic vertex attributes are understood to be
-   *                            tightly packed in the array. The initial value
-   *                            is 0.
+   * @param relative_offset     The distance between elements within the
+   *                            buffer, ie. the offset of the attribute inside
+   *                            a vertex, in bytes.
    * @see glVertexAttribFormat
    */
   VertexAttribObject& format(GLuint values_per_vertex = 4,
                              DataType type = DataType::kFloat,
                              GLboolean normalized = false,
-                             GLsizei stride = 0) {
+                             GLuint relative_offset = 0) {
     if (!inited_) { init(); }
 
     OGLWRAP_CHECK_FOR_DEFAULT_BINDING_EXPLICIT(GL_VERTEX_ARRAY_BINDING);
     gl(VertexAttribFormat(location_, values_per_vertex, GLenum(type),
-                          normalized, stride));
+                          normalized, relative_offset));
     return *this;
   }
 #endif  // glVertexAttribFormat
 
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glVertexAttribIFormat)
-  ///
   /**
    * @brief Specify the organization of vertex arrays. Should be used for
    *        integer values.
@@ -278,20 +279,19 @@ class VertexAttribObject {
    * @param values_per_vertex   The number of values per vertex that are stored
    *                            in the array.
    * @param type                The type of the data stored in the array.
-   * @param stride              Specifies the byte offset between consecutive
-   *                            generic vertex attributes. If stride is 0, the
-   *                            generic vertex attributes are understood to be
-   *                            tightly packed in the array. The initial value
-   *                            is 0.
+   * @param relative_offset     The distance between elements within the
+   *                            buffer, ie. the offset of the attribute inside
+   *                            a vertex, in bytes.
    * @see glVertexAttribIFormat
    */
   VertexAttribObject& iformat(GLuint values_per_vertex = 4,
                               WholeDataType type = WholeDataType::kInt,
-                              GLsizei stride = 0) {
+                              GLuint relative_offset = 0) {
     if (!inited_) { init(); }
 
     OGLWRAP_CHECK_FOR_DEFAULT_BINDING_EXPLICIT(GL_VERTEX_ARRAY_BINDING);
-    gl(VertexAttribIFormat(location_, values_per_vertex, GLenum(type), stride));
+    gl(VertexAttribIFormat(location_, values_per_vertex, GLenum(type),
+                           relative_offset));
     return *this;
   }
 #endif  // glVertexAttribIFormat
@@ -303,23 +303,42 @@ class VertexAttribObject {
    *
    * @param values_per_vertex   The number of values per vertex that are stored
    *                            in the array.
-   * @param stride              Specifies the byte offset between consecutive
-   *                            generic vertex attributes. If stride is 0, the
-   *                            generic vertex attributes are understood to be
-   *                            tightly packed in the array. The initial value
-   *                            is 0.
+   * @param relative_offset     The distance between elements within the
+   *                            buffer, ie. the offset of the attribute inside
+   *                            a vertex, in bytes.
    * @see glVertexAttribLFormat
    */
   VertexAttribObject& lformat(GLuint values_per_vertex = 4,
-                              GLsizei stride = 0) {
+                              GLuint relative_offset = 0) {
     if (!inited_) { init(); }
 
     OGLWRAP_CHECK_FOR_DEFAULT_BINDING_EXPLICIT(GL_VERTEX_ARRAY_BINDING);
-    gl(VertexAttribLFormat(location_, values_per_vertex, GL_DOUBLE, stride));
+    gl(VertexAttribLFormat(location_, values_per_vertex, GL_DOUBLE,
+                           relative_offset));
     return *this;
   }
 #endif  // glVertexAttribLFormat
 
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glVertexAttribBinding)
+  /**
+   * @brief Associates the attribute with a vertex buffer binding point.
+   *
+   * The attribute will source its data from the buffer that is bound to
+   * the binding point with BindVertexBuffer(). So changing the buffer doesn't
+   * require setting up the attribute again.
+   *
+   * @param binding_index  The index of the vertex buffer binding point.
+   * @see glVertexAttribBinding
+   */
+  VertexAttribObject& binding(GLuint binding_index) {
+    if (!inited_) { init(); }
+
+    OGLWRAP_CHECK_FOR_DEFAULT_BINDING_EXPLICIT(GL_VERTEX_ARRAY_BINDING);
+    gl(VertexAttribBinding(location_, binding_index));
+    return *this;
+  }
+#endif  // glVertexAttribBinding
+
 #if OGLWRAP_DEFINE_EVERYTHING || defined(glEnableVertexAttribArray)
   /// Enables the attribute array slot
   /** @see glEnableVertexAttrib */
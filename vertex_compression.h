@@ -0,0 +1,481 @@
+// Copyright (c) Tamas Csala
+
+/** @file vertex_compression.h
+    @brief Implements converters, that compress float vertex attributes to
+           smaller formats, that the vertex fetcher can expand for free.
+*/
+
+#ifndef OGLWRAP_VERTEX_COMPRESSION_H_
+#define OGLWRAP_VERTEX_COMPRESSION_H_
+
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "./config.h"
+#include "./vertex_format.h"
+
+#if OGLWRAP_USE_F16C || OGLWRAP_USE_AVX2
+  #include <immintrin.h>
+#elif OGLWRAP_USE_SSE2
+  #include <emmintrin.h>
+#endif
+#if OGLWRAP_USE_NEON
+  #include <arm_neon.h>
+#endif
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/*
+ * Every converter has a SIMD and a scalar path, and they give bit exact
+ * results: the SIMD paths round to nearest even, and so do the scalar ones
+ * (with the default floating point rounding mode). The SIMD paths are selected
+ * at compile time, see OGLWRAP_USE_SSE2 and its friends in config.h.
+ */
+
+/// A vertex attribute with N half float components.
+/** Use CompressToHalfFloat to fill it. */
+template <GLint components>
+struct HalfFloat {
+  GLushort value[components];
+};
+
+template <GLint components>
+struct VertexAttribTraits<HalfFloat<components>> {
+  static constexpr GLint kComponents = components;
+  static constexpr DataType kType = DataType::kHalfFloat;
+  static constexpr bool kNormalized = false;
+  static constexpr VertexAttribKind kKind = VertexAttribKind::kFloat;
+};
+
+#if OGLWRAP_DEFINE_EVERYTHING || defined(GL_INT_2_10_10_10_REV)
+/// A normalized signed x, y, z (10 bits each) and w (2 bits) packed into 32 bits.
+/** Use CompressToSnorm1010102 to fill it. It's read as a vec4 in the shader. */
+struct PackedSnorm1010102 {
+  GLuint value;
+};
+
+template <>
+struct VertexAttribTraits<PackedSnorm1010102> {
+  static constexpr GLint kComponents = 4;
+  static constexpr DataType kType = DataType::kInt2101010Rev;
+  static constexpr bool kNormalized = true;
+  static constexpr VertexAttribKind kKind = VertexAttribKind::kFloat;
+};
+#endif  // GL_INT_2_10_10_10_REV
+
+/// An octahedral encoded unit vector, use CompressNormalsOctahedral to fill it.
+typedef Normalized<GLshort, 2> OctahedralNormal;
+
+/// A texture coordinate in the [0, 1] range with 16 bit precision.
+/** Use CompressToUnorm16 to fill it. */
+typedef Normalized<GLushort, 2> Unorm16TexCoord;
+
+/// Converts a float to half float, rounding to nearest even.
+/** Values too large for a half are converted to infinity, NaNs stay NaNs. */
+inline GLushort FloatToHalf(GLfloat value) {
+  GLuint f;
+  std::memcpy(&f, &value, sizeof(f));
+
+  const GLuint kF32Infinity = 255u << 23;
+  const GLuint kF16Max = (127u + 16u) << 23;
+  const GLuint kDenormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  GLuint sign = f & 0x80000000u;
+  f ^= sign;
+
+  GLushort result;
+  if (f >= kF16Max) {
+    result = (f > kF32Infinity) ? 0x7e00 : 0x7c00;
+  } else if (f < (113u << 23)) {
+    // The result is a denormal (or zero). Adding the magic number lets the
+    // FPU do the shifting and the rounding.
+    GLfloat magic, shifted;
+    std::memcpy(&magic, &kDenormMagic, sizeof(magic));
+    std::memcpy(&shifted, &f, sizeof(shifted));
+    shifted += magic;
+    std::memcpy(&f, &shifted, sizeof(f));
+    result = GLushort(f - kDenormMagic);
+  } else {
+    GLuint mantissa_odd = (f >> 13) & 1;
+    f += (GLuint(15 - 127) << 23) + 0xfff;  // rebias exponent and round
+    f += mantissa_odd;
+    result = GLushort(f >> 13);
+  }
+
+  return result | GLushort(sign >> 16);
+}
+
+/// Converts a half float to float (exactly).
+inline GLfloat HalfToFloat(GLushort value) {
+  const GLuint kShiftedExponent = 0x7c00u << 13;
+  GLuint f = (value & 0x7fffu) << 13;
+  GLuint exponent = f & kShiftedExponent;
+  f += GLuint(127 - 15) << 23;
+
+  GLfloat result;
+  if (exponent == kShiftedExponent) {  // Inf / NaN
+    f += GLuint(128 - 16) << 23;
+    std::memcpy(&result, &f, sizeof(result));
+  } else if (exponent == 0) {  // zero / denormal
+    f += 1u << 23;
+    std::memcpy(&result, &f, sizeof(result));
+    GLuint magic_bits = 113u << 23;
+    GLfloat magic;
+    std::memcpy(&magic, &magic_bits, sizeof(magic));
+    result -= magic;
+  } else {
+    std::memcpy(&result, &f, sizeof(result));
+  }
+
+  return (value & 0x8000u) ? -result : result;
+}
+
+#if OGLWRAP_USE_SSE2
+/// Converts four floats to half floats, the same way as FloatToHalf.
+inline __m128i FloatToHalfSSE2(__m128 value) {
+  const __m128i kSignMask = _mm_set1_epi32(0x80000000);
+  const __m128i kF32Infinity = _mm_set1_epi32(255 << 23);
+  const __m128i kF16MaxMinusOne = _mm_set1_epi32(((127 + 16) << 23) - 1);
+  const __m128i kDenormMagic =
+      _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  const __m128i kNormalMin = _mm_set1_epi32(113 << 23);
+  // The exponent rebias is negative, so it is shifted as unsigned.
+  const __m128i kRebias =
+      _mm_set1_epi32(int((GLuint(15 - 127) << 23) + 0xfff));
+  const __m128i kOne = _mm_set1_epi32(1);
+
+  __m128i f = _mm_castps_si128(value);
+  __m128i sign = _mm_and_si128(f, kSignMask);
+  f = _mm_xor_si128(f, sign);  // f is positive now, so signed compares work.
+
+  __m128i denormal = _mm_sub_epi32(
+      _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f),
+                                  _mm_castsi128_ps(kDenormMagic))),
+      kDenormMagic);
+
+  __m128i mantissa_odd = _mm_and_si128(_mm_srli_epi32(f, 13), kOne);
+  __m128i normal = _mm_add_epi32(_mm_add_epi32(f, kRebias), mantissa_odd);
+  normal = _mm_srli_epi32(normal, 13);
+
+  __m128i is_nan = _mm_cmpgt_epi32(f, kF32Infinity);
+  __m128i inf_or_nan = _mm_or_si128(
+      _mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+
+  __m128i is_small = _mm_cmplt_epi32(f, kNormalMin);
+  __m128i is_large = _mm_cmpgt_epi32(f, kF16MaxMinusOne);
+
+  __m128i result = _mm_or_si128(_mm_and_si128(is_small, denormal),
+                                _mm_andnot_si128(is_small, normal));
+  result = _mm_or_si128(_mm_and_si128(is_large, inf_or_nan),
+                        _mm_andnot_si128(is_large, result));
+  return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+}
+#endif  // OGLWRAP_USE_SSE2
+
+/**
+ * @brief Converts floats to half floats (GL_HALF_FLOAT), halving the size of
+ *        positions, normals or texture coordinates.
+ *
+ * Halves have 11 bits of precision, so they are usually good enough for
+ * normals, texture coordinates and the positions of small objects.
+ * @param src    The floats to convert.
+ * @param count  The number of floats (not vertices) to convert.
+ * @param dst    Where the halves should be written, it can be HalfFloat<N>
+ *               array reinterpreted as GLushort*.
+ */
+inline void CompressToHalfFloat(const GLfloat* src, size_t count, GLushort* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_F16C
+  for (; i + 8 <= count; i += 8) {
+    __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                     _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halves);
+  }
+#endif
+#if OGLWRAP_USE_SSE2
+  for (; i + 8 <= count; i += 8) {
+    __m128i lo = FloatToHalfSSE2(_mm_loadu_ps(src + i));
+    __m128i hi = FloatToHalfSSE2(_mm_loadu_ps(src + i + 4));
+    // Sign extend the low 16 bits, so the saturating pack won't change them.
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+#elif OGLWRAP_USE_NEON
+  for (; i + 4 <= count; i += 4) {
+    float16x4_t halves = vcvt_f16_f32(vld1q_f32(src + i));
+    vst1_u16(dst + i, vreinterpret_u16_f16(halves));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = FloatToHalf(src[i]);
+  }
+}
+
+/// Packs a normalized signed vector into the GL_INT_2_10_10_10_REV format.
+/** The components are clamped into [-1, 1]. */
+inline GLuint PackSnorm1010102(GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+  GLint xi = GLint(std::nearbyint(std::min(std::max(x, -1.0f), 1.0f) * 511.0f));
+  GLint yi = GLint(std::nearbyint(std::min(std::max(y, -1.0f), 1.0f) * 511.0f));
+  GLint zi = GLint(std::nearbyint(std::min(std::max(z, -1.0f), 1.0f) * 511.0f));
+  GLint wi = GLint(std::nearbyint(std::min(std::max(w, -1.0f), 1.0f)));
+  return (GLuint(xi) & 0x3ff) | ((GLuint(yi) & 0x3ff) << 10) |
+         ((GLuint(zi) & 0x3ff) << 20) | (GLuint(wi) << 30);
+}
+
+#if OGLWRAP_USE_SSE2
+/// Packs four vectors given as separate x, y, z and w registers.
+inline __m128i PackSnorm1010102SSE2(__m128 x, __m128 y, __m128 z, __m128 w) {
+  const __m128 kMin = _mm_set1_ps(-1.0f), kMax = _mm_set1_ps(1.0f);
+  const __m128 kScale = _mm_set1_ps(511.0f);
+  const __m128i kMask10 = _mm_set1_epi32(0x3ff);
+
+  __m128i xi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, kMin), kMax), kScale));
+  __m128i yi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, kMin), kMax), kScale));
+  __m128i zi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(z, kMin), kMax), kScale));
+  __m128i wi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(w, kMin), kMax));
+
+  __m128i result = _mm_and_si128(xi, kMask10);
+  result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(yi, kMask10), 10));
+  result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(zi, kMask10), 20));
+  return _mm_or_si128(result, _mm_slli_epi32(wi, 30));
+}
+#endif  // OGLWRAP_USE_SSE2
+
+#if OGLWRAP_USE_NEON
+/// Packs four vectors given as separate x, y, z and w registers.
+inline uint32x4_t PackSnorm1010102NEON(float32x4_t x, float32x4_t y,
+                                       float32x4_t z, float32x4_t w) {
+  const float32x4_t kMin = vdupq_n_f32(-1.0f), kMax = vdupq_n_f32(1.0f);
+  const uint32x4_t kMask10 = vdupq_n_u32(0x3ff);
+
+  uint32x4_t xi = vreinterpretq_u32_s32(vcvtnq_s32_f32(
+      vmulq_n_f32(vminq_f32(vmaxq_f32(x, kMin), kMax), 511.0f)));
+  uint32x4_t yi = vreinterpretq_u32_s32(vcvtnq_s32_f32(
+      vmulq_n_f32(vminq_f32(vmaxq_f32(y, kMin), kMax), 511.0f)));
+  uint32x4_t zi = vreinterpretq_u32_s32(vcvtnq_s32_f32(
+      vmulq_n_f32(vminq_f32(vmaxq_f32(z, kMin), kMax), 511.0f)));
+  uint32x4_t wi = vreinterpretq_u32_s32(vcvtnq_s32_f32(
+      vminq_f32(vmaxq_f32(w, kMin), kMax)));
+
+  uint32x4_t result = vandq_u32(xi, kMask10);
+  result = vorrq_u32(result, vshlq_n_u32(vandq_u32(yi, kMask10), 10));
+  result = vorrq_u32(result, vshlq_n_u32(vandq_u32(zi, kMask10), 20));
+  return vorrq_u32(result, vshlq_n_u32(wi, 30));
+}
+#endif  // OGLWRAP_USE_NEON
+
+/**
+ * @brief Packs normals (or tangents) into GL_INT_2_10_10_10_REV, a quarter of
+ *        the size of a vec3.
+ *
+ * Set the attribute up with VertexFormat::add<PackedSnorm1010102>(location),
+ * or with pointer(4, DataType::kInt2101010Rev, true, stride, offset).
+ * @param src    The vectors to convert, their components should be in [-1, 1].
+ * @param count  The number of vectors.
+ * @param dst    Where the packed vectors should be written.
+ * @param w      The fourth component (-1, 0 or 1), for ex. the handedness of
+ *               a tangent frame.
+ */
+inline void CompressToSnorm1010102(const glm::vec3* src, size_t count,
+                                   GLuint* dst, GLfloat w = 0.0f) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  __m128 w4 = _mm_set1_ps(w);
+  for (; i + 4 <= count; i += 4) {
+    const glm::vec3* v = src + i;
+    __m128 x = _mm_setr_ps(v[0].x, v[1].x, v[2].x, v[3].x);
+    __m128 y = _mm_setr_ps(v[0].y, v[1].y, v[2].y, v[3].y);
+    __m128 z = _mm_setr_ps(v[0].z, v[1].z, v[2].z, v[3].z);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     PackSnorm1010102SSE2(x, y, z, w4));
+  }
+#elif OGLWRAP_USE_NEON
+  float32x4_t w4 = vdupq_n_f32(w);
+  for (; i + 4 <= count; i += 4) {
+    float32x4x3_t v = vld3q_f32(&src[i].x);
+    vst1q_u32(dst + i, PackSnorm1010102NEON(v.val[0], v.val[1], v.val[2], w4));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = PackSnorm1010102(src[i].x, src[i].y, src[i].z, w);
+  }
+}
+
+/// Packs vec4s into GL_INT_2_10_10_10_REV.
+/** The w component only has 2 bits, it's rounded to -1, 0 or 1.
+  * @see CompressToSnorm1010102(const glm::vec3*, size_t, GLuint*, GLfloat) */
+inline void CompressToSnorm1010102(const glm::vec4* src, size_t count,
+                                   GLuint* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(&src[i].x);
+    __m128 y = _mm_loadu_ps(&src[i+1].x);
+    __m128 z = _mm_loadu_ps(&src[i+2].x);
+    __m128 w = _mm_loadu_ps(&src[i+3].x);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     PackSnorm1010102SSE2(x, y, z, w));
+  }
+#elif OGLWRAP_USE_NEON
+  for (; i + 4 <= count; i += 4) {
+    float32x4x4_t v = vld4q_f32(&src[i].x);
+    vst1q_u32(dst + i, PackSnorm1010102NEON(v.val[0], v.val[1],
+                                            v.val[2], v.val[3]));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = PackSnorm1010102(src[i].x, src[i].y, src[i].z, src[i].w);
+  }
+}
+
+/// Converts a float in [0, 1] to unorm16 (the input is clamped).
+inline GLushort PackUnorm16(GLfloat value) {
+  return GLushort(std::nearbyint(
+      std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+/**
+ * @brief Converts texture coordinates (or any other [0, 1] data) to 16 bit
+ *        unsigned normalized integers.
+ *
+ * Unlike halves, the precision is the same everywhere in the range, so this is
+ * the better choice for the UVs of large textures. Set the attribute up with
+ * VertexFormat::add<Unorm16TexCoord>(location), or with
+ * pointer(2, DataType::kUnsignedShort, true, stride, offset).
+ * @param src    The floats to convert.
+ * @param count  The number of floats (not vertices) to convert.
+ * @param dst    Where the result should be written.
+ */
+inline void CompressToUnorm16(const GLfloat* src, size_t count, GLushort* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  const __m128 kZero = _mm_setzero_ps(), kOne = _mm_set1_ps(1.0f);
+  const __m128 kScale = _mm_set1_ps(65535.0f);
+  const __m128i kBias32 = _mm_set1_epi32(32768);
+  const __m128i kBias16 = _mm_set1_epi16(-32768);
+  for (; i + 8 <= count; i += 8) {
+    __m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), kZero), kOne);
+    __m128 hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), kZero), kOne);
+    // SSE2 can only pack with signed saturation, so shift the range there
+    // and back.
+    __m128i lo_i = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(lo, kScale)), kBias32);
+    __m128i hi_i = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(hi, kScale)), kBias32);
+    __m128i packed = _mm_xor_si128(_mm_packs_epi32(lo_i, hi_i), kBias16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+  }
+#elif OGLWRAP_USE_NEON
+  const float32x4_t kZero = vdupq_n_f32(0.0f), kOne = vdupq_n_f32(1.0f);
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t lo = vminq_f32(vmaxq_f32(vld1q_f32(src + i), kZero), kOne);
+    float32x4_t hi = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), kZero), kOne);
+    uint16x4_t lo_i = vqmovn_u32(vcvtnq_u32_f32(vmulq_n_f32(lo, 65535.0f)));
+    uint16x4_t hi_i = vqmovn_u32(vcvtnq_u32_f32(vmulq_n_f32(hi, 65535.0f)));
+    vst1q_u16(dst + i, vcombine_u16(lo_i, hi_i));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = PackUnorm16(src[i]);
+  }
+}
+
+/// Converts a float in [-1, 1] to snorm16 (the input is clamped).
+inline GLshort PackSnorm16(GLfloat value) {
+  return GLshort(std::nearbyint(
+      std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+/// Octahedral encodes a single vector, see CompressNormalsOctahedral.
+inline void EncodeOctahedral(const glm::vec3& n, GLshort* dst) {
+  GLfloat l1_norm = std::max(std::abs(n.x) + std::abs(n.y) + std::abs(n.z),
+                             FLT_MIN);
+  GLfloat x = n.x / l1_norm, y = n.y / l1_norm;
+  if (n.z < 0.0f) {
+    GLfloat folded_x = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+    GLfloat folded_y = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+    x = folded_x;
+    y = folded_y;
+  }
+  dst[0] = PackSnorm16(x);
+  dst[1] = PackSnorm16(y);
+}
+
+/**
+ * @brief Encodes unit vectors into two 16 bit snorms with the octahedral
+ *        mapping (a quarter of the size of a vec3).
+ *
+ * The error is well under the precision of a 10_10_10_2 normal. Set the
+ * attribute up with VertexFormat::add<OctahedralNormal>(location), and decode
+ * it in the shader:
+ * @code
+ *   in vec2 oct;
+ *   vec3 DecodeOctahedral(vec2 e) {
+ *     vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+ *     float t = max(-n.z, 0.0);
+ *     n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+ *     return normalize(n);
+ *   }
+ * @endcode
+ * @param src    The vectors to encode (they don't need to be normalized).
+ * @param count  The number of vectors.
+ * @param dst    Two GLshorts per vector.
+ */
+inline void CompressNormalsOctahedral(const glm::vec3* src, size_t count,
+                                      GLshort* dst) {
+  size_t i = 0;
+#if OGLWRAP_USE_SSE2
+  const __m128 kSignMask = _mm_set1_ps(-0.0f);
+  const __m128 kOne = _mm_set1_ps(1.0f), kMinusOne = _mm_set1_ps(-1.0f);
+  const __m128 kMinNorm = _mm_set1_ps(FLT_MIN), kScale = _mm_set1_ps(32767.0f);
+  for (; i + 4 <= count; i += 4) {
+    const glm::vec3* v = src + i;
+    __m128 x = _mm_setr_ps(v[0].x, v[1].x, v[2].x, v[3].x);
+    __m128 y = _mm_setr_ps(v[0].y, v[1].y, v[2].y, v[3].y);
+    __m128 z = _mm_setr_ps(v[0].z, v[1].z, v[2].z, v[3].z);
+
+    __m128 abs_x = _mm_andnot_ps(kSignMask, x);
+    __m128 abs_y = _mm_andnot_ps(kSignMask, y);
+    __m128 abs_z = _mm_andnot_ps(kSignMask, z);
+    __m128 l1_norm = _mm_max_ps(_mm_add_ps(_mm_add_ps(abs_x, abs_y), abs_z),
+                                kMinNorm);
+    x = _mm_div_ps(x, l1_norm);
+    y = _mm_div_ps(y, l1_norm);
+    abs_x = _mm_andnot_ps(kSignMask, x);
+    abs_y = _mm_andnot_ps(kSignMask, y);
+
+    // (1 - |y|) * copysign(1, x), the sign is just or-ed in.
+    __m128 folded_x = _mm_or_ps(_mm_sub_ps(kOne, abs_y), _mm_and_ps(x, kSignMask));
+    __m128 folded_y = _mm_or_ps(_mm_sub_ps(kOne, abs_x), _mm_and_ps(y, kSignMask));
+    __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+    x = _mm_or_ps(_mm_and_ps(lower, folded_x), _mm_andnot_ps(lower, x));
+    y = _mm_or_ps(_mm_and_ps(lower, folded_y), _mm_andnot_ps(lower, y));
+
+    __m128i xi = _mm_cvtps_epi32(
+        _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, kMinusOne), kOne), kScale));
+    __m128i yi = _mm_cvtps_epi32(
+        _mm_mul_ps(_mm_min_ps(_mm_max_ps(y, kMinusOne), kOne), kScale));
+    __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(xi, yi),
+                                     _mm_unpackhi_epi32(xi, yi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2*i), packed);
+  }
+#endif
+  for (; i < count; ++i) {
+    EncodeOctahedral(src[i], dst + 2*i);
+  }
+}
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_VERTEX_COMPRESSION_H_
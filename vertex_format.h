@@ -0,0 +1,368 @@
+// Copyright (c) Tamas Csala
+
+/** @file vertex_format.h
+    @brief Implements vertex format descriptors, that set up every attribute
+           of an (interleaved) vertex at once.
+*/
+
+#ifndef OGLWRAP_VERTEX_FORMAT_H_
+#define OGLWRAP_VERTEX_FORMAT_H_
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "./config.h"
+#include "./vertex_attrib.h"
+
+#include "enums/data_type.h"
+#include "enums/whole_data_type.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/// Describes how the shader will see an attribute.
+enum class VertexAttribKind {
+  kFloat,    ///< Read with glVertexAttribPointer (converted to float).
+  kInteger,  ///< Read with glVertexAttribIPointer.
+  kDouble    ///< Read with glVertexAttribLPointer.
+};
+
+template <typename GLtype>
+/// Compile time information about a type that can be used as an attribute.
+/** The specializations follow the rules of VertexAttribObject::setup<GLtype>,
+  * so integers and doubles won't be converted to floats. */
+struct VertexAttribTraits {
+  static_assert((sizeof(GLtype), false),
+      "Unrecognized OpenGL type for VertexAttribTraits");
+};
+
+#define OGLWRAP_VERTEX_ATTRIB_TRAITS(GLtype, components, data_type, kind)  \
+  template <>                                                              \
+  struct VertexAttribTraits<GLtype> {                                      \
+    static constexpr GLint kComponents = components;                      \
+    static constexpr DataType kType = DataType::data_type;                 \
+    static constexpr bool kNormalized = false;                             \
+    static constexpr VertexAttribKind kKind = VertexAttribKind::kind;      \
+  };
+
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLfloat, 1, kFloat, kFloat)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::vec2, 2, kFloat, kFloat)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::vec3, 3, kFloat, kFloat)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::vec4, 4, kFloat, kFloat)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLdouble, 1, kDouble, kDouble)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::dvec2, 2, kDouble, kDouble)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::dvec3, 3, kDouble, kDouble)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::dvec4, 4, kDouble, kDouble)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLbyte, 1, kByte, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLubyte, 1, kUnsignedByte, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLshort, 1, kShort, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLushort, 1, kUnsignedShort, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLint, 1, kInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(GLuint, 1, kUnsignedInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::ivec2, 2, kInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::ivec3, 3, kInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::ivec4, 4, kInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::uvec2, 2, kUnsignedInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::uvec3, 3, kUnsignedInt, kInteger)
+OGLWRAP_VERTEX_ATTRIB_TRAITS(glm::uvec4, 4, kUnsignedInt, kInteger)
+
+#undef OGLWRAP_VERTEX_ATTRIB_TRAITS
+
+template <typename GLtype, GLint components = 1>
+/// Marks integer data, that should be normalized into the [0, 1] or [-1, 1]
+/// range, and read as float in the shader.
+/** For ex. Normalized<GLubyte, 4> is an RGBA8 color. */
+struct Normalized {
+  GLtype value[components];
+};
+
+template <typename GLtype, GLint components>
+struct VertexAttribTraits<Normalized<GLtype, components>> {
+  static_assert(VertexAttribTraits<GLtype>::kKind == VertexAttribKind::kInteger,
+                "Only integer types can be normalized");
+  static constexpr GLint kComponents = components;
+  static constexpr DataType kType = VertexAttribTraits<GLtype>::kType;
+  static constexpr bool kNormalized = true;
+  static constexpr VertexAttribKind kKind = VertexAttribKind::kFloat;
+};
+
+/// The description of a single attribute inside a vertex format.
+struct VertexAttribDescription {
+  GLuint location;
+  GLint components;
+  DataType type;
+  bool normalized;
+  VertexAttribKind kind;
+  GLuint offset;  // relative to the start of the vertex, in bytes.
+};
+
+/**
+ * @brief Describes the memory layout of a vertex, and can set up all of its
+ *        attributes with a single call.
+ *
+ * The offsets and the stride are computed from the attribute types, so they
+ * don't have to be calculated by hand. The attributes are interleaved, which
+ * is the cache friendly layout for the vertex fetcher.
+ * @code
+ *   struct Vertex { glm::vec3 pos; glm::vec3 normal; glm::vec2 uv; };
+ *
+ *   VertexFormat format;
+ *   format.add(0, &Vertex::pos).add(1, &Vertex::normal).add(2, &Vertex::uv);
+ *   // or equivalently: format.add<glm::vec3>(0).add<glm::vec3>(1).add<glm::vec2>(2);
+ *
+ *   gl::Bind(vao);
+ *   gl::Bind(buffer);
+ *   format.setup();
+ * @endcode
+ */
+class VertexFormat {
+ public:
+  VertexFormat() : stride_(0) {}
+
+  template <typename GLtype>
+  /// Appends an attribute of type GLtype after the last attribute.
+  /** @param location  The attribute slot used by the shader. */
+  VertexFormat& add(GLuint location) {
+    typedef VertexAttribTraits<GLtype> Traits;
+    return add(location, Traits::kComponents, Traits::kType,
+               Traits::kNormalized, Traits::kKind, stride_, sizeof(GLtype));
+  }
+
+  template <typename Vertex, typename GLtype>
+  /// Adds an attribute, that is a member of a vertex struct.
+  /** The stride becomes (at least) sizeof(Vertex).
+    * @param location  The attribute slot used by the shader.
+    * @param member    The member of the vertex struct that holds the data. */
+  VertexFormat& add(GLuint location, GLtype Vertex::*member) {
+    typedef VertexAttribTraits<GLtype> Traits;
+    add(location, Traits::kComponents, Traits::kType, Traits::kNormalized,
+        Traits::kKind, MemberOffset(member), sizeof(GLtype));
+    if (stride_ < sizeof(Vertex)) {
+      stride_ = sizeof(Vertex);
+    }
+    return *this;
+  }
+
+  /// Adds an attribute with explicitly specified format.
+  /** @param location     The attribute slot used by the shader.
+    * @param components   The number of components of the attribute.
+    * @param type         The data type of each component.
+    * @param normalized   Whether integer data should be normalized.
+    * @param kind         How the shader reads the attribute.
+    * @param offset       The offset of the attribute inside the vertex.
+    * @param size         The size of the attribute in bytes. */
+  VertexFormat& add(GLuint location, GLint components, DataType type,
+                    bool normalized, VertexAttribKind kind,
+                    GLuint offset, GLuint size) {
+    attribs_.push_back(VertexAttribDescription{
+      location, components, type, normalized, kind, offset});
+    if (stride_ < offset + size) {
+      stride_ = offset + size;
+    }
+    return *this;
+  }
+
+  /// Leaves a gap of the given size (in bytes) after the last attribute.
+  VertexFormat& skip(GLuint bytes) {
+    stride_ += bytes;
+    return *this;
+  }
+
+  /// Returns the byte distance between two consecutive vertices.
+  GLsizei stride() const { return GLsizei(stride_); }
+
+  /// Returns the descriptions of the attributes, in the order of addition.
+  const std::vector<VertexAttribDescription>& attribs() const {
+    return attribs_;
+  }
+
+  /// Returns a hash of the layout (including the attribute locations).
+  size_t hash() const {
+    size_t seed = std::hash<GLuint>()(stride_);
+    for (const VertexAttribDescription& attrib : attribs_) {
+      HashCombine(&seed, attrib.location);
+      HashCombine(&seed, attrib.components);
+      HashCombine(&seed, GLenum(attrib.type));
+      HashCombine(&seed, attrib.normalized);
+      HashCombine(&seed, static_cast<int>(attrib.kind));
+      HashCombine(&seed, attrib.offset);
+    }
+    return seed;
+  }
+
+  bool operator==(const VertexFormat& other) const {
+    if (stride_ != other.stride_ || attribs_.size() != other.attribs_.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < attribs_.size(); ++i) {
+      const VertexAttribDescription& a = attribs_[i];
+      const VertexAttribDescription& b = other.attribs_[i];
+      if (a.location != b.location || a.components != b.components ||
+          a.type != b.type || a.normalized != b.normalized ||
+          a.kind != b.kind || a.offset != b.offset) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=(const VertexFormat& other) const {
+    return !(*this == other);
+  }
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glVertexAttribPointer) && defined(glVertexAttribIPointer) \
+        && defined(glEnableVertexAttribArray))
+  /**
+   * @brief Sets up and enables every attribute of the format, using the
+   *        currently bound ArrayBuffer.
+   *
+   * @param base_offset  The offset of the first vertex in the buffer in bytes.
+   * @see glVertexAttribPointer, glVertexAttribIPointer, glVertexAttribLPointer,
+   *      glEnableVertexAttribArray
+   */
+  void setup(GLintptr base_offset = 0) const {
+    for (const VertexAttribDescription& attrib : attribs_) {
+      const void *offset_pointer =
+          reinterpret_cast<const void*>(base_offset + attrib.offset);
+      VertexAttribObject attrib_object(attrib.location);
+      switch (attrib.kind) {
+        case VertexAttribKind::kFloat:
+          attrib_object.pointer(attrib.components, attrib.type,
+                                attrib.normalized, stride(), offset_pointer);
+          break;
+        case VertexAttribKind::kInteger:
+          attrib_object.ipointer(attrib.components, WholeDataType(attrib.type),
+                                 stride(), offset_pointer);
+          break;
+        case VertexAttribKind::kDouble:
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glVertexAttribLPointer)
+          attrib_object.lpointer(attrib.components, stride(), offset_pointer);
+#else
+          throw std::runtime_error("VertexFormat::setup() is called with a "
+            "double attribute, but the glVertexAttribLPointer symbol is missing.");
+#endif  // glVertexAttribLPointer
+          break;
+      }
+      attrib_object.enable();
+    }
+  }
+#endif  // glVertexAttribPointer && glVertexAttribIPointer
+
+#if OGLWRAP_DEFINE_EVERYTHING \
+    || (defined(glVertexAttribFormat) && defined(glVertexAttribIFormat) \
+        && defined(glVertexAttribBinding) && defined(glEnableVertexAttribArray))
+  /**
+   * @brief Specifies the format of every attribute, and associates them with
+   *        a vertex buffer binding point, without capturing any buffer.
+   *
+   * This has to be done only once per VAO. The buffers can be changed later
+   * by calling BindVertexBuffer(binding_index, buffer, offset, stride()),
+   * so a single VAO can be reused for every mesh that has this format.
+   * @param binding_index  The vertex buffer binding point to use.
+   * @see glVertexAttribFormat, glVertexAttribIFormat, glVertexAttribLFormat,
+   *      glVertexAttribBinding, glEnableVertexAttribArray
+   */
+  void setupFormat(GLuint binding_index = 0) const {
+    for (const VertexAttribDescription& attrib : attribs_) {
+      VertexAttribObject attrib_object(attrib.location);
+      switch (attrib.kind) {
+        case VertexAttribKind::kFloat:
+          attrib_object.format(attrib.components, attrib.type,
+                               attrib.normalized, attrib.offset);
+          break;
+        case VertexAttribKind::kInteger:
+          attrib_object.iformat(attrib.components, WholeDataType(attrib.type),
+                                attrib.offset);
+          break;
+        case VertexAttribKind::kDouble:
+#if OGLWRAP_DEFINE_EVERYTHING || defined(glVertexAttribLFormat)
+          attrib_object.lformat(attrib.components, attrib.offset);
+#else
+          throw std::runtime_error("VertexFormat::setupFormat() is called with "
+            "a double attribute, but the glVertexAttribLFormat symbol is "
+            "missing.");
+#endif  // glVertexAttribLFormat
+          break;
+      }
+      attrib_object.binding(binding_index).enable();
+    }
+  }
+#endif  // glVertexAttribFormat && glVertexAttribBinding
+
+ private:
+  std::vector<VertexAttribDescription> attribs_;
+  GLuint stride_;
+
+  template <typename T>
+  static void HashCombine(size_t *seed, const T& value) {
+    *seed ^= std::hash<T>()(value) + 0x9e3779b9 + (*seed << 6) + (*seed >> 2);
+  }
+
+  template <typename Vertex, typename GLtype>
+  static GLuint MemberOffset(GLtype Vertex::*member) {
+    // Like offsetof, but works with member pointers.
+    alignas(Vertex) char storage[sizeof(Vertex)];
+    const Vertex *vertex = reinterpret_cast<const Vertex*>(storage);
+    return reinterpret_cast<const char*>(&(vertex->*member)) - storage;
+  }
+};
+
+template <typename... Attribs>
+/**
+ * @brief A vertex format that is fully known at compile time.
+ *
+ * The attributes are tightly packed in the order of the template arguments,
+ * and use consecutive attribute locations.
+ * @code
+ *   using Format = gl::PackedVertexFormat<glm::vec3, glm::vec3, glm::vec2>;
+ *   static_assert(Format::kStride == 32, "");
+ *   Format::Get().setup();
+ * @endcode
+ */
+struct PackedVertexFormat;
+
+template <>
+struct PackedVertexFormat<> {
+  static constexpr GLsizei kStride = 0;
+  static constexpr size_t kAttribNum = 0;
+
+  static VertexFormat Get(GLuint = 0) {
+    return VertexFormat{};
+  }
+
+  static void Append(VertexFormat*, GLuint) {}
+};
+
+template <typename First, typename... Rest>
+struct PackedVertexFormat<First, Rest...> {
+  static constexpr GLsizei kStride =
+      sizeof(First) + PackedVertexFormat<Rest...>::kStride;
+  static constexpr size_t kAttribNum = 1 + sizeof...(Rest);
+
+  /// Creates the runtime description of the format.
+  /** @param first_location  The location of the first attribute, the others
+    *                        get the ones after it. */
+  static VertexFormat Get(GLuint first_location = 0) {
+    VertexFormat format;
+    Append(&format, first_location);
+    return format;
+  }
+
+  static void Append(VertexFormat* format, GLuint location) {
+    format->add<First>(location);
+    PackedVertexFormat<Rest...>::Append(format, location + 1);
+  }
+};
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_VERTEX_FORMAT_H_
@@ -0,0 +1,53 @@
+// Copyright (c) Tamas Csala
+
+/** @file word_key.h
+    @brief Implements hashing and comparing the structs, that are made of 32
+           bit fields, and are used as cache keys.
+*/
+
+#ifndef OGLWRAP_WORD_KEY_H_
+#define OGLWRAP_WORD_KEY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "./config.h"
+
+#include "./define_internal_macros.h"
+
+namespace OGLWRAP_NAMESPACE_NAME {
+
+/// Hashes a struct of 32 bit fields (like SamplerDescriptor or
+/// PipelineState::Values) with FNV-1a over the words instead of the bytes.
+/** The struct must not have padding, as the padding bytes are hashed too. */
+template <typename Key>
+inline size_t HashWords(const Key& key) {
+  static_assert(sizeof(Key) % sizeof(uint32_t) == 0,
+                "The key must consist of 32 bit fields");
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(Key); i += sizeof(uint32_t)) {
+    uint32_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  // Folds the high bits in, for 32 bit size_t.
+  return size_t(hash ^ (hash >> 32));
+}
+
+/// Returns if two structs of 32 bit fields are bitwise equal.
+/** Unlike operator== on the floats, 0.0f and -0.0f differ, and a NaN equals
+  * itself, which is what a cache key needs. */
+template <typename Key>
+inline bool EqualWords(const Key& lhs, const Key& rhs) {
+  static_assert(sizeof(Key) % sizeof(uint32_t) == 0,
+                "The key must consist of 32 bit fields");
+  return std::memcmp(&lhs, &rhs, sizeof(Key)) == 0;
+}
+
+}  // namespace oglwrap
+
+#include "./undefine_internal_macros.h"
+
+#endif  // OGLWRAP_WORD_KEY_H_